@@ -2,6 +2,22 @@
 
 #include <QString>
 
+/**
+ * @brief Lowest level compiled into MPF_LOG_* statements
+ *
+ * 0 = Trace, 1 = Debug, 2 = Info, 3 = Warning, 4 = Error. Statements below
+ * it are removed at compile time, arguments included. Defaults to Info for
+ * NDEBUG (release) builds and Trace otherwise; override with
+ * -DMPF_LOG_MIN_LEVEL=<n>.
+ */
+#ifndef MPF_LOG_MIN_LEVEL
+#  ifdef NDEBUG
+#    define MPF_LOG_MIN_LEVEL 2
+#  else
+#    define MPF_LOG_MIN_LEVEL 0
+#  endif
+#endif
+
 namespace mpf {
 
 /**
@@ -37,6 +53,88 @@ public:
      */
     virtual Level minLevel() const = 0;
 
+    /**
+     * @brief Check a level for a tag interned with tagId()
+     *
+     * Loggers with per-tag thresholds override this; a tagId of -1 means
+     * the global level.
+     */
+    virtual bool isEnabled(Level level, int tagId) const
+    {
+        Q_UNUSED(tagId);
+        return level >= minLevel();
+    }
+
+    /**
+     * @brief Lowest level enabled for any tag; a cheap first check
+     */
+    virtual Level lowestLevel() const { return minLevel(); }
+
+    /**
+     * @brief Identifies the structured output's site IDs
+     * @return 0 without structured output, otherwise a value below 2^48
+     *         that stays the same for as long as site IDs from
+     *         structuredSite() are valid (never shared with another logger)
+     */
+    virtual quint64 structuredEpoch() const { return 0; }
+
+    /**
+     * @brief Register a structured log call site (see mpf/structured_log.h)
+     * @param tag, format String literals; must stay valid for the process lifetime
+     * @param signature One type code per argument
+     * @return Site ID (at most 0xFFFF) for logStructured(), or 0 if the
+     *         logger has no structured output (the caller then logs
+     *         formatted text)
+     */
+    virtual quint32 structuredSite(Level level, const char* tag, const char* format,
+                                   const char* signature)
+    {
+        Q_UNUSED(level);
+        Q_UNUSED(tag);
+        Q_UNUSED(format);
+        Q_UNUSED(signature);
+        return 0;
+    }
+
+    /**
+     * @brief Record the encoded arguments of a structured log call
+     * @return false if there was no structured output to record them in
+     *         (the caller then logs formatted text)
+     */
+    virtual bool logStructured(quint32 siteId, const char* payload, qsizetype size)
+    {
+        Q_UNUSED(siteId);
+        Q_UNUSED(payload);
+        Q_UNUSED(size);
+        return false;
+    }
+
+    /**
+     * @brief Intern a tag in the logger's table
+     *
+     * IDs index the logger's own per-tag levels, so they must come from the
+     * logger: plugins have no table of their own. MPF_LOG_* call this once
+     * per call site and cache the result.
+     * @return ID for isEnabled() and logTagged(); -1 means the global level
+     */
+    virtual int tagId(const QString& tag)
+    {
+        Q_UNUSED(tag);
+        return -1;
+    }
+
+    /**
+     * @brief log() for a tag already interned with tagId()
+     *
+     * Spares the logger looking the tag up again. Not an overload of
+     * log(), so existing vtable slots keep their positions on every ABI.
+     */
+    virtual void logTagged(Level level, int tagId, const QString& tag, const QString& message)
+    {
+        Q_UNUSED(tagId);
+        log(level, tag, message);
+    }
+
     // Convenience methods
     void trace(const QString& tag, const QString& msg) { log(Level::Trace, tag, msg); }
     void debug(const QString& tag, const QString& msg) { log(Level::Debug, tag, msg); }
@@ -44,7 +142,7 @@ public:
     void warning(const QString& tag, const QString& msg) { log(Level::Warning, tag, msg); }
     void error(const QString& tag, const QString& msg) { log(Level::Error, tag, msg); }
 
-    static constexpr int apiVersion() { return 1; }
+    static constexpr int apiVersion() { return 3; }
 };
 
 } // namespace mpf
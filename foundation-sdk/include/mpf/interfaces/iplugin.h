@@ -1,6 +1,9 @@
 #pragma once
 
+#include <mpf/logger_access.h>
 #include <QtPlugin>
+#include <QFuture>
+#include <QPromise>
 #include <QString>
 #include <QJsonObject>
 
@@ -54,9 +57,43 @@ public:
      * @return Path like "qrc:/YourCo/Orders/Main.qml" or empty string
      */
     virtual QString entryQml() const { return QString(); }
+
+    /**
+     * @brief Start without blocking the host
+     *
+     * Only called for plugins whose metadata sets "asyncStart": true, in
+     * place of start(). Called on the main thread; return quickly and finish
+     * slow work (I/O, network) elsewhere. The host shows its UI meanwhile
+     * and starts dependents once the future reports true.
+     *
+     * @return Future resolving to whether startup succeeded
+     */
+    virtual QFuture<bool> startAsync()
+    {
+        QPromise<bool> promise;
+        promise.start();
+        promise.addResult(start());
+        promise.finish();
+        return promise.future();
+    }
+
+    /**
+     * @brief Share the host's logger with this plugin's library
+     *
+     * Called by the host right after loading, before initialize(). Being
+     * inline, this body is compiled into the plugin and attaches the
+     * plugin's own copy of LoggerAccess to the host's. Do not override.
+     */
+    virtual void attachLogger(LoggerAccess::Shared* shared)
+    {
+        LoggerAccess::attach(shared);
+    }
 };
 
 } // namespace mpf
 
-#define MPF_IPlugin_iid "com.mpf.IPlugin/1.0"
+// Bumped whenever the vtable changes (1.1: startAsync(), 1.2: attachLogger()),
+// so plugins built against an older SDK fail qobject_cast instead of calling
+// past its end
+#define MPF_IPlugin_iid "com.mpf.IPlugin/1.2"
 Q_DECLARE_INTERFACE(mpf::IPlugin, MPF_IPlugin_iid)
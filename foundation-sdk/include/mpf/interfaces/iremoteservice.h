@@ -0,0 +1,54 @@
+#pragma once
+
+#include <QFuture>
+#include <QString>
+#include <QVariant>
+#include <QVariantList>
+
+namespace mpf {
+
+/**
+ * @brief Service provided by a plugin running in its own process
+ *
+ * Plugins with "outOfProcess": true in their metadata run in a separate
+ * mpf-plugin-host process. Their services cannot be handed out as C++
+ * pointers; the host registers one IRemoteService per name listed in
+ * "provides" instead. Obtain it with ServiceRegistry::remote().
+ *
+ * Calls are dispatched by name to the service's Q_INVOKABLE methods or
+ * slots. Arguments and results must be streamable QVariants (numbers,
+ * strings, QVariantMap/QVariantList, QByteArray, ...).
+ */
+class IRemoteService
+{
+public:
+    virtual ~IRemoteService() = default;
+
+    /**
+     * @brief Service name as listed in the provider's "provides"
+     */
+    virtual QString serviceName() const = 0;
+
+    /**
+     * @brief Call a method and receive its result
+     * @param method Name of an invokable method or slot of the service
+     * @param args Arguments, converted to the declared parameter types
+     * @return Future with the return value; canceled if the call fails or
+     *         the provider process exits
+     */
+    virtual QFuture<QVariant> call(const QString& method, const QVariantList& args = {}) = 0;
+
+    /**
+     * @brief Call a method without waiting for a reply
+     */
+    virtual void post(const QString& method, const QVariantList& args = {}) = 0;
+
+    /**
+     * @brief Check whether the provider process is running
+     */
+    virtual bool isConnected() const = 0;
+
+    static constexpr int apiVersion() { return 1; }
+};
+
+} // namespace mpf
@@ -0,0 +1,155 @@
+#pragma once
+
+#include <mpf/logger_access.h>
+#include <QString>
+#include <atomic>
+#include <chrono>
+
+/**
+ * @file log_limit.h
+ * @brief Rate-limited and sampled logging macros
+ *
+ * For statements that can fire in a tight loop, e.g. a failing poll:
+ *
+ * @code
+ * MPF_LOG_WARNING_RATE("Http", 5, "Poll failed: " + error);    // <= 5 per second
+ * MPF_LOG_DEBUG_SAMPLED("Orders", 100, "Tick " + QString::number(n));  // 1 in 100
+ * @endcode
+ *
+ * Each call site keeps its own counters in a static, updated with relaxed
+ * atomics only. msg is not evaluated for suppressed calls. Once suppressed
+ * calls have piled up, the next admitted call first logs
+ * "N similar message(s) suppressed", at most once per SummaryIntervalMs, so
+ * a busy site reports periodically without any shared registry (plugins
+ * can be unloaded, so nothing may point at their statics).
+ *
+ * The macros forward to MPF_LOG_*: include this after mpf/logger.h in
+ * plugins (or the host's logger.h in the host). The limit must be the
+ * same every time the statement runs.
+ */
+
+namespace mpf {
+
+/**
+ * @brief Per-call-site state of one rate-limited or sampled statement
+ */
+class LogLimiter
+{
+public:
+    enum class Mode {
+        Rate,    // At most limit calls per second
+        Sample   // Every limit-th call, starting with the first
+    };
+
+    static constexpr qint64 Suppressed = -1;
+    static constexpr qint64 SummaryIntervalMs = 10000;
+
+    constexpr LogLimiter(Mode mode, int limit)
+        : m_mode(mode)
+        , m_limit(limit > 0 ? limit : 1)
+    {
+    }
+
+    /**
+     * @brief Count a call
+     * @return Suppressed to skip it, otherwise the number of calls
+     *         suppressed since the last summary if one is due now (else 0)
+     */
+    qint64 admit()
+    {
+        if (m_mode == Mode::Sample) {
+            if (m_calls.fetch_add(1, std::memory_order_relaxed) % quint64(m_limit) != 0) {
+                m_suppressed.fetch_add(1, std::memory_order_relaxed);
+                return Suppressed;
+            }
+            return takeSummary(nowMs());
+        }
+
+        // Concurrent window resets race benignly: the limit is approximate
+        // for the one window in which they happen
+        const qint64 now = nowMs();
+        qint64 start = m_windowStart.load(std::memory_order_relaxed);
+        if (now - start >= 1000
+            && m_windowStart.compare_exchange_strong(start, now, std::memory_order_relaxed)) {
+            m_calls.store(0, std::memory_order_relaxed);
+        }
+        if (m_calls.fetch_add(1, std::memory_order_relaxed) >= quint64(m_limit)) {
+            m_suppressed.fetch_add(1, std::memory_order_relaxed);
+            return Suppressed;
+        }
+        return takeSummary(now);
+    }
+
+    static QString summary(qint64 suppressed)
+    {
+        return QString("%1 similar message(s) suppressed").arg(suppressed);
+    }
+
+private:
+    static qint64 nowMs()
+    {
+        return std::chrono::duration_cast<std::chrono::milliseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+
+    qint64 takeSummary(qint64 now)
+    {
+        if (m_suppressed.load(std::memory_order_relaxed) == 0) {
+            return 0;
+        }
+        qint64 last = m_lastSummary.load(std::memory_order_relaxed);
+        if (last != 0 && now - last < SummaryIntervalMs) {
+            return 0;
+        }
+        if (!m_lastSummary.compare_exchange_strong(last, now, std::memory_order_relaxed)) {
+            return 0;  // Another thread reports it
+        }
+        return qint64(m_suppressed.exchange(0, std::memory_order_relaxed));
+    }
+
+    const Mode m_mode;
+    const int m_limit;
+    std::atomic<quint64> m_calls{0};       // In this window (Rate) or in total (Sample)
+    std::atomic<qint64> m_windowStart{0};  // Rate only
+    std::atomic<quint64> m_suppressed{0};  // Since the last summary
+    std::atomic<qint64> m_lastSummary{0};
+};
+
+} // namespace mpf
+
+// The level checks, per tag as in MPF_LOG_*, keep disabled statements from
+// touching the counters, so they never show up as suppressed
+#define MPF_LOG_LIMITED_IMPL_(level, log, mode, limit, tag, msg) \
+    do { \
+        if constexpr (int(mpf::ILogger::Level::level) >= MPF_LOG_MIN_LEVEL) { \
+            if (mpf::LoggerAccess::isEnabled(mpf::ILogger::Level::level)) { \
+                bool _mpf_enabled = true; \
+                if (auto* _mpf_l = mpf::LoggerAccess::instance()) { \
+                    static const int _mpf_tag = _mpf_l->tagId(QStringLiteral("" tag "")); \
+                    _mpf_enabled = _mpf_l->isEnabled(mpf::ILogger::Level::level, _mpf_tag); \
+                } \
+                if (_mpf_enabled) { \
+                    static mpf::LogLimiter _mpf_limiter(mpf::LogLimiter::Mode::mode, limit); \
+                    const qint64 _mpf_skipped = _mpf_limiter.admit(); \
+                    if (_mpf_skipped != mpf::LogLimiter::Suppressed) { \
+                        if (_mpf_skipped > 0) log(tag, mpf::LogLimiter::summary(_mpf_skipped)); \
+                        log(tag, msg); \
+                    } \
+                } \
+            } \
+        } \
+    } while (0)
+
+// At most perSecond messages per second from this statement
+#define MPF_LOG_TRACE_RATE(tag, perSecond, msg)   MPF_LOG_LIMITED_IMPL_(Trace, MPF_LOG_TRACE, Rate, perSecond, tag, msg)
+#define MPF_LOG_DEBUG_RATE(tag, perSecond, msg)   MPF_LOG_LIMITED_IMPL_(Debug, MPF_LOG_DEBUG, Rate, perSecond, tag, msg)
+#define MPF_LOG_INFO_RATE(tag, perSecond, msg)    MPF_LOG_LIMITED_IMPL_(Info, MPF_LOG_INFO, Rate, perSecond, tag, msg)
+#define MPF_LOG_WARNING_RATE(tag, perSecond, msg) MPF_LOG_LIMITED_IMPL_(Warning, MPF_LOG_WARNING, Rate, perSecond, tag, msg)
+#define MPF_LOG_ERROR_RATE(tag, perSecond, msg)   MPF_LOG_LIMITED_IMPL_(Error, MPF_LOG_ERROR, Rate, perSecond, tag, msg)
+
+// One message in every k from this statement, starting with the first
+#define MPF_LOG_TRACE_SAMPLED(tag, k, msg)   MPF_LOG_LIMITED_IMPL_(Trace, MPF_LOG_TRACE, Sample, k, tag, msg)
+#define MPF_LOG_DEBUG_SAMPLED(tag, k, msg)   MPF_LOG_LIMITED_IMPL_(Debug, MPF_LOG_DEBUG, Sample, k, tag, msg)
+#define MPF_LOG_INFO_SAMPLED(tag, k, msg)    MPF_LOG_LIMITED_IMPL_(Info, MPF_LOG_INFO, Sample, k, tag, msg)
+#define MPF_LOG_WARNING_SAMPLED(tag, k, msg) MPF_LOG_LIMITED_IMPL_(Warning, MPF_LOG_WARNING, Sample, k, tag, msg)
+#define MPF_LOG_ERROR_SAMPLED(tag, k, msg)   MPF_LOG_LIMITED_IMPL_(Error, MPF_LOG_ERROR, Sample, k, tag, msg)
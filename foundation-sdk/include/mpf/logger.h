@@ -1,32 +1,33 @@
 #pragma once
 
-#include <mpf/interfaces/ilogger.h>
+#include <mpf/logger_access.h>
 #include <QDebug>
 
-namespace mpf {
-
-/**
- * @brief Global logger access (set by host at startup)
- */
-class LoggerAccess
-{
-public:
-    static ILogger* instance() { return s_logger; }
-    static void setInstance(ILogger* logger) { s_logger = logger; }
-private:
-    static inline ILogger* s_logger = nullptr;
-};
-
-} // namespace mpf
+// Level checks come first: below MPF_LOG_MIN_LEVEL the statement is
+// compiled out, below the runtime level msg is never evaluated. The tag
+// is interned by the logger (ILogger::tagId()) once per call site and
+// cached in a static, so it has to be a string literal; the "" tag ""
+// concatenation rejects anything else at compile time. Log a computed
+// tag through ILogger::log() directly.
+#define MPF_LOG_IMPL_(level, fallback, label, tag, msg) \
+    do { \
+        if constexpr (int(mpf::ILogger::Level::level) >= MPF_LOG_MIN_LEVEL) { \
+            if (mpf::LoggerAccess::isEnabled(mpf::ILogger::Level::level)) { \
+                if (auto* _l = mpf::LoggerAccess::instance()) { \
+                    static const int _mpf_tag = _l->tagId(QStringLiteral("" tag "")); \
+                    if (_l->isEnabled(mpf::ILogger::Level::level, _mpf_tag)) { \
+                        _l->logTagged(mpf::ILogger::Level::level, _mpf_tag, QStringLiteral("" tag ""), msg); \
+                    } \
+                } else { \
+                    fallback() << label << tag << msg; \
+                } \
+            } \
+        } \
+    } while (0)
 
 // Convenience logging macros for plugins
-#define MPF_LOG_TRACE(tag, msg) \
-    if (auto* _l = mpf::LoggerAccess::instance()) _l->trace(tag, msg); else qDebug() << "[TRACE]" << tag << msg
-#define MPF_LOG_DEBUG(tag, msg) \
-    if (auto* _l = mpf::LoggerAccess::instance()) _l->debug(tag, msg); else qDebug() << "[DEBUG]" << tag << msg
-#define MPF_LOG_INFO(tag, msg) \
-    if (auto* _l = mpf::LoggerAccess::instance()) _l->info(tag, msg); else qDebug() << "[INFO]" << tag << msg
-#define MPF_LOG_WARNING(tag, msg) \
-    if (auto* _l = mpf::LoggerAccess::instance()) _l->warning(tag, msg); else qWarning() << "[WARN]" << tag << msg
-#define MPF_LOG_ERROR(tag, msg) \
-    if (auto* _l = mpf::LoggerAccess::instance()) _l->error(tag, msg); else qCritical() << "[ERROR]" << tag << msg
+#define MPF_LOG_TRACE(tag, msg)   MPF_LOG_IMPL_(Trace, qDebug, "[TRACE]", tag, msg)
+#define MPF_LOG_DEBUG(tag, msg)   MPF_LOG_IMPL_(Debug, qDebug, "[DEBUG]", tag, msg)
+#define MPF_LOG_INFO(tag, msg)    MPF_LOG_IMPL_(Info, qDebug, "[INFO]", tag, msg)
+#define MPF_LOG_WARNING(tag, msg) MPF_LOG_IMPL_(Warning, qWarning, "[WARN]", tag, msg)
+#define MPF_LOG_ERROR(tag, msg)   MPF_LOG_IMPL_(Error, qCritical, "[ERROR]", tag, msg)
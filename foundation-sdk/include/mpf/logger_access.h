@@ -0,0 +1,76 @@
+#pragma once
+
+#include <mpf/interfaces/ilogger.h>
+#include <atomic>
+
+namespace mpf {
+
+/**
+ * @brief Global logger access (set by host at startup)
+ *
+ * Keeps a copy of the lowest level the logger accepts for any tag, so
+ * MPF_LOG_* can skip disabled statements with two atomic loads, before
+ * the message argument is evaluated.
+ *
+ * The SDK is header-only, so every plugin library has its own copy of
+ * these statics. The host points each one at its own state right after
+ * loading the plugin (IPlugin::attachLogger()), so plugins see the host's
+ * logger and follow its level changes.
+ */
+class LoggerAccess
+{
+public:
+    /**
+     * @brief The logger and its cached level; one instance, the host's, is
+     *        shared by every library once attached
+     */
+    struct Shared
+    {
+        std::atomic<ILogger*> logger{nullptr};
+        std::atomic<int> minLevel{0};
+    };
+
+    static ILogger* instance() { return shared()->logger.load(std::memory_order_acquire); }
+
+    static void setInstance(ILogger* logger)
+    {
+        shared()->logger.store(logger, std::memory_order_release);
+        if (logger) {
+            setMinLevel(logger->lowestLevel());
+        }
+    }
+
+    /**
+     * @brief Update the cached level; call after changing the logger's
+     *        levels (the host Logger does this itself)
+     */
+    static void setMinLevel(ILogger::Level level)
+    {
+        shared()->minLevel.store(int(level), std::memory_order_relaxed);
+    }
+
+    static bool isEnabled(ILogger::Level level)
+    {
+        return int(level) >= shared()->minLevel.load(std::memory_order_relaxed);
+    }
+
+    /**
+     * @brief State used by this library: its own until attach()ed
+     */
+    static Shared* shared() { return s_shared.load(std::memory_order_acquire); }
+
+    /**
+     * @brief Use another library's state in this one (nullptr: back to
+     *        its own); the host does this for plugins
+     */
+    static void attach(Shared* shared)
+    {
+        s_shared.store(shared ? shared : &s_own, std::memory_order_release);
+    }
+
+private:
+    static inline Shared s_own;
+    static inline std::atomic<Shared*> s_shared{&s_own};
+};
+
+} // namespace mpf
@@ -15,3 +15,4 @@
 #include <mpf/interfaces/itheme.h>
 #include <mpf/interfaces/imenu.h>
 #include <mpf/interfaces/ieventbus.h>
+#include <mpf/interfaces/iremoteservice.h>
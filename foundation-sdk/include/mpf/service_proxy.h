@@ -0,0 +1,135 @@
+#pragma once
+
+#include <QFuture>
+#include <QObject>
+#include <QPromise>
+#include <QThread>
+#include <functional>
+#include <memory>
+#include <type_traits>
+#include <utility>
+
+namespace mpf {
+
+/**
+ * @brief Queue of calls to run on a service's owner thread
+ *
+ * The host keeps one queue per service instance, shared by all proxies of
+ * that service. Calls queued from any thread are delivered together in a
+ * single queued invocation on the owner thread.
+ */
+class ServiceCallQueue
+{
+public:
+    virtual ~ServiceCallQueue() = default;
+
+    /**
+     * @brief Queue a call for the owner thread
+     * @param call Work to run on the owner thread
+     * @param coalesceKey Non-zero keys replace a still-pending call with the
+     *        same key queued through this queue
+     */
+    virtual void enqueue(std::function<void()> call, quint64 coalesceKey = 0) = 0;
+
+    /**
+     * @brief Run a call inline on the owner thread
+     *
+     * Hook for hosts that instrument proxied calls; the default just runs it.
+     */
+    virtual void execute(const std::function<void()>& call) { call(); }
+};
+
+/**
+ * @brief Thread-marshalling handle to a service, obtained via ServiceRegistry::proxy<T>()
+ *
+ * Calls made on the service's owner thread run inline; calls from other
+ * threads are batched onto the owner thread. Callables must be copyable.
+ * The service must outlive its proxies; calls still pending when the
+ * service is removed are dropped and their futures canceled.
+ */
+template<typename T>
+class ServiceProxy
+{
+public:
+    ServiceProxy() = default;
+
+    ServiceProxy(T* service, QObject* object, std::shared_ptr<ServiceCallQueue> queue)
+        : m_service(service)
+        , m_object(object)
+        , m_queue(std::move(queue))
+    {
+    }
+
+    bool isValid() const { return m_service && m_queue; }
+    explicit operator bool() const { return isValid(); }
+
+    /**
+     * @brief Raw service pointer, only safe to use on the owner thread
+     */
+    T* service() const { return m_service; }
+
+    /**
+     * @brief Check whether the caller runs on the service's thread
+     */
+    bool isOwnerThread() const
+    {
+        return m_object && m_object->thread() == QThread::currentThread();
+    }
+
+    /**
+     * @brief Invoke a callable with the service on its owner thread
+     * @param fn Callable taking T*
+     * @return Future with the callable's result
+     */
+    template<typename F>
+    QFuture<std::invoke_result_t<F, T*>> call(F&& fn)
+    {
+        using R = std::invoke_result_t<F, T*>;
+
+        auto promise = std::make_shared<QPromise<R>>();
+        QFuture<R> future = promise->future();
+        promise->start();
+
+        auto task = [service = m_service, promise, fn = std::forward<F>(fn)]() mutable {
+            if constexpr (std::is_void_v<R>) {
+                fn(service);
+            } else {
+                promise->addResult(fn(service));
+            }
+            promise->finish();
+        };
+
+        if (isOwnerThread()) {
+            m_queue->execute(task);
+        } else {
+            m_queue->enqueue(std::move(task));
+        }
+        return future;
+    }
+
+    /**
+     * @brief Fire-and-forget call on the owner thread
+     *
+     * Always queued, even on the owner thread, so repeated posts with the
+     * same non-zero coalesceKey collapse into the latest one. Keys are
+     * private to this proxy and its copies; other proxies of the same
+     * service never replace its calls.
+     *
+     * @param fn Callable taking T*
+     * @param coalesceKey Key identifying superseded calls (0 = never coalesce)
+     */
+    template<typename F>
+    void post(F&& fn, quint64 coalesceKey = 0)
+    {
+        m_queue->enqueue([service = m_service, fn = std::forward<F>(fn)]() mutable {
+            fn(service);
+        }, coalesceKey);
+    }
+
+private:
+    T* m_service = nullptr;
+    QObject* m_object = nullptr;
+    std::shared_ptr<ServiceCallQueue> m_queue;
+};
+
+} // namespace mpf
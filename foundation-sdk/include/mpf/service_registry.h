@@ -1,12 +1,21 @@
 #pragma once
 
+#include <mpf/service_proxy.h>
+#include <mpf/interfaces/iremoteservice.h>
+#include <QFuture>
 #include <QString>
+#include <chrono>
+#include <functional>
 #include <typeinfo>
+#include <utility>
 
 class QObject;
 
 namespace mpf {
 
+template<typename T>
+class ServiceHandle;
+
 /**
  * @brief Forward declaration of ServiceRegistry
  * 
@@ -16,6 +25,15 @@ namespace mpf {
 class ServiceRegistry
 {
 public:
+    /**
+     * @brief How get<T>()/acquire<T>() choose among several providers
+     */
+    enum class SelectionPolicy {
+        Ranked,             // Highest rank wins (default)
+        RoundRobin,         // Rotate through eligible providers
+        LeastOutstanding    // Fewest active ServiceHandle leases, then rank
+    };
+
     virtual ~ServiceRegistry() = default;
 
     /**
@@ -49,8 +67,141 @@ public:
         return addService(typeid(T).name(), obj, version, providerId);
     }
 
+    /**
+     * @brief Register an additional ranked implementation of an interface
+     *
+     * Unlike add(), several providers may coexist for one interface; which
+     * one a lookup returns is decided by the interface's SelectionPolicy.
+     *
+     * @tparam T Interface type
+     * @param instance Service instance
+     * @param rank Preference, higher ranks are chosen first
+     * @param version API version
+     * @param providerId Plugin ID providing this service
+     * @return true if registration succeeded
+     */
+    template<typename T>
+    bool addProvider(T* instance, int rank, int version = 1, const QString& providerId = {})
+    {
+        QObject* obj = dynamic_cast<QObject*>(instance);
+        if (!obj) {
+            obj = reinterpret_cast<QObject*>(instance);
+        }
+        return addServiceProvider(typeid(T).name(), obj, rank, version, providerId);
+    }
+
+    /**
+     * @brief Set how providers of an interface are selected
+     */
+    template<typename T>
+    void setSelectionPolicy(SelectionPolicy policy)
+    {
+        setServiceSelectionPolicy(typeid(T).name(), policy);
+    }
+
+    /**
+     * @brief Lease a provider for the duration of a call
+     *
+     * Like get<T>(), but the chosen provider's outstanding-call counter stays
+     * raised until the handle is destroyed, which LeastOutstanding uses.
+     */
+    template<typename T>
+    ServiceHandle<T> acquire(int minVersion = 0);
+
+    /**
+     * @brief Get a thread-marshalling proxy to a service
+     *
+     * Opt-in alternative to get<T>() for callers on other threads than the
+     * service's owner: calls are forwarded to the owner thread as batched
+     * queued calls, with results returned as QFutures.
+     *
+     * @tparam T Interface type
+     * @param minVersion Minimum required version (0 = any)
+     * @return Proxy, invalid if the service is not available
+     */
+    template<typename T>
+    ServiceProxy<T> proxy(int minVersion = 0)
+    {
+        QObject* obj = getService(typeid(T).name(), minVersion);
+        T* service = dynamic_cast<T*>(obj);
+        if (!service) {
+            return {};
+        }
+        return ServiceProxy<T>(service, obj, callQueue(typeid(T).name(), obj));
+    }
+
+    /**
+     * @brief Get a service of an out-of-process plugin by name
+     *
+     * Services of plugins running in their own process (see
+     * IRemoteService) are not reachable through get<T>().
+     *
+     * @param serviceName Name as listed in the provider's "provides"
+     * @param minVersion Minimum required version (0 = any)
+     * @return Remote service or nullptr if not available
+     */
+    IRemoteService* remote(const QString& serviceName, int minVersion = 0)
+    {
+        QObject* obj = getService(serviceName.toLatin1().constData(), minVersion);
+        return dynamic_cast<IRemoteService*>(obj);
+    }
+
+    /**
+     * @brief Register a lazily constructed service implementation
+     *
+     * The factory is invoked on the first get<T>() instead of at registration
+     * time. Construction is thread-safe and happens exactly once; concurrent
+     * callers block until the instance is ready. Instances created without a
+     * QObject parent are owned and deleted by the registry.
+     *
+     * @tparam T Interface type
+     * @param factory Creates the service instance
+     * @param version API version
+     * @param providerId Plugin ID providing this service
+     * @return true if registration succeeded
+     */
+    template<typename T>
+    bool addFactory(std::function<T*()> factory, int version = 1, const QString& providerId = {})
+    {
+        if (!factory) {
+            return false;
+        }
+        return addServiceFactory(typeid(T).name(), [factory = std::move(factory)]() -> QObject* {
+            T* instance = factory();
+            if (!instance) {
+                return nullptr;
+            }
+            QObject* obj = dynamic_cast<QObject*>(instance);
+            if (!obj) {
+                obj = reinterpret_cast<QObject*>(instance);
+            }
+            return obj;
+        }, version, providerId);
+    }
+
+    /**
+     * @brief Wait asynchronously for a service to become available
+     *
+     * The returned future is already finished if a matching service is
+     * registered; otherwise it resolves when one is added. It is canceled
+     * if the registry is destroyed first.
+     *
+     * @tparam T Interface type
+     * @param minVersion Minimum required version (0 = any)
+     * @return Future resolving to the service instance
+     */
+    template<typename T>
+    QFuture<T*> when(int minVersion = 0)
+    {
+        return whenService(typeid(T).name(), minVersion).then([](QObject* obj) {
+            return dynamic_cast<T*>(obj);
+        });
+    }
+
     /**
      * @brief Check if a service is available
+     *
+     * Lazily registered services count as available without being constructed.
      */
     template<typename T>
     bool has(int minVersion = 0) const
@@ -59,9 +210,100 @@ public:
     }
 
 protected:
+    template<typename T>
+    friend class ServiceHandle;
+
+    using ServiceFactory = std::function<QObject*()>;
+
     virtual QObject* getService(const char* typeName, int minVersion) = 0;
     virtual bool addService(const char* typeName, QObject* instance, int version, const QString& providerId) = 0;
+    virtual bool addServiceFactory(const char* typeName, ServiceFactory factory, int version, const QString& providerId) = 0;
     virtual bool hasService(const char* typeName, int minVersion) const = 0;
+    virtual QFuture<QObject*> whenService(const char* typeName, int minVersion) = 0;
+    virtual bool addServiceProvider(const char* typeName, QObject* instance, int rank,
+                                    int version, const QString& providerId) = 0;
+    virtual void setServiceSelectionPolicy(const char* typeName, SelectionPolicy policy) = 0;
+    virtual QObject* acquireService(const char* typeName, int minVersion) = 0;
+    virtual void releaseService(const char* typeName, QObject* instance, qint64 heldNs) = 0;
+    virtual std::shared_ptr<ServiceCallQueue> callQueue(const char* typeName, QObject* instance) = 0;
+};
+
+/**
+ * @brief Scoped lease on a service provider obtained via acquire<T>()
+ *
+ * Move-only; releases the lease on destruction or reset(). The time the
+ * lease was held is reported to the host as the call's duration.
+ */
+template<typename T>
+class ServiceHandle
+{
+public:
+    ServiceHandle() = default;
+
+    ServiceHandle(ServiceRegistry* registry, const char* typeName, QObject* object)
+        : m_registry(registry)
+        , m_typeName(typeName)
+        , m_object(object)
+        , m_service(dynamic_cast<T*>(object))
+        , m_acquired(std::chrono::steady_clock::now())
+    {
+    }
+
+    ~ServiceHandle() { reset(); }
+
+    ServiceHandle(const ServiceHandle&) = delete;
+    ServiceHandle& operator=(const ServiceHandle&) = delete;
+
+    ServiceHandle(ServiceHandle&& other) noexcept { swap(other); }
+    ServiceHandle& operator=(ServiceHandle&& other) noexcept
+    {
+        if (this != &other) {
+            reset();
+            swap(other);
+        }
+        return *this;
+    }
+
+    T* get() const { return m_service; }
+    T* operator->() const { return m_service; }
+    T& operator*() const { return *m_service; }
+    explicit operator bool() const { return m_service != nullptr; }
+
+    void reset()
+    {
+        if (m_registry && m_object) {
+            auto held = std::chrono::steady_clock::now() - m_acquired;
+            m_registry->releaseService(m_typeName, m_object,
+                std::chrono::duration_cast<std::chrono::nanoseconds>(held).count());
+        }
+        m_registry = nullptr;
+        m_typeName = nullptr;
+        m_object = nullptr;
+        m_service = nullptr;
+    }
+
+private:
+    void swap(ServiceHandle& other) noexcept
+    {
+        std::swap(m_registry, other.m_registry);
+        std::swap(m_typeName, other.m_typeName);
+        std::swap(m_object, other.m_object);
+        std::swap(m_service, other.m_service);
+        std::swap(m_acquired, other.m_acquired);
+    }
+
+    ServiceRegistry* m_registry = nullptr;
+    const char* m_typeName = nullptr;
+    QObject* m_object = nullptr;
+    T* m_service = nullptr;
+    std::chrono::steady_clock::time_point m_acquired;
 };
 
+template<typename T>
+ServiceHandle<T> ServiceRegistry::acquire(int minVersion)
+{
+    const char* typeName = typeid(T).name();
+    return ServiceHandle<T>(this, typeName, acquireService(typeName, minVersion));
+}
+
 } // namespace mpf
@@ -0,0 +1,335 @@
+#pragma once
+
+#include <mpf/logger_access.h>
+#include <QByteArray>
+#include <QDebug>
+#include <QLocale>
+#include <QString>
+#include <QStringList>
+#include <QVarLengthArray>
+#include <atomic>
+#include <cstring>
+#include <type_traits>
+
+/**
+ * @file structured_log.h
+ * @brief Structured logging with deferred formatting
+ *
+ * MPF_SLOG_* take a string-literal format with {} placeholders and typed
+ * arguments. The arguments are copied as raw bytes next to a per-call-site
+ * ID; the text is only produced when the log is decoded (mpf-log-decode),
+ * so the hot path does no number or string formatting:
+ *
+ * @code
+ * MPF_SLOG_DEBUG("Orders", "order {} total {} status {}", id, total, status);
+ * @endcode
+ *
+ * Supported argument types: integers, enums, bool, floating point,
+ * const char* (UTF-8), QByteArray (UTF-8) and QString. When the logger has
+ * no structured output the message is formatted and logged as text.
+ */
+
+namespace mpf {
+namespace structured {
+
+/**
+ * @brief Stream layout, shared with the host writer and decoder
+ *
+ * Header: Magic, quint32 ByteOrderMark, qint64 base time (ms since epoch).
+ * Then records, each starting with a RecordKind byte, in host byte order:
+ * - SiteRecord:  quint16 id, quint8 level, quint16 tag length, tag,
+ *                quint16 format length, format, quint8 argument count,
+ *                signature (one type code per argument)
+ * - EntryRecord: quint16 site id, quint32 ms since base time, arguments
+ * - ClockRecord: qint64 new base time
+ *
+ * Argument encoding by type code: i/u = 4 bytes, I/U = 8 bytes,
+ * d = double, b = 1 byte, s = quint32 length + UTF-8 bytes,
+ * S = quint32 length + UTF-16 code units.
+ */
+constexpr char Magic[8] = {'M', 'P', 'F', 'S', 'L', 'O', 'G', '1'};
+constexpr quint32 ByteOrderMark = 0x01020304;
+constexpr qsizetype HeaderSize = 8 + 4 + 8;
+
+enum RecordKind : quint8 {
+    SiteRecord = 1,
+    EntryRecord = 2,
+    ClockRecord = 3
+};
+
+/**
+ * @brief Encoded arguments of one call; stays on the stack for typical calls
+ */
+using Payload = QVarLengthArray<char, 256>;
+
+template<typename T>
+inline constexpr bool dependentFalse = false;
+
+/**
+ * @brief Type code written to the signature for an argument type
+ */
+template<typename T>
+constexpr char typeCode()
+{
+    using U = std::decay_t<T>;
+    if constexpr (std::is_same_v<U, bool>) {
+        return 'b';
+    } else if constexpr (std::is_enum_v<U>) {
+        return typeCode<std::underlying_type_t<U>>();
+    } else if constexpr (std::is_integral_v<U>) {
+        if constexpr (sizeof(U) <= 4) {
+            return std::is_signed_v<U> ? 'i' : 'u';
+        } else {
+            return std::is_signed_v<U> ? 'I' : 'U';
+        }
+    } else if constexpr (std::is_floating_point_v<U>) {
+        return 'd';
+    } else if constexpr (std::is_same_v<U, const char*> || std::is_same_v<U, char*>
+                         || std::is_same_v<U, QByteArray>) {
+        return 's';
+    } else if constexpr (std::is_same_v<U, QString>) {
+        return 'S';
+    } else {
+        static_assert(dependentFalse<U>, "Unsupported MPF_SLOG argument type");
+        return '\0';
+    }
+}
+
+template<typename T>
+void appendRaw(Payload& out, T value)
+{
+    out.append(reinterpret_cast<const char*>(&value), qsizetype(sizeof(value)));
+}
+
+/**
+ * @brief Append one argument in its wire encoding
+ */
+template<typename T>
+void encode(Payload& out, const T& value)
+{
+    using U = std::decay_t<T>;
+    constexpr char code = typeCode<U>();
+    if constexpr (code == 'b') {
+        appendRaw(out, quint8(value ? 1 : 0));
+    } else if constexpr (code == 'i') {
+        appendRaw(out, qint32(value));
+    } else if constexpr (code == 'u') {
+        appendRaw(out, quint32(value));
+    } else if constexpr (code == 'I') {
+        appendRaw(out, qint64(value));
+    } else if constexpr (code == 'U') {
+        appendRaw(out, quint64(value));
+    } else if constexpr (code == 'd') {
+        appendRaw(out, double(value));
+    } else if constexpr (std::is_same_v<U, QByteArray>) {
+        appendRaw(out, quint32(value.size()));
+        out.append(value.constData(), value.size());
+    } else if constexpr (code == 's') {
+        const qsizetype length = value ? qsizetype(std::strlen(value)) : 0;
+        appendRaw(out, quint32(length));
+        out.append(value, length);
+    } else if constexpr (code == 'S') {
+        appendRaw(out, quint32(value.size()));
+        out.append(reinterpret_cast<const char*>(value.constData()), value.size() * 2);
+    }
+}
+
+/**
+ * @brief Decode the arguments of one entry and substitute them into format
+ * @param consumed Set to the number of payload bytes used, or -1 if the
+ *        payload is truncated or the signature invalid
+ */
+inline QString render(const char* format, const char* signature, const char* data, qsizetype size,
+                      qsizetype* consumed = nullptr)
+{
+    QStringList args;
+    qsizetype pos = 0;
+    bool ok = true;
+
+    auto read = [&](void* out, qsizetype bytes) {
+        if (!ok || size - pos < bytes) {
+            ok = false;
+            return;
+        }
+        std::memcpy(out, data + pos, size_t(bytes));
+        pos += bytes;
+    };
+
+    for (const char* code = signature; ok && *code; ++code) {
+        switch (*code) {
+        case 'b': { quint8 v = 0; read(&v, 1); args.append(v ? QStringLiteral("true") : QStringLiteral("false")); break; }
+        case 'i': { qint32 v = 0; read(&v, 4); args.append(QString::number(v)); break; }
+        case 'u': { quint32 v = 0; read(&v, 4); args.append(QString::number(v)); break; }
+        case 'I': { qint64 v = 0; read(&v, 8); args.append(QString::number(v)); break; }
+        case 'U': { quint64 v = 0; read(&v, 8); args.append(QString::number(v)); break; }
+        case 'd': {
+            double v = 0;
+            read(&v, 8);
+            args.append(QString::number(v, 'g', QLocale::FloatingPointShortest));
+            break;
+        }
+        case 's':
+        case 'S': {
+            quint32 length = 0;
+            read(&length, 4);
+            const qsizetype bytes = qsizetype(length) * (*code == 'S' ? 2 : 1);
+            if (!ok || size - pos < bytes) {
+                ok = false;
+                break;
+            }
+            if (*code == 's') {
+                args.append(QString::fromUtf8(data + pos, bytes));
+            } else {
+                QString text(qsizetype(length), Qt::Uninitialized);
+                std::memcpy(text.data(), data + pos, size_t(bytes));
+                args.append(text);
+            }
+            pos += bytes;
+            break;
+        }
+        default:
+            ok = false;
+            break;
+        }
+    }
+
+    if (consumed) {
+        *consumed = ok ? pos : -1;
+    }
+    if (!ok) {
+        return QStringLiteral("<malformed entry: %1>").arg(QString::fromUtf8(format));
+    }
+
+    // {} placeholders in order; surplus arguments are appended
+    const QString pattern = QString::fromUtf8(format);
+    QString text;
+    qsizetype from = 0;
+    qsizetype next = 0;
+    for (; next < args.size(); ++next) {
+        const qsizetype index = pattern.indexOf(QLatin1String("{}"), from);
+        if (index < 0) {
+            break;
+        }
+        text.append(QStringView(pattern).sliced(from, index - from)).append(args.at(next));
+        from = index + 2;
+    }
+    text.append(QStringView(pattern).sliced(from));
+    for (; next < args.size(); ++next) {
+        text.append(QLatin1Char(' ')).append(args.at(next));
+    }
+    return text;
+}
+
+/**
+ * @brief Static state of one MPF_SLOG_* call site
+ *
+ * Constant-initialized, so the function-local static in the macro needs no
+ * guard. The site ID is requested from the logger on first use and cached
+ * together with the logger's structuredEpoch(), so it is requested again
+ * from a different logger and never used without structured output.
+ */
+class Site
+{
+public:
+    constexpr Site(ILogger::Level level, const char* tag, const char* format)
+        : m_level(level)
+        , m_tag(tag)
+        , m_format(format)
+    {
+    }
+
+    /**
+     * @brief Per-tag level check; arguments are only evaluated if it passes
+     */
+    bool isEnabled()
+    {
+        ILogger* logger = LoggerAccess::instance();
+        if (!logger) {
+            return true;
+        }
+        int tagId = m_tagId.load(std::memory_order_relaxed);
+        if (tagId == UnknownTag) {
+            tagId = logger->tagId(QString::fromUtf8(m_tag));
+            m_tagId.store(tagId, std::memory_order_relaxed);
+        }
+        return logger->isEnabled(m_level, tagId);
+    }
+
+    template<typename... Args>
+    void log(const Args&... args)
+    {
+        static constexpr char signature[] = {typeCode<Args>()..., '\0'};
+
+        Payload payload;
+        (encode(payload, args), ...);
+
+        ILogger* logger = LoggerAccess::instance();
+        if (logger) {
+            const quint32 id = siteId(logger, signature);
+            if (id && logger->logStructured(id, payload.constData(), payload.size())) {
+                return;
+            }
+        }
+
+        // No structured output: format now
+        const QString text = render(m_format, signature, payload.constData(), payload.size());
+        if (logger) {
+            logger->logTagged(m_level, m_tagId.load(std::memory_order_relaxed),
+                              QString::fromUtf8(m_tag), text);
+        } else {
+            qDebug().noquote() << QString::fromUtf8(m_tag) << text;
+        }
+    }
+
+private:
+    static constexpr int UnknownTag = -2;
+
+    quint32 siteId(ILogger* logger, const char* signature)
+    {
+        const quint64 epoch = logger->structuredEpoch();
+        if (epoch == 0) {
+            return 0;
+        }
+        // Epoch and ID in one word, so no thread sees one without the other
+        const quint64 cached = m_site.load(std::memory_order_relaxed);
+        if (cached >> 16 == epoch) {
+            return quint32(cached & 0xFFFF);
+        }
+
+        // Only successful registrations are cached, so a site logged before
+        // structured output was opened picks it up later
+        const quint32 id = logger->structuredSite(m_level, m_tag, m_format, signature);
+        if (id) {
+            m_site.store(epoch << 16 | id, std::memory_order_relaxed);
+        }
+        return id;
+    }
+
+    const ILogger::Level m_level;
+    const char* const m_tag;
+    const char* const m_format;
+    std::atomic<quint64> m_site{0};        // structuredEpoch() << 16 | site ID
+    std::atomic<int> m_tagId{UnknownTag};  // From ILogger::tagId() on first use
+};
+
+} // namespace structured
+} // namespace mpf
+
+// Same level checks as MPF_LOG_*; arguments are not evaluated when disabled
+#define MPF_SLOG_IMPL_(level, tag, format, ...) \
+    do { \
+        if constexpr (int(mpf::ILogger::Level::level) >= MPF_LOG_MIN_LEVEL) { \
+            if (mpf::LoggerAccess::isEnabled(mpf::ILogger::Level::level)) { \
+                static mpf::structured::Site _mpf_site(mpf::ILogger::Level::level, "" tag "", "" format ""); \
+                if (_mpf_site.isEnabled()) _mpf_site.log(__VA_ARGS__); \
+            } \
+        } \
+    } while (0)
+
+// tag and format must be string literals (they are stored by pointer);
+// anything else fails to compile
+#define MPF_SLOG_TRACE(tag, format, ...)   MPF_SLOG_IMPL_(Trace, tag, format, __VA_ARGS__)
+#define MPF_SLOG_DEBUG(tag, format, ...)   MPF_SLOG_IMPL_(Debug, tag, format, __VA_ARGS__)
+#define MPF_SLOG_INFO(tag, format, ...)    MPF_SLOG_IMPL_(Info, tag, format, __VA_ARGS__)
+#define MPF_SLOG_WARNING(tag, format, ...) MPF_SLOG_IMPL_(Warning, tag, format, __VA_ARGS__)
+#define MPF_SLOG_ERROR(tag, format, ...)   MPF_SLOG_IMPL_(Error, tag, format, __VA_ARGS__)
@@ -9,6 +9,7 @@ namespace mpf {
 
 class PluginManager;
 class Logger;
+class PluginPreloader;
 
 /**
  * @brief Main application class
@@ -66,9 +67,13 @@ signals:
 
 private:
     void setupPaths();
+    void startPreload();
     void setupLogging();
+    void setupLogLevels();
     void setupQmlContext();
     void loadPlugins();
+    void setupDeferredPlugins();
+    void setupMemoryReport();
     bool loadMainQml();
 
     std::unique_ptr<QGuiApplication> m_app;
@@ -76,6 +81,7 @@ private:
     std::unique_ptr<ServiceRegistryImpl> m_registry;
     std::unique_ptr<PluginManager> m_pluginManager;
     std::unique_ptr<Logger> m_logger;
+    std::unique_ptr<PluginPreloader> m_preloader;
 
     QString m_pluginPath;
     QString m_qmlPath;
@@ -0,0 +1,122 @@
+#pragma once
+
+#include <QByteArray>
+#include <QFile>
+#include <QMutex>
+#include <QString>
+#include <QStringConverter>
+#include <QThread>
+#include <QThreadPool>
+#include <QWaitCondition>
+
+namespace mpf {
+
+/**
+ * @brief Rotating log file written from a background thread
+ *
+ * write() only encodes the line into an in-memory buffer. The sink's
+ * thread writes the buffer out once it reaches Options::bufferSize, every
+ * Options::flushIntervalMs and on flush(), so disk I/O never happens on
+ * the logging thread unless the buffer backs up to four times its size.
+ *
+ * The file is rotated before it would exceed Options::maxFileSize and
+ * once it is older than Options::rotateIntervalMs: it is renamed to
+ * <name>-<yyyyMMdd-hhmmss-zzz>.<suffix> (its start time) and, with
+ * Options::compress, gzipped in the background. Only the newest
+ * Options::maxFiles rotated files are kept.
+ */
+class FileLogSink : public QThread
+{
+    Q_OBJECT
+
+public:
+    struct Options
+    {
+        QString filePath;                              // Active file; appended to
+        qint64 maxFileSize = 64 * 1024 * 1024;         // 0 = no size limit
+        qint64 rotateIntervalMs = 24 * 3600 * 1000LL;  // 0 = no time limit
+        int maxFiles = 10;                             // Rotated files kept, 0 = all
+        bool compress = false;                         // gzip rotated files
+        qsizetype bufferSize = 256 * 1024;
+        int flushIntervalMs = 1000;
+    };
+
+    explicit FileLogSink(const Options& options, QObject* parent = nullptr);
+
+    /**
+     * @brief Writes everything buffered, then closes the file
+     */
+    ~FileLogSink() override;
+
+    /**
+     * @brief Open (or create) the file and start the writer thread
+     * @return false if the file cannot be opened
+     */
+    bool open();
+
+    /**
+     * @brief Write everything buffered and stop; called by the destructor
+     */
+    void close();
+
+    const Options& options() const { return m_options; }
+    QString errorString() const;
+
+    /**
+     * @brief Append one line (a newline is added); any thread
+     * @param urgent Write it out now instead of at the next interval
+     */
+    void write(QStringView line, bool urgent = false);
+
+    /**
+     * @brief Wait until everything written so far is in the file
+     */
+    void flush();
+
+    /**
+     * @brief Wait for pending compression of rotated files
+     */
+    void waitForCompression() { m_compressor.waitForDone(); }
+
+    /**
+     * @brief Rotated files next to the active one, oldest first
+     */
+    QStringList rotatedFiles() const;
+
+    /**
+     * @brief gzip a file to <path>.gz and remove the original
+     */
+    static bool compressFile(const QString& path);
+
+protected:
+    void run() override;
+
+private:
+    bool openFile();
+    bool needsRotation(qsizetype incoming) const;
+    void rotate();
+    void prune();
+
+    const Options m_options;
+
+    // Producer side, guarded by m_mutex
+    mutable QMutex m_mutex;
+    QWaitCondition m_wake;     // Writer thread sleeps on this
+    QWaitCondition m_drained;  // write() and flush() wait on this
+    QByteArray m_buffer;
+    QStringEncoder m_encoder{QStringEncoder::Utf8};
+    quint64 m_flushRequested = 0;
+    quint64 m_flushDone = 0;
+    bool m_running = false;
+    bool m_stopping = false;
+    QString m_error;
+
+    // Writer thread side
+    QFile m_file;
+    qint64 m_fileSize = 0;
+    qint64 m_openedAtMs = 0;
+
+    QThreadPool m_compressor;
+};
+
+} // namespace mpf
@@ -0,0 +1,108 @@
+#pragma once
+
+#include <QByteArray>
+#include <QObject>
+#include <QPointer>
+#include <QString>
+#include <QVariant>
+#include <QVariantList>
+
+class QDataStream;
+class QLocalSocket;
+
+namespace mpf {
+
+/**
+ * @brief One message between the host and an mpf-plugin-host process
+ */
+struct IpcMessage
+{
+    enum class Type : quint8 {
+        Hello,      // child -> host: plugin loaded (name = plugin ID), args = {launch token}
+        Start,      // host -> child: initialize() and start() the plugin
+        Started,    // child -> host: ok, args = services found
+        Stop,       // host -> child: stop() the plugin and exit
+        Call,       // name = service, method, args; id = 0 for no reply
+        Reply,      // id, ok, result or error (in method)
+        Event,      // name = topic, args = {data, senderId}
+        Subscriptions  // child -> host: args = topic patterns it listens to
+    };
+
+    Type type = Type::Hello;
+    quint64 id = 0;
+    bool ok = true;
+    QString name;
+    QString method;
+    QVariantList args;
+    QVariant result;
+};
+
+QDataStream& operator<<(QDataStream& out, const IpcMessage& message);
+QDataStream& operator>>(QDataStream& in, IpcMessage& message);
+
+/**
+ * @brief Batched binary message channel over a QLocalSocket
+ *
+ * Messages sent during one event loop iteration are written as a single
+ * frame (quint32 length, quint32 count, messages), so a burst of calls or
+ * events costs one write and one wake-up on the other side. Frames are
+ * flushed early once they exceed FlushThreshold bytes.
+ */
+class IpcChannel : public QObject
+{
+    Q_OBJECT
+
+public:
+    static constexpr int FlushThreshold = 64 * 1024;
+
+    /**
+     * @param socket Connected socket; not owned
+     */
+    explicit IpcChannel(QLocalSocket* socket, QObject* parent = nullptr);
+    ~IpcChannel() override;
+
+    /**
+     * @brief Queue a message for the next flush
+     */
+    void send(const IpcMessage& message);
+
+    /**
+     * @brief Write all queued messages now
+     */
+    void flush();
+
+    bool isConnected() const;
+
+    quint64 framesSent() const { return m_framesSent; }
+    quint64 messagesSent() const { return m_messagesSent; }
+
+    /**
+     * @brief Invoke a method on a QObject by name with variant arguments
+     *
+     * Picks the invokable method or slot with that name and argument count
+     * and converts each argument to the declared parameter type.
+     *
+     * @param result Receives the return value, if any
+     * @param error Receives a description on failure
+     */
+    static bool invoke(QObject* target, const QString& method, const QVariantList& args,
+                       QVariant* result, QString* error);
+
+signals:
+    void messageReceived(const mpf::IpcMessage& message);
+    void disconnected();
+
+private:
+    void onReadyRead();
+    void scheduleFlush();
+
+    QPointer<QLocalSocket> m_socket;
+    QByteArray m_outgoing;   // Serialized messages of the pending frame
+    quint32 m_outgoingCount = 0;
+    bool m_flushScheduled = false;
+    QByteArray m_incoming;
+    quint64 m_framesSent = 0;
+    quint64 m_messagesSent = 0;
+};
+
+} // namespace mpf
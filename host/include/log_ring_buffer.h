@@ -0,0 +1,116 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <utility>
+
+namespace mpf {
+
+/**
+ * @brief Bounded lock-free multi-producer queue for the async logger
+ *
+ * Each slot carries a sequence number telling producers and the consumer
+ * whose turn it is (D. Vyukov's bounded MPMC queue), so pushes from any
+ * number of threads never take a lock and never allocate. The consumer
+ * side is safe for several threads too, but Logger uses just one.
+ *
+ * @tparam T Movable, default-constructible record type
+ */
+template<typename T>
+class LogRingBuffer
+{
+public:
+    /**
+     * @param capacity Number of slots, rounded up to a power of two (min 2)
+     */
+    explicit LogRingBuffer(std::size_t capacity)
+    {
+        std::size_t size = 2;
+        while (size < capacity) {
+            size <<= 1;
+        }
+        m_mask = size - 1;
+        m_slots = std::make_unique<Slot[]>(size);
+        for (std::size_t i = 0; i < size; ++i) {
+            m_slots[i].sequence.store(i, std::memory_order_relaxed);
+        }
+    }
+
+    LogRingBuffer(const LogRingBuffer&) = delete;
+    LogRingBuffer& operator=(const LogRingBuffer&) = delete;
+
+    std::size_t capacity() const { return m_mask + 1; }
+
+    /**
+     * @brief Append a record
+     * @return false if the buffer is full; value is left untouched
+     */
+    bool tryPush(T& value)
+    {
+        std::size_t pos = m_enqueue.load(std::memory_order_relaxed);
+        Slot* slot;
+        for (;;) {
+            slot = &m_slots[pos & m_mask];
+            const std::size_t sequence = slot->sequence.load(std::memory_order_acquire);
+            const std::intptr_t diff = std::intptr_t(sequence) - std::intptr_t(pos);
+            if (diff == 0) {
+                if (m_enqueue.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                    break;
+                }
+            } else if (diff < 0) {
+                return false;
+            } else {
+                pos = m_enqueue.load(std::memory_order_relaxed);
+            }
+        }
+
+        slot->value = std::move(value);
+        slot->sequence.store(pos + 1, std::memory_order_release);
+        return true;
+    }
+
+    /**
+     * @brief Take the oldest record
+     * @return false if the buffer is empty
+     */
+    bool tryPop(T& value)
+    {
+        std::size_t pos = m_dequeue.load(std::memory_order_relaxed);
+        Slot* slot;
+        for (;;) {
+            slot = &m_slots[pos & m_mask];
+            const std::size_t sequence = slot->sequence.load(std::memory_order_acquire);
+            const std::intptr_t diff = std::intptr_t(sequence) - std::intptr_t(pos + 1);
+            if (diff == 0) {
+                if (m_dequeue.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                    break;
+                }
+            } else if (diff < 0) {
+                return false;
+            } else {
+                pos = m_dequeue.load(std::memory_order_relaxed);
+            }
+        }
+
+        value = std::move(slot->value);
+        slot->value = T();  // Release shared payloads now, not when the slot is reused
+        slot->sequence.store(pos + m_mask + 1, std::memory_order_release);
+        return true;
+    }
+
+private:
+    struct alignas(64) Slot
+    {
+        std::atomic<std::size_t> sequence{0};
+        T value{};
+    };
+
+    std::unique_ptr<Slot[]> m_slots;
+    std::size_t m_mask = 0;
+    alignas(64) std::atomic<std::size_t> m_enqueue{0};
+    alignas(64) std::atomic<std::size_t> m_dequeue{0};
+};
+
+} // namespace mpf
@@ -0,0 +1,63 @@
+#pragma once
+
+#include <QHash>
+#include <QMutex>
+#include <QString>
+#include <QStringList>
+
+namespace mpf {
+
+/**
+ * @brief Process-wide table of interned log tags
+ *
+ * Gives every tag a small, stable integer ID so per-tag level checks are
+ * an array lookup (ILogger::isEnabled(Level, int)). Lives in the host
+ * only: plugins reach it through ILogger::tagId(), since a header-only
+ * table would exist once per plugin library and hand out IDs that index
+ * the wrong slots of the Logger's level array. MPF_LOG_* intern the tag
+ * once per call site and keep the ID in a static.
+ */
+class LogTags
+{
+public:
+    static constexpr int MaxTags = 1024;
+
+    /**
+     * @brief ID of a tag, assigning the next free one on first use
+     * @return -1 once MaxTags tags exist; such tags use the global level
+     */
+    static int id(const QString& tag)
+    {
+        QMutexLocker locker(&s_mutex);
+        const auto it = s_ids.constFind(tag);
+        if (it != s_ids.constEnd()) {
+            return it.value();
+        }
+        if (s_names.size() >= MaxTags) {
+            return -1;
+        }
+        const int id = int(s_names.size());
+        s_ids.insert(tag, id);
+        s_names.append(tag);
+        return id;
+    }
+
+    static QString name(int id)
+    {
+        QMutexLocker locker(&s_mutex);
+        return s_names.value(id);
+    }
+
+    static int count()
+    {
+        QMutexLocker locker(&s_mutex);
+        return int(s_names.size());
+    }
+
+private:
+    static inline QMutex s_mutex;
+    static inline QHash<QString, int> s_ids;
+    static inline QStringList s_names;
+};
+
+} // namespace mpf
@@ -1,18 +1,46 @@
 #pragma once
 
+#include "log_tags.h"
 #include <mpf/interfaces/ilogger.h>
+#include <mpf/logger_access.h>
 #include <QObject>
+#include <QDate>
+#include <QHash>
+#include <QList>
 #include <QMutex>
 #include <QString>
+#include <atomic>
 #include <functional>
+#include <memory>
+#include <vector>
 
 namespace mpf {
 
+class FileLogSink;
+
 /**
  * @brief Default logger implementation
  * 
  * Routes logs to Qt's message system with formatting.
  * Can be replaced with custom implementation via ServiceRegistry.
+ *
+ * By default log() formats and writes on the calling thread. After
+ * startAsync() callers only push the record into a lock-free ring buffer
+ * and a background thread formats and writes it (and calls the handler),
+ * so logging never waits on stderr or a lock.
+ *
+ * A FileLogSink can be attached to also write every formatted line to a
+ * rotating file; console output (or the custom handler) continues unless
+ * turned off with setConsoleOutput(false).
+ *
+ * Levels can be set per tag (setTagLevel(), setTagLevels()); a tag
+ * without its own level uses minLevel(). Tags are interned into LogTags
+ * IDs, and the effective level of every ID is kept in a flat array, so a
+ * per-tag check is one array load.
+ *
+ * MPF_SLOG_* records (mpf/structured_log.h) bypass formatting entirely:
+ * with setStructuredOutput() their raw arguments are appended to a binary
+ * file that mpf-log-decode turns into text later.
  */
 class Logger : public QObject, public ILogger
 {
@@ -21,47 +49,226 @@ class Logger : public QObject, public ILogger
 public:
     using LogHandler = std::function<void(Level, const QString&, const QString&)>;
 
+    /**
+     * @brief What log() does when the async buffer is full
+     */
+    enum class OverflowPolicy {
+        Drop,   // Discard the record and count it (see droppedCount())
+        Block   // Wait for the writer thread to make room
+    };
+
     explicit Logger(QObject* parent = nullptr);
     ~Logger() override;
 
     // ILogger interface
     void log(Level level, const QString& tag, const QString& message) override;
+    void logTagged(Level level, int tagId, const QString& tag, const QString& message) override;
+    int tagId(const QString& tag) override { return LogTags::id(tag); }
     void setMinLevel(Level level) override;
     Level minLevel() const override;
+    quint64 structuredEpoch() const override
+    {
+        return m_structuredEpoch.load(std::memory_order_relaxed);
+    }
+    quint32 structuredSite(Level level, const char* tag, const char* format,
+                           const char* signature) override;
+    bool logStructured(quint32 siteId, const char* payload, qsizetype size) override;
+
+    Level lowestLevel() const override { return m_lowestLevel.load(std::memory_order_relaxed); }
+
+    /**
+     * @brief Check a level for a LogTags ID without locking; used by
+     *        MPF_LOG_* before building the message
+     */
+    bool isEnabled(Level level, int tagId) const final
+    {
+        if (tagId >= 0 && tagId < LogTags::MaxTags) {
+            return level >= m_tagLevels[tagId].load(std::memory_order_relaxed);
+        }
+        return level >= m_minLevel.load(std::memory_order_relaxed);
+    }
+
+    /**
+     * @brief Whether any tag is enabled at a level; the first, tag-free
+     *        check in MPF_LOG_*
+     */
+    bool isEnabled(Level level) const
+    {
+        return level >= m_lowestLevel.load(std::memory_order_relaxed);
+    }
+
+    /**
+     * @brief Give one tag its own level, e.g. "OrdersPlugin" at Trace
+     */
+    void setTagLevel(const QString& tag, Level level);
+
+    /**
+     * @brief Make a tag use minLevel() again
+     */
+    void clearTagLevel(const QString& tag);
+
+    /**
+     * @brief Replace all tag levels from "Tag=Level, Tag=Level"
+     *
+     * Levels are trace, debug, info, warning (or warn) and error, in any
+     * case; the tag "*" sets minLevel(). An empty spec clears all tag
+     * levels.
+     *
+     * @return false, changing nothing, if spec does not parse
+     */
+    bool setTagLevels(const QString& spec);
+
+    /**
+     * @brief Tags with their own level
+     */
+    QHash<QString, Level> tagLevels() const;
+
+    static bool parseLevel(QStringView name, Level* level);
 
     // Custom handler
     void setHandler(LogHandler handler);
 
-    // Formatting
+    /**
+     * @brief Also write formatted lines to a file; nullptr detaches
+     *
+     * The sink should already be open. Error messages are handed to its
+     * thread right away instead of at the next flush interval.
+     */
+    void setFileSink(std::unique_ptr<FileLogSink> sink);
+    FileLogSink* fileSink() const;
+
+    /**
+     * @brief Enable or disable the Qt message output (default on)
+     */
+    void setConsoleOutput(bool enabled);
+    bool consoleOutput() const;
+
+    // Formatting: placeholders %level%, %tag%, %message%, %time%, %date%
     void setFormat(const QString& format);
     QString format() const;
 
+    /**
+     * @brief Switch to asynchronous logging
+     * @param capacity Ring buffer size in records (rounded up to a power of two)
+     * @param policy Behaviour when the buffer is full
+     */
+    void startAsync(int capacity = 8192, OverflowPolicy policy = OverflowPolicy::Block);
+
+    /**
+     * @brief Write everything still queued and return to synchronous logging
+     *
+     * Records logged by other threads while this runs are either queued
+     * and written before it returns, or written synchronously by their
+     * caller. Called by the destructor.
+     */
+    void stopAsync();
+
+    bool isAsync() const { return m_writer.load(std::memory_order_acquire) != nullptr; }
+
+    /**
+     * @brief Wait until all records logged so far have been written,
+     *        including to the file sink
+     */
+    void flush();
+
+    /**
+     * @brief Write structured records to a binary file (read with mpf-log-decode)
+     * @param path File to create, replacing an existing one; empty closes it
+     * @return false if the file cannot be opened
+     *
+     * Without a structured output MPF_SLOG_* messages are formatted and
+     * logged as text like any other message.
+     */
+    bool setStructuredOutput(const QString& path);
+    QString structuredOutput() const;
+
+    /**
+     * @brief Records discarded under OverflowPolicy::Drop
+     */
+    quint64 droppedCount() const { return m_dropped.load(std::memory_order_relaxed); }
+
     // Static convenience
     static Logger* instance();
     static void setInstance(Logger* logger);
 
 private:
-    QString formatMessage(Level level, const QString& tag, const QString& message);
-    static QString levelToString(Level level);
+    class Writer;
+    class StructuredOutput;
+
+    void write(Level level, const QString& tag, const QString& message, qint64 timestampMs);
+    const QString& formatMessage(Level level, const QString& tag, const QString& message,
+                                 qint64 timestampMs);
+    static QLatin1String levelToString(Level level);
+
+    /**
+     * @brief Piece of a compiled format string
+     */
+    struct FormatToken
+    {
+        enum class Kind { Literal, Level, Tag, Message, Time, Date };
+        Kind kind;
+        QString text;  // Literal only
+    };
 
-    Level m_minLevel = Level::Debug;
+    static QList<FormatToken> compileFormat(const QString& format);
+    void updateClock(qint64 timestampMs);
+
+    void updateLevels();
+
+    std::atomic<Level> m_minLevel{Level::Debug};
+    std::atomic<Level> m_lowestLevel{Level::Debug};     // Of m_minLevel and all tag levels
+    std::unique_ptr<std::atomic<Level>[]> m_tagLevels;  // Effective level per LogTags ID
+    QHash<QString, Level> m_tagOverrides;               // Guarded by m_levelMutex
+    std::atomic<bool> m_hasTagOverrides{false};
+    mutable QMutex m_levelMutex;
     QString m_format = "[%level%] [%tag%] %message%";
+    QList<FormatToken> m_tokens = compileFormat(m_format);
+
+    // Formatting state, guarded by m_mutex
+    QString m_line;              // Reused output buffer
+    qint64 m_clockSecond = -1;   // Second the cached strings belong to
+    QString m_secondText;        // "hh:mm:ss" of m_clockSecond
+    QDate m_day;
+    QString m_dateText;          // "yyyy-MM-dd" of m_day
     LogHandler m_handler;
+    std::unique_ptr<FileLogSink> m_fileSink;
+    bool m_consoleOutput = true;
     mutable QMutex m_mutex;
 
+    std::atomic<Writer*> m_writer{nullptr};  // Set while async
+    std::unique_ptr<Writer> m_ownedWriter;   // Outlives stopAsync() for late producers
+    std::vector<std::unique_ptr<Writer>> m_retiredWriters;  // Replaced by startAsync(), stopped
+    std::atomic<quint64> m_dropped{0};
+
+    std::unique_ptr<StructuredOutput> m_structured;
+    const quint64 m_generation;                // Unique per Logger, even at a reused address
+    std::atomic<quint64> m_structuredEpoch{0};  // m_generation while a file is open
+
     static Logger* s_instance;
 };
 
-// Convenience macros
-#define MPF_LOG_TRACE(tag, msg) \
-    if (auto* _logger = mpf::Logger::instance()) _logger->trace(tag, msg)
-#define MPF_LOG_DEBUG(tag, msg) \
-    if (auto* _logger = mpf::Logger::instance()) _logger->debug(tag, msg)
-#define MPF_LOG_INFO(tag, msg) \
-    if (auto* _logger = mpf::Logger::instance()) _logger->info(tag, msg)
-#define MPF_LOG_WARNING(tag, msg) \
-    if (auto* _logger = mpf::Logger::instance()) _logger->warning(tag, msg)
-#define MPF_LOG_ERROR(tag, msg) \
-    if (auto* _logger = mpf::Logger::instance()) _logger->error(tag, msg)
+// Convenience macros. Statements below MPF_LOG_MIN_LEVEL are compiled
+// out; below the runtime level of their tag msg is not evaluated. The tag
+// is interned once per call site, so it must be a string literal (checked
+// at compile time, as in mpf/logger.h).
+#define MPF_LOG_HOST_IMPL_(level, tag, msg) \
+    do { \
+        if constexpr (int(mpf::ILogger::Level::level) >= MPF_LOG_MIN_LEVEL) { \
+            if (auto* _logger = mpf::Logger::instance(); \
+                _logger && _logger->isEnabled(mpf::ILogger::Level::level)) { \
+                static const int _mpf_tag = mpf::LogTags::id(QStringLiteral("" tag "")); \
+                if (_logger->isEnabled(mpf::ILogger::Level::level, _mpf_tag)) { \
+                    _logger->logTagged(mpf::ILogger::Level::level, _mpf_tag, \
+                                       QStringLiteral("" tag ""), msg); \
+                } \
+            } \
+        } \
+    } while (0)
+
+#define MPF_LOG_TRACE(tag, msg)   MPF_LOG_HOST_IMPL_(Trace, tag, msg)
+#define MPF_LOG_DEBUG(tag, msg)   MPF_LOG_HOST_IMPL_(Debug, tag, msg)
+#define MPF_LOG_INFO(tag, msg)    MPF_LOG_HOST_IMPL_(Info, tag, msg)
+#define MPF_LOG_WARNING(tag, msg) MPF_LOG_HOST_IMPL_(Warning, tag, msg)
+#define MPF_LOG_ERROR(tag, msg)   MPF_LOG_HOST_IMPL_(Error, tag, msg)
 
 } // namespace mpf
@@ -3,6 +3,7 @@
 #include "mpf/interfaces/inavigation.h"
 #include <QHash>
 #include <QStack>
+#include <functional>
 
 class QQmlApplicationEngine;
 
@@ -29,6 +30,35 @@ public:
     Q_INVOKABLE bool canGoBack() const override;
     Q_INVOKABLE void registerRoute(const QString& route, const QString& qmlComponent) override;
 
+    /**
+     * @brief Activates a deferred plugin; returns true if it started
+     */
+    using RouteActivator = std::function<bool(const QString& pluginId)>;
+
+    /**
+     * @brief Announce a route whose plugin is not loaded yet
+     *
+     * When push()/replace() finds no registered route, matching deferred
+     * routes activate their plugin, which registers the real route.
+     *
+     * @param route Route pattern, same syntax as registerRoute()
+     * @param pluginId Plugin ID passed to the activator
+     */
+    void registerDeferredRoute(const QString& route, const QString& pluginId);
+
+    /**
+     * @brief Remove all routes registered by a plugin
+     *
+     * Routes are attributed to the plugin active (PluginContext) when
+     * registerRoute() was called.
+     */
+    void unregisterPlugin(const QString& pluginId);
+
+    /**
+     * @brief Set the callback that loads deferred plugins
+     */
+    void setRouteActivator(RouteActivator activator) { m_activator = std::move(activator); }
+
     /**
      * @brief Set the StackView object ID in QML
      */
@@ -41,6 +71,7 @@ signals:
 private:
     QObject* stackView() const;
     QVariant resolveComponent(const QString& route);
+    static bool routeMatches(const QString& pattern, const QString& route);
 
     QQmlApplicationEngine* m_engine;
     QString m_stackViewId = "mainStackView";
@@ -48,8 +79,11 @@ private:
     struct RouteEntry {
         QString pattern;
         QString component;
+        QString owner;  // Registering plugin, empty for the host
     };
     QList<RouteEntry> m_routes;
+    QList<RouteEntry> m_deferredRoutes;  // component holds the plugin ID
+    RouteActivator m_activator;
     
     struct StackEntry {
         QString route;
@@ -0,0 +1,47 @@
+#pragma once
+
+#include "plugin_memory.h"
+
+#include <QString>
+
+namespace mpf {
+
+/**
+ * @brief Tracks which plugin the current thread is running on behalf of
+ *
+ * PluginManager opens a Scope around every IPlugin call; services and
+ * diagnostics use current() to attribute work to a plugin. An empty ID
+ * means the host itself.
+ */
+class PluginContext
+{
+public:
+    /**
+     * @brief ID of the plugin active on this thread, or empty for the host
+     */
+    static QString current();
+
+    /**
+     * @brief RAII guard making a plugin current for this thread
+     *
+     * Also charges the thread's allocations to the plugin (see PluginMemory).
+     */
+    class Scope
+    {
+    public:
+        explicit Scope(const QString& pluginId);
+        ~Scope();
+
+        Scope(const Scope&) = delete;
+        Scope& operator=(const Scope&) = delete;
+
+    private:
+        QString m_previous;
+        PluginMemory::Scope m_memory;
+    };
+
+private:
+    static thread_local QString s_current;
+};
+
+} // namespace mpf
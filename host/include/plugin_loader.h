@@ -3,12 +3,15 @@
 #include <QObject>
 #include <QString>
 #include <QPluginLoader>
+#include <QPointer>
+#include <QElapsedTimer>
 #include <memory>
 
 namespace mpf {
 
 class IPlugin;
 class PluginMetadata;
+class RemotePlugin;
 
 /**
  * @brief Handles loading a single plugin
@@ -22,11 +25,22 @@ public:
         Unloaded,
         Loaded,
         Initialized,
+        Starting,       // startAsync() pending
         Started,
         Error
     };
 
-    explicit PluginLoader(const QString& path, QObject* parent = nullptr);
+    /**
+     * @param path Plugin library path
+     * @param metadata Metadata already read from the library during discovery
+     */
+    PluginLoader(const QString& path, const PluginMetadata& metadata, QObject* parent = nullptr);
+
+    /**
+     * @param plugin Plugin linked into the host (see QPluginLoader::staticPlugins())
+     * @param metadata Metadata read from plugin.metaData()
+     */
+    PluginLoader(const QStaticPlugin& plugin, const PluginMetadata& metadata, QObject* parent = nullptr);
     ~PluginLoader() override;
 
     /**
@@ -53,10 +67,27 @@ public:
     const PluginMetadata& metadata() const { return *m_metadata; }
 
     /**
-     * @brief Get plugin file path
+     * @brief Get plugin file path (":static/<class>" for static plugins)
      */
     QString path() const { return m_path; }
 
+    /**
+     * @brief Check if the plugin is linked into the host
+     */
+    bool isStatic() const { return m_staticPlugin.instance != nullptr; }
+
+    /**
+     * @brief Check if the plugin runs in its own mpf-plugin-host process
+     *
+     * Set by "outOfProcess": true in the metadata; ignored for static plugins.
+     */
+    bool isRemote() const;
+
+    /**
+     * @brief The static plugin, if isStatic()
+     */
+    QStaticPlugin staticPlugin() const { return m_staticPlugin; }
+
     /**
      * @brief Get current state
      */
@@ -77,17 +108,70 @@ public:
      */
     void setState(State state) { m_state = state; }
 
+    /**
+     * @brief Time spent loading the library, -1 if not loaded yet
+     */
+    qint64 loadDurationNs() const { return m_loadNs; }
+
+    /**
+     * @brief Time spent in IPlugin::initialize(), -1 if not run yet
+     */
+    qint64 initializeDurationNs() const { return m_initializeNs; }
+
+    /**
+     * @brief Time until start()/startAsync() completed, -1 if not yet
+     */
+    qint64 startDurationNs() const { return m_startNs; }
+
+    void setInitializeDuration(qint64 ns) { m_initializeNs = ns; }
+    void setStartDuration(qint64 ns) { m_startNs = ns; }
+
+    struct MemoryUsage
+    {
+        qint64 liveBytes = 0;
+        qint64 peakBytes = 0;
+        quint64 allocatedBytes = 0;
+        double allocationRate = 0;  // Bytes per second since the previous sample
+        int objectCount = 0;        // QObjects under the plugin instance, itself included
+    };
+
+    /**
+     * @brief Sample the plugin's heap usage (see PluginMemory)
+     *
+     * Byte counts stay zero unless the host was built with
+     * MPF_MEMORY_TRACKING; objectCount is always filled in. Call on the
+     * plugin's thread.
+     */
+    MemoryUsage sampleMemory();
+
 signals:
     void stateChanged(State state);
     void errorOccurred(const QString& error);
 
+    /**
+     * @brief The out-of-process plugin's child exited on its own
+     *
+     * The state is already Error; the plugin's services are still
+     * registered until PluginManager removes them.
+     */
+    void crashed(const QString& reason);
+
 private:
     QString m_path;
-    std::unique_ptr<QPluginLoader> m_loader;
+    std::unique_ptr<QPluginLoader> m_loader;  // Created on first load()
+    QStaticPlugin m_staticPlugin{nullptr, nullptr};
+    QPointer<QObject> m_staticInstance;
+    std::unique_ptr<RemotePlugin> m_remote;  // Set while an out-of-process plugin is loaded
     std::unique_ptr<PluginMetadata> m_metadata;
     IPlugin* m_plugin = nullptr;
     State m_state = State::Unloaded;
     QString m_errorString;
+    qint64 m_loadNs = -1;
+    qint64 m_initializeNs = -1;
+    qint64 m_startNs = -1;
+    int m_memorySlot = 0;
+    quint64 m_sampledBytes = 0;
+    QElapsedTimer m_sampleTimer;
 };
 
 } // namespace mpf
@@ -1,17 +1,25 @@
 #pragma once
 
+#include "plugin_loader.h"
+
 #include <QObject>
 #include <QString>
 #include <QList>
 #include <QHash>
+#include <QSet>
+#include <QFileInfo>
+#include <QJsonObject>
+#include <QElapsedTimer>
+#include <functional>
 #include <memory>
 #include <vector>
 
 namespace mpf {
 
-class PluginLoader;
 class ServiceRegistry;
 class PluginMetadata;
+class PluginMetadataCache;
+class PluginWatchdog;
 class IPlugin;
 
 /**
@@ -27,29 +35,139 @@ public:
 
     /**
      * @brief Discover plugins in a directory
+     *
+     * Metadata is read from all candidate files in parallel; plugins are
+     * then registered in file name order, so results (including which of
+     * two duplicate IDs wins) don't depend on thread timing.
+     *
      * @param path Directory path to scan
      * @return Number of plugins found
      */
     int discover(const QString& path);
 
+    /**
+     * @brief Discover plugins linked into the host
+     *
+     * Registers the IPlugin instances imported with Q_IMPORT_PLUGIN (see
+     * the MPF_STATIC_PLUGINS build option). They go through the same
+     * lifecycle as dynamic plugins; call before discover() so a static
+     * plugin wins over a library with the same ID.
+     *
+     * @return Number of plugins found
+     */
+    int discoverStatic();
+
+    /**
+     * @brief Use a persistent metadata cache for discover()
+     *
+     * Unchanged plugin files are then not opened at all. Must be called
+     * before discover().
+     *
+     * @param filePath Cache file location
+     * @param rescan Ignore existing cache contents and re-read every plugin
+     */
+    void setMetadataCache(const QString& filePath, bool rescan = false);
+
+    /**
+     * @brief Metadata cache in use, or nullptr
+     */
+    PluginMetadataCache* metadataCache() const { return m_metadataCache.get(); }
+
     /**
      * @brief Load all discovered plugins
+     *
+     * Deferred plugins (see deferredPlugins()) are skipped; they are
+     * brought up later by activate().
+     *
      * @return true if all required plugins loaded successfully
      */
     bool loadAll();
 
+    /**
+     * @brief Load, initialize and start a plugin and its dependencies now
+     * @param id Plugin ID
+     * @return true if the plugin is running
+     */
+    bool activate(const QString& id);
+
+    /**
+     * @brief Stop and unload a plugin and everything depending on it
+     *
+     * Dependents are stopped first, in reverse load order. For each plugin
+     * its event bus subscriptions, menu items, routes and registered
+     * services are removed before its library is unloaded. The plugins stay
+     * known and can be brought back with activate().
+     *
+     * @param id Plugin ID
+     * @return true if the plugin was known
+     */
+    bool unload(const QString& id);
+
+    /**
+     * @brief Swap in a new build of a plugin without restarting the host
+     *
+     * Re-reads the library's metadata from disk, unloads the plugin and its
+     * dependents like unload(), then loads, initializes and starts again
+     * those of them that were loaded before. If the library no longer
+     * provides the plugin, nothing is unloaded.
+     *
+     * @param id Plugin ID
+     * @return true if all affected plugins came back up
+     */
+    bool reload(const QString& id);
+
+    /**
+     * @brief Plugins not loaded at startup
+     *
+     * Those with loadOnStartup=false that no startup plugin requires,
+     * directly or indirectly.
+     */
+    QStringList deferredPlugins() const;
+
+    /**
+     * @brief Let the first use of plugins' routes and services activate them
+     *
+     * Registers each plugin's "routes" and "provides" as deferred stubs with
+     * NavigationService and the service registry, whose activators (set up
+     * by the host) call activate(). Loaded plugins are skipped. Used for
+     * deferredPlugins() at startup; unload() and reload() re-announce the
+     * plugins they leave unloaded.
+     */
+    void announceDeferred(const QStringList& ids);
+
     /**
      * @brief Initialize all loaded plugins (dependency resolution)
+     *
+     * Runs in waves, one per dependency level. Within a wave, plugins whose
+     * metadata sets concurrentInit run on a thread pool while the others
+     * run on the calling thread; the next wave starts once all are done.
+     * Plugins whose required dependencies failed are skipped and reported
+     * through pluginError().
+     *
      * @return true if all plugins initialized successfully
      */
     bool initializeAll();
 
     /**
      * @brief Start all initialized plugins
+     *
+     * Same wave scheme as initializeAll(), using concurrentStart. Plugins
+     * whose metadata sets asyncStart are started through startAsync(); they
+     * stay in the Starting state, and their dependents are held back, until
+     * the returned future completes.
+     *
      * @return true if all plugins started successfully
      */
     bool startAll();
 
+    /**
+     * @brief Time budgets for initialize() and start()/startAsync()
+     *
+     * A plugin still running a phase past its budget is logged by a
+     * watchdog thread, and budgetExceeded() is emitted. 0 disables a check.
+     */
+    void setBudgets(int initializeMs, int startMs);
+
     /**
      * @brief Stop all running plugins
      */
@@ -82,17 +200,56 @@ public:
 
     /**
      * @brief Check if all dependencies are satisfied
+     *
+     * A required service is satisfied by a discovered plugin listing it in
+     * "provides", or by a service the host has registered.
+     *
      * @param metadata Plugin metadata to check
      * @return List of unsatisfied dependencies (empty if all satisfied)
      */
     QStringList checkDependencies(const PluginMetadata& metadata) const;
 
+    /**
+     * @brief Plugin providing a service, per the discovered metadata
+     *
+     * When several plugins provide it, those loaded at startup are
+     * preferred, then by priority and ID.
+     *
+     * @param serviceName Name as listed in "provides"/"requires"
+     * @return Plugin ID, or empty if no discovered plugin provides it
+     */
+    QString serviceProvider(const QString& serviceName) const;
+
     /**
      * @brief Get load order respecting dependencies
+     *
+     * Dependencies, including the providers of required services, come
+     * first; ties are broken by metadata priority
+     * (smaller first), then by ID. Plugins in or behind a dependency cycle
+     * are left out. Computed once and cached until the plugin set changes.
+     *
      * @return Ordered list of plugin IDs
      */
     QStringList loadOrder() const;
 
+    /**
+     * @brief Plugins excluded from the load order by dependency cycles
+     */
+    QStringList cyclicPlugins() const;
+
+    /**
+     * @brief Each dependency cycle separately, members sorted by ID
+     */
+    QList<QStringList> dependencyCycles() const;
+
+    /**
+     * @brief Human-readable dump of per-plugin memory usage
+     *
+     * Samples every loaded plugin (see PluginLoader::sampleMemory()), so
+     * allocation rates cover the time since the previous report.
+     */
+    QString memoryReport();
+
 signals:
     void pluginDiscovered(const QString& id);
     void pluginLoaded(const QString& id);
@@ -102,15 +259,98 @@ signals:
     void pluginUnloaded(const QString& id);
     void pluginError(const QString& id, const QString& error);
 
+    /**
+     * @brief A dependency level finished initializing or starting
+     * @param phase "initialize" or "start"
+     * @param wave Dependency level, 0 = no dependencies
+     * @param pluginIds Plugins run in this wave
+     * @param elapsedMs Wall time of the wave
+     */
+    void waveFinished(const QString& phase, int wave,
+                      const QStringList& pluginIds, qint64 elapsedMs);
+
+    /**
+     * @brief A deferred plugin was brought up on demand
+     * @param id Plugin ID
+     * @param elapsedMs Time spent loading, initializing and starting it
+     *        (including dependencies)
+     */
+    void pluginActivated(const QString& id, qint64 elapsedMs);
+
+    /**
+     * @brief unload() or reload() finished
+     * @param id Plugin ID
+     * @param affected The plugin and its dependents, in load order
+     * @param elapsedMs Time from stopping the first dependent until the
+     *        subgraph was running again (or unloaded, for unload())
+     */
+    void pluginSwapped(const QString& id, const QStringList& affected, qint64 elapsedMs);
+
+    /**
+     * @brief A plugin overran its budget for a lifecycle phase
+     * @param phase "initialize", "start" or "startAsync"
+     */
+    void budgetExceeded(const QString& id, const QString& phase, int budgetMs);
+
 private:
-    QStringList computeLoadOrder() const;
-    bool topologicalSort(const QString& id, 
-                         QHash<QString, int>& state, 
-                         QStringList& order) const;
+    using WavePredicate = std::function<bool(PluginLoader*)>;
+    using WaveStep = std::function<bool(const QString& id, PluginLoader*)>;
+    using WaveResult = std::function<void(const QString& id, PluginLoader*, bool ok,
+                                          qint64 elapsedNs)>;
+
+    bool runInWaves(const char* phase, const WavePredicate& eligible,
+                    const WavePredicate& concurrent, const WaveStep& step,
+                    const WaveResult& finished);
+    bool runStep(const char* phase, const QString& id, PluginLoader* loader,
+                 const WaveStep& step, qint64* elapsedNs);
+    bool beginAsyncStart(const QString& id, PluginLoader* loader);
+    void finishAsyncStart(const QString& id, bool ok);
+    void startWaitingDependents(const QString& id);
+    void cancelAsyncStart(const QString& id);
+    bool hasStartingDependency(PluginLoader* loader) const;
+    QString failedDependency(PluginLoader* loader, PluginLoader::State reached) const;
+    static bool isRunning(PluginLoader* loader);
+    QJsonObject readMetadata(const QFileInfo& info) const;
+    QJsonObject rereadMetadata(const QString& path) const;
+    bool addPlugin(std::unique_ptr<PluginLoader> loader);
+    QHash<QString, QStringList> buildProviderIndex() const;
+    QStringList dependencyIds(const PluginMetadata& metadata, bool includeOptional) const;
+    QSet<QString> rejectUnresolvable(const QStringList& ids);
+    bool hostProvides(const QString& serviceName) const;
+    bool bringUp(const QString& id);
+    QStringList dependentClosure(const QString& id) const;
+    void tearDown(const QStringList& ids);
+    void watchCrashes(PluginLoader* loader);
+    QSet<QString> requiredClosure(const QStringList& ids) const;
+    void ensureOrder() const;
+    void invalidateOrder();
+    void reportCycles();
+
+    /**
+     * @brief Cached result of ensureOrder()
+     */
+    struct Ordering
+    {
+        bool valid = false;
+        QStringList order;           // Full load order
+        QList<QStringList> levels;   // Same plugins grouped by dependency level
+        QList<QStringList> cycles;   // Strongly connected components, one per cycle
+        QStringList cyclic;          // Plugins on a dependency cycle
+        QStringList blocked;         // Plugins depending on a cycle
+        QHash<QString, QStringList> providers;  // Service -> providing plugins, preferred first
+        bool reported = false;       // pluginError emitted for cyclic/blocked
+    };
 
     ServiceRegistry* m_registry;
     std::vector<std::unique_ptr<PluginLoader>> m_loaders;
     QHash<QString, PluginLoader*> m_pluginMap;
+    std::unique_ptr<PluginMetadataCache> m_metadataCache;
+    mutable Ordering m_ordering;
+    std::unique_ptr<PluginWatchdog> m_watchdog;
+    QHash<QString, QElapsedTimer> m_asyncStarts;  // startAsync() pending, by plugin ID
+    int m_initializeBudgetMs = 500;
+    int m_startBudgetMs = 500;
+    bool m_inWaves = false;
 };
 
 } // namespace mpf
@@ -0,0 +1,94 @@
+#pragma once
+
+#include <QString>
+#include <QtGlobal>
+#include <cstddef>
+
+namespace mpf {
+
+/**
+ * @brief Per-plugin heap accounting
+ *
+ * Built with the MPF_MEMORY_TRACKING CMake option, the host replaces the
+ * global operator new/delete. Every allocation is tagged with the plugin
+ * active on the allocating thread: the one set by PluginContext::Scope, or
+ * by PluginMemory::Scope around service calls. A free is charged back to
+ * the plugin that made the allocation, whichever thread frees it.
+ *
+ * Limitation: a service called directly through the pointer returned by
+ * ServiceRegistry::get<T>() runs in its caller's scope, so what it
+ * allocates during the call is charged to the caller. Only calls through
+ * ServiceRegistry::proxy<T>() switch to the provider's slot. Over-aligned
+ * new is not counted at all (see plugin_memory.cpp).
+ *
+ * The cost per allocation is a thread-local read and a few relaxed atomic
+ * adds on per-plugin counters, which is low enough for staging builds.
+ * Without the option all counters stay zero.
+ */
+class PluginMemory
+{
+public:
+    static constexpr int MaxSlots = 256;  // Slot 0 is the host
+
+    struct Usage
+    {
+        qint64 liveBytes = 0;
+        qint64 peakBytes = 0;
+        quint64 allocatedBytes = 0;  // Cumulative
+        quint64 allocations = 0;     // Cumulative
+    };
+
+    /**
+     * @brief Check whether the host was built with allocation tracking
+     */
+    static constexpr bool isEnabled()
+    {
+#ifdef MPF_MEMORY_TRACKING
+        return true;
+#else
+        return false;
+#endif
+    }
+
+    /**
+     * @brief Slot for a plugin, assigned on first use
+     * @return Slot index; 0 for the host (empty ID or "host") or when slots run out
+     */
+    static int slotFor(const QString& pluginId);
+
+    /**
+     * @brief Plugin ID of a slot, empty for the host
+     */
+    static QString pluginId(int slot);
+
+    /**
+     * @brief Counters of a slot
+     */
+    static Usage usage(int slot);
+
+    /**
+     * @brief RAII guard charging this thread's allocations to a slot
+     */
+    class Scope
+    {
+    public:
+        explicit Scope(int slot);
+        ~Scope();
+
+        Scope(const Scope&) = delete;
+        Scope& operator=(const Scope&) = delete;
+
+    private:
+        int m_previous;
+    };
+
+    // Used by the replaced operator new/delete
+    static int currentSlot();
+    static void recordAllocation(int slot, std::size_t size);
+    static void recordFree(int slot, std::size_t size);
+
+private:
+    static thread_local int s_slot;
+};
+
+} // namespace mpf
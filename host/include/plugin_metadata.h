@@ -55,11 +55,24 @@ public:
     QStringList provides() const { return m_provides; }
     QStringList qmlModules() const { return m_qmlModules; }
     QString entryQml() const { return m_entryQml; }
+    QStringList routes() const { return m_routes; }  // Routes registered in initialize()
 
     // Loading hints
     int priority() const { return m_priority; }
     bool loadOnStartup() const { return m_loadOnStartup; }
 
+    // Threading hints: plugin may be initialized/started on a pool thread,
+    // concurrently with other plugins of the same dependency level
+    bool concurrentInit() const { return m_concurrentInit; }
+    bool concurrentStart() const { return m_concurrentStart; }
+
+    // Start through IPlugin::startAsync(); dependents wait for its future
+    bool asyncStart() const { return m_asyncStart || m_outOfProcess; }
+
+    // Run in a separate mpf-plugin-host process; services are reached
+    // through IRemoteService (implies asyncStart)
+    bool outOfProcess() const { return m_outOfProcess; }
+
     // Raw JSON
     QJsonObject toJson() const { return m_json; }
 
@@ -82,9 +95,14 @@ private:
     QStringList m_provides;
     QStringList m_qmlModules;
     QString m_entryQml;
+    QStringList m_routes;
     
     int m_priority = 0;
     bool m_loadOnStartup = true;
+    bool m_concurrentInit = false;
+    bool m_concurrentStart = false;
+    bool m_asyncStart = false;
+    bool m_outOfProcess = false;
     
     QJsonObject m_json;
 };
@@ -0,0 +1,102 @@
+#pragma once
+
+#include <QFileInfo>
+#include <QHash>
+#include <QJsonObject>
+#include <QMutex>
+#include <QString>
+#include <atomic>
+
+namespace mpf {
+
+/**
+ * @brief Persistent cache of plugin metadata
+ *
+ * Maps plugin file paths to the metadata embedded in them, so warm starts
+ * can skip opening unchanged libraries. Entries are validated by file size
+ * and modification time, plus a content hash if verifyHash is enabled.
+ * Stored as a compact binary file (QDataStream, metadata as CBOR).
+ *
+ * lookup() and insert() are thread-safe.
+ */
+class PluginMetadataCache
+{
+public:
+    explicit PluginMetadataCache(const QString& filePath);
+    ~PluginMetadataCache();
+
+    /**
+     * @brief Read the cache file
+     * @return false if it is missing, corrupt or of another format version
+     */
+    bool load();
+
+    /**
+     * @brief Write the cache file if anything changed since load()
+     */
+    bool save();
+
+    /**
+     * @brief Drop all entries, forcing every plugin to be re-read
+     */
+    void clear();
+
+    /**
+     * @brief Also compare a content hash (reads the whole file on lookup)
+     */
+    void setVerifyHash(bool verify) { m_verifyHash = verify; }
+    bool verifyHash() const { return m_verifyHash; }
+
+    /**
+     * @brief Get cached metadata for a file if it is unchanged
+     * @param info Plugin file
+     * @param metadata Receives the cached "MetaData" object on a hit
+     * @return true on a cache hit
+     */
+    bool lookup(const QFileInfo& info, QJsonObject* metadata);
+
+    /**
+     * @brief Store freshly read metadata for a file
+     */
+    void insert(const QFileInfo& info, const QJsonObject& metadata);
+
+    /**
+     * @brief Forget one file, so its next lookup() misses
+     * @param path Absolute path of the plugin file
+     */
+    void remove(const QString& path);
+
+    /**
+     * @brief Remove entries in a directory that are not in the given list
+     * @param dirPath Scanned directory
+     * @param livePaths Absolute paths of the files currently present
+     */
+    void prune(const QString& dirPath, const QStringList& livePaths);
+
+    QString filePath() const { return m_filePath; }
+    int hits() const { return m_hits.load(std::memory_order_relaxed); }
+    int misses() const { return m_misses.load(std::memory_order_relaxed); }
+
+private:
+    struct Entry
+    {
+        qint64 size = -1;
+        qint64 mtime = 0;     // ms since epoch
+        QByteArray hash;      // Empty unless verifyHash was enabled
+        QJsonObject metadata;
+    };
+
+    static QByteArray contentHash(const QString& path);
+
+    QString m_filePath;
+    bool m_verifyHash = false;
+
+    QMutex m_mutex;
+    QHash<QString, Entry> m_entries;
+    bool m_dirty = false;
+
+    std::atomic<int> m_hits{0};
+    std::atomic<int> m_misses{0};
+};
+
+} // namespace mpf
@@ -0,0 +1,74 @@
+#pragma once
+
+#include <QElapsedTimer>
+#include <QHash>
+#include <QMutex>
+#include <QThread>
+#include <QWaitCondition>
+
+namespace mpf {
+
+/**
+ * @brief Flags plugins whose lifecycle calls overrun their time budget
+ *
+ * Runs on its own thread, so a plugin blocking the main thread is
+ * reported while it is still stuck, not only after it returns.
+ * arm()/disarm() may be called from any thread.
+ */
+class PluginWatchdog : public QThread
+{
+    Q_OBJECT
+
+public:
+    explicit PluginWatchdog(QObject* parent = nullptr);
+    ~PluginWatchdog() override;
+
+    /**
+     * @brief Start timing a plugin phase
+     * @param pluginId Plugin ID
+     * @param phase Phase name, e.g. "initialize"
+     * @param budgetMs Allowed time; 0 or less disables the check
+     */
+    void arm(const QString& pluginId, const QString& phase, int budgetMs);
+
+    /**
+     * @brief Stop timing a plugin phase
+     * @return Elapsed time in nanoseconds, -1 if it was not armed
+     */
+    qint64 disarm(const QString& pluginId, const QString& phase);
+
+    /**
+     * @brief Stop the watchdog thread
+     */
+    void shutdown();
+
+signals:
+    /**
+     * @brief A phase is still running past its budget (emitted once per arm)
+     *
+     * Emitted on the watchdog thread.
+     */
+    void budgetExceeded(const QString& pluginId, const QString& phase, int budgetMs);
+
+protected:
+    void run() override;
+
+private:
+    struct Watch
+    {
+        QString pluginId;
+        QString phase;
+        qint64 startNs;
+        qint64 deadlineNs;  // -1 = no budget
+        int budgetMs;
+        bool reported = false;
+    };
+
+    QElapsedTimer m_clock;
+    QMutex m_mutex;
+    QWaitCondition m_wake;
+    QHash<QString, Watch> m_watches;  // pluginId + '/' + phase
+    bool m_stopping = false;
+};
+
+} // namespace mpf
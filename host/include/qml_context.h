@@ -14,6 +14,7 @@ class ISettings;
 class ITheme;
 class IMenu;
 class IEventBus;
+class ServiceStatsModel;
 
 /**
  * @brief Sets up QML context with services
@@ -30,6 +31,7 @@ class QmlContext : public QObject
     Q_PROPERTY(QObject* theme READ theme CONSTANT)
     Q_PROPERTY(QObject* appMenu READ appMenu CONSTANT)
     Q_PROPERTY(QObject* eventBus READ eventBus CONSTANT)
+    Q_PROPERTY(QObject* serviceStats READ serviceStats CONSTANT)
 
 public:
     explicit QmlContext(ServiceRegistry* registry, QObject* parent = nullptr);
@@ -46,9 +48,11 @@ public:
     QObject* theme() const;
     QObject* appMenu() const;
     QObject* eventBus() const;
+    QObject* serviceStats() const;
 
 private:
     ServiceRegistryImpl* m_registry;
+    ServiceStatsModel* m_serviceStats;
 };
 
 } // namespace mpf
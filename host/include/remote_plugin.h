@@ -0,0 +1,141 @@
+#pragma once
+
+#include "ipc_channel.h"
+#include <mpf/interfaces/iplugin.h>
+#include <mpf/interfaces/iremoteservice.h>
+
+#include <QHash>
+#include <QJsonObject>
+#include <QList>
+#include <QObject>
+#include <QPointer>
+#include <QPromise>
+#include <QStringList>
+#include <memory>
+
+class QLocalServer;
+class QLocalSocket;
+class QProcess;
+
+namespace mpf {
+
+class EventBusService;
+class ServiceRegistryImpl;
+
+/**
+ * @brief Host-side stand-in for a plugin running in mpf-plugin-host
+ *
+ * Created by PluginLoader for plugins whose metadata sets
+ * "outOfProcess": true. load() spawns the child process, which loads the
+ * real library; the lifecycle calls are forwarded over an IpcChannel. A
+ * crash of the child only takes down this plugin: pending calls are
+ * canceled and its services report isConnected() == false.
+ *
+ * The child is only trusted once its Hello carries the random token passed
+ * on its command line; other processes of the same user that connect to
+ * the server first are dropped. stop() does not wait for the child: it
+ * asks it to exit and kills it if it is still running StopTimeoutMs later.
+ *
+ * For each name in "provides" a RemoteServiceProxy is registered, reachable
+ * through ServiceRegistry::remote(). Events are bridged both ways; the host
+ * only forwards topics matching the child's subscriptions.
+ */
+class RemotePlugin : public QObject, public IPlugin
+{
+    Q_OBJECT
+    Q_INTERFACES(mpf::IPlugin)
+
+public:
+    RemotePlugin(const QString& libraryPath, const QJsonObject& metadata, QObject* parent = nullptr);
+    ~RemotePlugin() override;
+
+    /**
+     * @brief Spawn mpf-plugin-host for the library
+     * @return false if the local server could not listen
+     */
+    bool launch();
+
+    // IPlugin
+    bool initialize(ServiceRegistry* registry) override;
+    bool start() override;
+    QFuture<bool> startAsync() override;
+    void stop() override;
+    QJsonObject metadata() const override { return m_metadata; }
+
+    /**
+     * @brief Send a call to a service in the child; callable from any thread
+     * @param wantReply false for fire-and-forget calls
+     */
+    QFuture<QVariant> call(const QString& service, const QString& method,
+                           const QVariantList& args, bool wantReply = true);
+
+    bool isConnected() const;
+
+    /**
+     * @brief Path of the mpf-plugin-host executable
+     */
+    static QString hostExecutable();
+
+signals:
+    /**
+     * @brief The child exited without being stopped
+     */
+    void crashed(const QString& reason);
+
+private:
+    void onNewConnection();
+    void onHandshake(QLocalSocket* socket, IpcChannel* channel, const IpcMessage& message);
+    void waitForExit();
+    void onMessage(const IpcMessage& message);
+    void onHostEvent(const QString& topic, const QVariantMap& data, const QString& senderId);
+    void onProcessFinished();
+    void send(const IpcMessage& message);
+    void dispatchCall(IpcMessage message, const std::shared_ptr<QPromise<QVariant>>& promise);
+    void setSubscriptions(const QStringList& patterns);
+    void failPending(const QString& reason);
+
+    QString m_libraryPath;
+    QJsonObject m_metadata;
+    QString m_pluginId;
+    QString m_token;  // Proves a connection comes from the child we spawned
+
+    QLocalServer* m_server = nullptr;
+    QProcess* m_process = nullptr;
+    QLocalSocket* m_socket = nullptr;
+    IpcChannel* m_channel = nullptr;
+    QList<IpcMessage> m_backlog;  // Sent before the child connected
+
+    ServiceRegistryImpl* m_registry = nullptr;
+    QPointer<EventBusService> m_eventBus;
+    QStringList m_subscriptions;
+    bool m_relaying = false;
+    bool m_stopping = false;
+
+    std::shared_ptr<QPromise<bool>> m_startPromise;
+    QHash<quint64, std::shared_ptr<QPromise<QVariant>>> m_pending;
+    quint64 m_nextCallId = 1;
+};
+
+/**
+ * @brief IRemoteService registered for one service of a RemotePlugin
+ *
+ * Callable from any thread; RemotePlugin::call() does the marshalling.
+ */
+class RemoteServiceProxy : public QObject, public IRemoteService
+{
+    Q_OBJECT
+
+public:
+    RemoteServiceProxy(const QString& serviceName, RemotePlugin* owner);
+
+    QString serviceName() const override { return m_serviceName; }
+    QFuture<QVariant> call(const QString& method, const QVariantList& args = {}) override;
+    void post(const QString& method, const QVariantList& args = {}) override;
+    bool isConnected() const override;
+
+private:
+    QString m_serviceName;
+    QPointer<RemotePlugin> m_owner;
+};
+
+} // namespace mpf
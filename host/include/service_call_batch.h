@@ -0,0 +1,107 @@
+#pragma once
+
+#include "service_stats.h"
+#include <mpf/service_proxy.h>
+#include <QHash>
+#include <QMutex>
+#include <QObject>
+#include <QPointer>
+#include <QString>
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+namespace mpf {
+
+/**
+ * @brief Per-service queue that flushes proxied calls on the owner thread
+ *
+ * The first enqueue after a flush posts a single queued invocation to the
+ * target object; everything queued until it runs is executed in that one
+ * batch. Fire-and-forget calls with the same coalesce key are collapsed.
+ */
+class ServiceCallBatch : public ServiceCallQueue,
+                         public std::enable_shared_from_this<ServiceCallBatch>
+{
+public:
+    explicit ServiceCallBatch(QObject* target);
+    ~ServiceCallBatch() override;
+
+    void enqueue(std::function<void()> call, quint64 coalesceKey = 0) override;
+
+    /**
+     * @brief Queue a call whose coalesce key only matches calls of the same scope
+     *
+     * Every proxy queues under its own scope, so unrelated callers that
+     * happen to pick the same key never replace each other's calls.
+     */
+    void enqueue(quint64 scope, std::function<void()> call, quint64 coalesceKey);
+
+    /**
+     * @brief Drop pending calls and stop posting to the target
+     *
+     * Called by the registry when the service is removed.
+     */
+    void detach();
+
+    quint64 flushCount() const { return m_flushes.load(std::memory_order_relaxed); }
+    quint64 callCount() const { return m_calls.load(std::memory_order_relaxed); }
+    quint64 coalescedCount() const { return m_coalesced.load(std::memory_order_relaxed); }
+
+private:
+    using Key = std::pair<quint64, quint64>;  // scope, coalesceKey
+
+    struct PendingCall {
+        std::function<void()> call;
+        Key key;
+    };
+
+    void flush();
+
+    QMutex m_mutex;
+    QPointer<QObject> m_target;
+    std::vector<PendingCall> m_pending;
+    QHash<Key, size_t> m_keyIndex;  // -> index in m_pending
+    bool m_flushScheduled = false;
+
+    std::atomic<quint64> m_flushes{0};
+    std::atomic<quint64> m_calls{0};
+    std::atomic<quint64> m_coalesced{0};
+};
+
+/**
+ * @brief Per-proxy view of a ServiceCallBatch
+ *
+ * Forwards to the instance's shared batch under its own coalescing scope
+ * and, while service statistics are enabled, times each call and charges
+ * it to the plugin that created the proxy. With memory tracking,
+ * allocations made by a call are charged to the plugin providing the
+ * service.
+ */
+class ServiceCallChannel : public ServiceCallQueue
+{
+public:
+    ServiceCallChannel(std::shared_ptr<ServiceCallBatch> batch,
+                       const QString& interfaceName, std::shared_ptr<ServiceStats> stats,
+                       int providerSlot = 0);
+
+    void enqueue(std::function<void()> call, quint64 coalesceKey = 0) override;
+    void execute(const std::function<void()>& call) override;
+
+private:
+    const std::shared_ptr<ServiceStats::Counters>& counters();
+
+    std::shared_ptr<ServiceCallBatch> m_batch;
+    const quint64 m_scope;
+    const QString m_interfaceName;
+    const QString m_consumer;  // Plugin current when the proxy was created
+    std::shared_ptr<ServiceStats> m_stats;
+    std::shared_ptr<ServiceStats::Counters> m_counters;  // Resolved on first use
+    std::once_flag m_countersOnce;
+    int m_providerSlot;
+};
+
+} // namespace mpf
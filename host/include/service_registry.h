@@ -1,24 +1,57 @@
 #pragma once
 
+#include "service_stats.h"
 #include <mpf/service_registry.h>
 #include <QObject>
 #include <QString>
 #include <QHash>
+#include <QList>
 #include <QMutex>
+#include <QPromise>
+#include <atomic>
 #include <typeinfo>
 #include <memory>
+#include <mutex>
+#include <optional>
 
 namespace mpf {
 
+class ServiceCallBatch;
+
 /**
- * @brief Service registration entry
+ * @brief Deferred construction state of a lazily registered service
+ */
+struct LazyServiceState
+{
+    std::function<QObject*()> create;
+    std::once_flag once;
+    QObject* instance = nullptr;
+    bool owned = false;  // Created without a parent, deleted with the state
+
+    ~LazyServiceState();
+};
+
+/**
+ * @brief Per-provider usage counters
+ */
+struct ServiceCounters
+{
+    std::atomic<quint64> calls{0};      // Times the provider was selected
+    std::atomic<int> outstanding{0};    // Live ServiceHandle leases
+};
+
+/**
+ * @brief Service registration entry (one per provider)
  */
 struct ServiceEntry
 {
     QString interfaceName;
     int version;
-    QObject* instance;
+    QObject* instance;   // nullptr until a lazy service is first requested
     QString providerId;  // Plugin that provides this service
+    int rank = 0;        // Higher rank is preferred
+    std::shared_ptr<LazyServiceState> lazy;  // Set for addFactory() registrations
+    std::shared_ptr<ServiceCounters> counters = std::make_shared<ServiceCounters>();
 };
 
 /**
@@ -100,6 +133,25 @@ public:
         removeService(typeid(T).name());
     }
 
+    /**
+     * @brief Register a service under a plain name instead of a C++ type
+     *
+     * Used for services of out-of-process plugins, which are found with
+     * ServiceRegistry::remote() by the name listed in "provides".
+     */
+    bool addNamedService(const QString& name, QObject* instance, int version, const QString& providerId);
+
+    /**
+     * @brief Remove every provider registered by a plugin
+     *
+     * Used before unloading a plugin library. Lazily created instances owned
+     * by the registry are deleted; pending proxied calls are dropped.
+     *
+     * @param providerId Plugin ID given at registration
+     * @return Number of providers removed
+     */
+    int removeServicesFrom(const QString& providerId);
+
     /**
      * @brief Get all registered service names
      * @return List of service type names
@@ -109,9 +161,78 @@ public:
     /**
      * @brief Get service entry details
      * @param interfaceName Type name of interface
-     * @return Service entry or nullptr if not found
+     * @return Copy of the highest-ranked provider entry, empty if not found
+     */
+    std::optional<ServiceEntry> entry(const QString& interfaceName) const;
+
+    /**
+     * @brief Get all providers of an interface, highest rank first
+     * @param interfaceName Type name of interface
+     */
+    QList<ServiceEntry> providers(const QString& interfaceName) const;
+
+    /**
+     * @brief Activates a deferred plugin; returns true if it started
+     */
+    using ProviderActivator = std::function<bool(const QString& providerId)>;
+
+    /**
+     * @brief Announce a service that a not-yet-loaded plugin will provide
+     *
+     * The first get()/acquire() of a matching interface calls the provider
+     * activator, which is expected to load the plugin so that it registers
+     * the real service, and then retries. has() reports deferred services
+     * as available without activating them; when() waits passively.
+     *
+     * @param serviceName Name as listed in the plugin's "provides"; matched
+     *        against the demangled interface name with or without namespace
+     * @param providerId Plugin ID passed to the activator
      */
-    const ServiceEntry* entry(const QString& interfaceName) const;
+    void addDeferredProvider(const QString& serviceName, const QString& providerId);
+
+    /**
+     * @brief Drop all deferred services of a plugin
+     */
+    void removeDeferredProviders(const QString& providerId);
+
+    /**
+     * @brief Set the callback that loads deferred plugins
+     */
+    void setProviderActivator(ProviderActivator activator);
+
+    /**
+     * @brief Per-(consumer, interface) usage counters
+     *
+     * Collection is off until stats().setEnabled(true).
+     */
+    ServiceStats& stats() { return *m_stats; }
+
+    /**
+     * @brief Check for a registered service by its plain name
+     *
+     * Matches the raw key, the demangled name, or the name without
+     * namespace, so "INavigation" finds mpf::INavigation.
+     */
+    bool hasServiceNamed(const QString& name) const;
+
+    /**
+     * @brief Get a service by its plain name, matched like hasServiceNamed()
+     * @return Highest-ranked provider or nullptr
+     */
+    QObject* serviceNamed(const QString& name);
+
+    /**
+     * @brief Human-readable dump of providers and usage counters
+     */
+    QString registryStats() const;
+
+    /**
+     * @brief Readable form of a registered type name
+     *
+     * Demangles typeid names where the ABI allows it, e.g.
+     * "N3mpf11INavigationE" becomes "mpf::INavigation".
+     */
+    static QString displayName(const QString& interfaceName);
 
     /**
      * @brief Get service as QObject* directly (for QML exposure)
@@ -138,14 +259,57 @@ protected:
     QObject* getService(const char* typeName, int minVersion) override;
     bool addService(const char* typeName, QObject* instance, 
                     int version, const QString& providerId) override;
+    bool addServiceFactory(const char* typeName, ServiceFactory factory,
+                           int version, const QString& providerId) override;
     bool hasService(const char* typeName, int minVersion) const override;
+    QFuture<QObject*> whenService(const char* typeName, int minVersion) override;
+    bool addServiceProvider(const char* typeName, QObject* instance, int rank,
+                            int version, const QString& providerId) override;
+    void setServiceSelectionPolicy(const char* typeName, SelectionPolicy policy) override;
+    QObject* acquireService(const char* typeName, int minVersion) override;
+    void releaseService(const char* typeName, QObject* instance, qint64 heldNs) override;
+    std::shared_ptr<ServiceCallQueue> callQueue(const char* typeName, QObject* instance) override;
+
+private slots:
+    void resolveWaiters(const QString& interfaceName);
 
 private:
+    /**
+     * @brief Pending when<T>() request
+     */
+    struct ServiceWaiter
+    {
+        int minVersion;
+        std::shared_ptr<QPromise<QObject*>> promise;
+    };
+
+    /**
+     * @brief All providers of one interface
+     */
+    struct ServiceSlot
+    {
+        QList<ServiceEntry> providers;  // Sorted by rank, highest first
+        SelectionPolicy policy = SelectionPolicy::Ranked;
+        quint64 cursor = 0;             // RoundRobin position
+    };
+
+    QObject* lookup(const QString& name, int minVersion, bool lease = false);
+    bool activateDeferred(const QString& name);
+    QString deferredProvider(const QString& name) const;
+    ServiceEntry* select(ServiceSlot& slot, int minVersion);
+    bool insertEntry(ServiceEntry entry, bool exclusive);
+    QObject* instantiate(const QString& name, const std::shared_ptr<LazyServiceState>& lazy);
+    static int maxVersion(const ServiceSlot& slot);
     int serviceVersion(const char* typeName) const;
     void removeService(const char* typeName);
 
     mutable QMutex m_mutex;
-    QHash<QString, ServiceEntry> m_services;
+    QHash<QString, ServiceSlot> m_services;
+    QHash<QString, QList<ServiceWaiter>> m_waiters;  // interfaceName -> pending when<T>()
+    QHash<QObject*, std::shared_ptr<ServiceCallBatch>> m_callQueues;  // instance -> proxy batch
+    std::shared_ptr<ServiceStats> m_stats;  // Shared with proxies, which may outlive the registry
+    QHash<QString, QString> m_deferred;  // provided service name -> plugin ID
+    ProviderActivator m_activator;
 };
 
 } // namespace mpf
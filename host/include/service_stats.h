@@ -0,0 +1,140 @@
+#pragma once
+
+#include <QHash>
+#include <QList>
+#include <QReadWriteLock>
+#include <QString>
+#include <array>
+#include <atomic>
+#include <memory>
+#include <utility>
+
+namespace mpf {
+
+/**
+ * @brief Per-(consumer, interface) service usage counters
+ *
+ * Disabled by default. While disabled every record call returns after a
+ * single relaxed load. Counters are split into cache-line sized shards,
+ * one picked per thread, so concurrent callers don't contend. Callers on
+ * a hot path resolve their Counters once with counters() and update them
+ * directly; the other record calls go through a per-thread cache.
+ */
+class ServiceStats
+{
+    static constexpr int ShardCount = 8;
+
+    struct alignas(64) Shard
+    {
+        std::atomic<quint64> lookups{0};
+        std::atomic<quint64> calls{0};
+        std::atomic<qint64> totalNs{0};
+    };
+
+public:
+    /**
+     * @brief Aggregated counters for one consumer/interface pair
+     */
+    struct Row
+    {
+        QString consumer;       // Plugin ID, empty for the host
+        QString interfaceName;  // Type name as registered
+        quint64 lookups = 0;    // get()/has()/proxy() lookups
+        quint64 calls = 0;      // Handle leases and proxied calls
+        qint64 totalNs = 0;     // Cumulative time spent in those calls
+    };
+
+    /**
+     * @brief Live counters of one consumer/interface pair
+     */
+    struct Counters
+    {
+        QString consumer;
+        QString interfaceName;
+        std::array<Shard, ShardCount> shards;
+    };
+
+    ServiceStats();
+    ~ServiceStats();
+
+    ServiceStats(const ServiceStats&) = delete;
+    ServiceStats& operator=(const ServiceStats&) = delete;
+
+    void setEnabled(bool enabled) { m_enabled.store(enabled, std::memory_order_relaxed); }
+    bool isEnabled() const { return m_enabled.load(std::memory_order_relaxed); }
+
+    /**
+     * @brief Count a lookup by the current plugin
+     */
+    void recordLookup(const QString& interfaceName)
+    {
+        if (isEnabled()) {
+            add(*cachedCounters(interfaceName), 1, 0, 0);
+        }
+    }
+
+    /**
+     * @brief Count a call by the current plugin and its duration
+     */
+    void recordCall(const QString& interfaceName, qint64 elapsedNs)
+    {
+        if (isEnabled()) {
+            add(*cachedCounters(interfaceName), 0, 1, elapsedNs);
+        }
+    }
+
+    /**
+     * @brief Count a call against counters resolved earlier
+     *
+     * Used by proxies, which know their consumer from the time they were
+     * created, whichever thread or context the call is made from.
+     */
+    void recordCall(Counters& counters, qint64 elapsedNs)
+    {
+        if (isEnabled()) {
+            add(counters, 0, 1, elapsedNs);
+        }
+    }
+
+    /**
+     * @brief Find or create the counters of a consumer/interface pair
+     *
+     * The returned counters stay valid for as long as they are held.
+     */
+    std::shared_ptr<Counters> counters(const QString& consumer, const QString& interfaceName);
+
+    /**
+     * @brief Sum all shards, sorted by consumer then interface
+     */
+    QList<Row> snapshot() const;
+
+    /**
+     * @brief Zero all counters
+     */
+    void reset();
+
+private:
+    using Key = std::pair<QString, QString>;  // consumer, interface
+
+    static void add(Counters& counters, quint64 lookups, quint64 calls, qint64 ns)
+    {
+        Shard& shard = counters.shards[shardIndex()];
+        if (lookups) {
+            shard.lookups.fetch_add(lookups, std::memory_order_relaxed);
+        }
+        if (calls) {
+            shard.calls.fetch_add(calls, std::memory_order_relaxed);
+            shard.totalNs.fetch_add(ns, std::memory_order_relaxed);
+        }
+    }
+
+    Counters* cachedCounters(const QString& interfaceName);
+    static int shardIndex();
+
+    const quint64 m_id;  // Tells instances apart in the per-thread cache
+    std::atomic<bool> m_enabled{false};
+    mutable QReadWriteLock m_lock;
+    QHash<Key, std::shared_ptr<Counters>> m_counters;
+};
+
+} // namespace mpf
@@ -0,0 +1,54 @@
+#pragma once
+
+#include "service_stats.h"
+#include <QAbstractListModel>
+
+namespace mpf {
+
+/**
+ * @brief List model of service usage counters
+ *
+ * Snapshot of ServiceStats for the diagnostics page; call refresh() to
+ * update it. Exposed to QML as App.serviceStats.
+ */
+class ServiceStatsModel : public QAbstractListModel
+{
+    Q_OBJECT
+    Q_PROPERTY(int count READ rowCount NOTIFY countChanged)
+    Q_PROPERTY(bool enabled READ isEnabled WRITE setEnabled NOTIFY enabledChanged)
+
+public:
+    enum Roles {
+        ConsumerRole = Qt::UserRole + 1,
+        InterfaceRole,
+        LookupsRole,
+        CallsRole,
+        TotalMsRole,
+        AverageUsRole
+    };
+
+    explicit ServiceStatsModel(ServiceStats* stats, QObject* parent = nullptr);
+    ~ServiceStatsModel() override;
+
+    // QAbstractListModel interface
+    int rowCount(const QModelIndex& parent = QModelIndex()) const override;
+    QVariant data(const QModelIndex& index, int role = Qt::DisplayRole) const override;
+    QHash<int, QByteArray> roleNames() const override;
+
+    bool isEnabled() const;
+    void setEnabled(bool enabled);
+
+    // Actions
+    Q_INVOKABLE void refresh();
+    Q_INVOKABLE void reset();
+
+signals:
+    void countChanged();
+    void enabledChanged();
+
+private:
+    ServiceStats* m_stats;
+    QList<ServiceStats::Row> m_rows;
+};
+
+} // namespace mpf
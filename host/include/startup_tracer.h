@@ -0,0 +1,153 @@
+#pragma once
+
+#include <QElapsedTimer>
+#include <QHash>
+#include <QMutex>
+#include <QString>
+#include <atomic>
+#include <vector>
+
+namespace mpf {
+
+/**
+ * @brief Records startup phases as Chrome trace events
+ *
+ * Enabled with --trace-startup=<file>. Spans are nested by time on each
+ * thread, so the written JSON shows the startup timeline per thread in
+ * Perfetto or chrome://tracing. When disabled, a span costs one relaxed
+ * atomic load.
+ */
+class StartupTracer
+{
+public:
+    static StartupTracer& instance();
+
+    static bool isEnabled() { return s_enabled.load(std::memory_order_relaxed); }
+
+    /**
+     * @brief Start recording; timestamps are relative to this call
+     * @param outputPath File written by finish()
+     */
+    void start(const QString& outputPath);
+
+    /**
+     * @brief Stop recording and write the trace file
+     * @return false if tracing was not active or the file could not be written
+     */
+    bool finish();
+
+    /**
+     * @brief Nanoseconds since start()
+     */
+    qint64 now() const { return m_clock.nsecsElapsed(); }
+
+    /**
+     * @brief Record a finished span
+     */
+    void addSpan(const char* category, const QString& name, qint64 startNs, qint64 durationNs);
+
+    /**
+     * @brief Record a point in time, e.g. the first frame
+     */
+    void addInstant(const char* category, const QString& name);
+
+    /**
+     * @brief Record a numeric value over time (shown as a counter track)
+     */
+    void addCounter(const QString& name, qint64 value);
+
+    /**
+     * @brief Name the calling thread in the trace
+     */
+    void setThreadName(const QString& name);
+
+    /**
+     * @brief RAII span, recorded from construction to destruction
+     */
+    class Span
+    {
+    public:
+        Span(const char* category, const char* name)
+        {
+            if (isEnabled()) {
+                begin(category, QString::fromLatin1(name));
+            }
+        }
+
+        Span(const char* category, const QString& name)
+        {
+            if (isEnabled()) {
+                begin(category, name);
+            }
+        }
+
+        Span(const char* category, const char* prefix, const QString& detail)
+        {
+            if (isEnabled()) {
+                begin(category, QString::fromLatin1(prefix) + detail);
+            }
+        }
+
+        ~Span()
+        {
+            if (m_category) {
+                StartupTracer& tracer = instance();
+                tracer.addSpan(m_category, m_name, m_start, tracer.now() - m_start);
+            }
+        }
+
+        Span(const Span&) = delete;
+        Span& operator=(const Span&) = delete;
+
+    private:
+        void begin(const char* category, const QString& name)
+        {
+            m_category = category;
+            m_name = name;
+            m_start = instance().now();
+        }
+
+        const char* m_category = nullptr;
+        QString m_name;
+        qint64 m_start = 0;
+    };
+
+private:
+    StartupTracer() = default;
+
+    struct Event
+    {
+        char phase;           // 'X' span, 'i' instant, 'C' counter
+        const char* category;
+        QString name;
+        qint64 start;         // ns since start()
+        qint64 duration;      // ns, spans only; value for counters
+        int tid;
+    };
+
+    int threadIndex();  // Must be called with m_mutex held
+
+    static std::atomic<bool> s_enabled;
+
+    QElapsedTimer m_clock;
+    QString m_outputPath;
+    QMutex m_mutex;
+    std::vector<Event> m_events;
+    QHash<Qt::HANDLE, int> m_threads;  // thread -> small trace tid
+    QHash<int, QString> m_threadNames;
+};
+
+} // namespace mpf
+
+#define MPF_TRACE_CONCAT_(a, b) a##b
+#define MPF_TRACE_CONCAT(a, b) MPF_TRACE_CONCAT_(a, b)
+
+/**
+ * @brief Trace the rest of the enclosing scope
+ *
+ * MPF_TRACE_SPAN("startup", "setupPaths");
+ * MPF_TRACE_SPAN("load", pluginId);
+ * MPF_TRACE_SPAN("service", "construct ", serviceName);
+ */
+#define MPF_TRACE_SPAN(...) \
+    mpf::StartupTracer::Span MPF_TRACE_CONCAT(mpfTraceSpan_, __LINE__)(__VA_ARGS__)
@@ -0,0 +1,74 @@
+#pragma once
+
+#include <mpf/interfaces/ilogger.h>
+#include <QByteArray>
+#include <QHash>
+#include <QString>
+
+namespace mpf {
+
+/**
+ * @brief Decodes files written by Logger::setStructuredOutput()
+ *
+ * Reads the whole file into memory and renders one entry at a time. Used
+ * by mpf-log-decode; the layout is described in mpf/structured_log.h.
+ */
+class StructuredLogReader
+{
+public:
+    struct Entry
+    {
+        qint64 timestampMs = 0;
+        ILogger::Level level = ILogger::Level::Info;
+        QString tag;
+        QString message;
+    };
+
+    /**
+     * @brief Load a file and check its header
+     * @return false if it cannot be read or is not a structured log
+     */
+    bool open(const QString& path);
+
+    /**
+     * @brief Same as open() for data already in memory
+     */
+    bool setData(const QByteArray& data);
+
+    /**
+     * @brief Decode the next entry
+     * @return false at the end of the data or on a corrupt record
+     *         (see errorString()); a truncated last record, as left by a
+     *         crash, just ends the log
+     */
+    bool readNext(Entry* entry);
+
+    QString errorString() const { return m_error; }
+
+    /**
+     * @brief Render an entry as "[date time] [LEVEL] [tag] message"
+     */
+    static QString formatEntry(const Entry& entry);
+
+private:
+    struct Site
+    {
+        ILogger::Level level;
+        QString tag;
+        QByteArray format;
+        QByteArray signature;
+    };
+
+    template<typename T>
+    bool read(T* value);
+    bool readString16(QByteArray* text);
+    bool fail(const QString& error);
+
+    QByteArray m_data;
+    qsizetype m_pos = 0;
+    qint64 m_base = 0;
+    QHash<quint16, Site> m_sites;
+    QString m_error;
+};
+
+} // namespace mpf
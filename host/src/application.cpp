@@ -8,9 +8,13 @@
 #include "menu_service.h"
 #include "event_bus_service.h"
 #include "qml_context.h"
+#include "startup_tracer.h"
+#include "plugin_preloader.h"
 
 #include "service_registry.h"
 #include "logger.h"
+#include "file_log_sink.h"
+#include <mpf/logger_access.h>
 #include <mpf/sdk_paths.h>
 #include <mpf/interfaces/inavigation.h>
 #include <mpf/interfaces/isettings.h>
@@ -19,6 +23,8 @@
 #include <mpf/interfaces/ieventbus.h>
 
 #include <QQmlContext>
+#include <QQuickWindow>
+#include <QTimer>
 #include <QDir>
 #include <QFile>
 #include <QFileInfo>
@@ -38,7 +44,19 @@ Application* Application::s_instance = nullptr;
 Application::Application(int& argc, char** argv)
 {
     s_instance = this;
+
+    // Scanned by hand so QGuiApplication construction is traced too
+    for (int i = 1; i < argc; ++i) {
+        const QByteArray arg(argv[i]);
+        if (arg == "--trace-startup" || arg.startsWith("--trace-startup=")) {
+            const QByteArray file = arg.mid(int(sizeof("--trace-startup=")) - 1);
+            StartupTracer::instance().start(file.isEmpty()
+                ? QStringLiteral("startup-trace.json") : QString::fromLocal8Bit(file));
+            break;
+        }
+    }
     
+    MPF_TRACE_SPAN("startup", "QGuiApplication");
     m_app = std::make_unique<QGuiApplication>(argc, argv);
     m_app->setOrganizationName("MPF");
     m_app->setApplicationName("QtModularPluginFramework");
@@ -52,6 +70,10 @@ Application::~Application()
         m_pluginManager->unloadAll();
     }
     
+    // The engine holds context properties pointing at registry-owned
+    // services, so it must go before the registry deletes them
+    m_engine.reset();
+    
     if (s_instance == this) {
         s_instance = nullptr;
     }
@@ -59,44 +81,87 @@ Application::~Application()
 
 bool Application::initialize()
 {
+    MPF_TRACE_SPAN("startup", "Application::initialize");
+
     setupPaths();
+    startPreload();
     setupLogging();
     
     // Create service registry
     m_registry = std::make_unique<ServiceRegistryImpl>(this);
-    
-    // Create and register core services
-    auto* navigation = new NavigationService(nullptr, this);
-    auto* settings = new SettingsService(m_configPath, this);
-    auto* theme = new ThemeService(this);
-    auto* menu = new MenuService(this);
-    auto* eventBus = new EventBusService(this);
 
-    m_registry->add<INavigation>(navigation, INavigation::apiVersion(), "host");
-    m_registry->add<ISettings>(settings, ISettings::apiVersion(), "host");
-    m_registry->add<ITheme>(theme, ITheme::apiVersion(), "host");
-    m_registry->add<IMenu>(menu, IMenu::apiVersion(), "host");
-    m_registry->add<ILogger>(m_logger.get(), ILogger::apiVersion(), "host");
-    m_registry->add<IEventBus>(eventBus, IEventBus::apiVersion(), "host");
+    // Per-plugin service usage counters for the diagnostics page
+    if (arguments().contains("--service-stats")) {
+        m_registry->stats().setEnabled(true);
+    }
     
-    // Create QML engine
-    m_engine = std::make_unique<QQmlApplicationEngine>();
+    // Register core services; each is constructed on first use and owned
+    // by the registry (no parent is passed)
+    {
+        MPF_TRACE_SPAN("startup", "registerCoreServices");
+        m_registry->addFactory<INavigation>([this]() -> INavigation* {
+            // Resolved after the QML engine exists, so it gets a valid engine
+            return new NavigationService(m_engine.get());
+        }, INavigation::apiVersion(), "host");
+        m_registry->addFactory<ISettings>([this]() -> ISettings* {
+            return new SettingsService(m_configPath);
+        }, ISettings::apiVersion(), "host");
+        m_registry->addFactory<ITheme>([]() -> ITheme* {
+            return new ThemeService();
+        }, ITheme::apiVersion(), "host");
+        m_registry->addFactory<IMenu>([]() -> IMenu* {
+            return new MenuService();
+        }, IMenu::apiVersion(), "host");
+        m_registry->addFactory<IEventBus>([]() -> IEventBus* {
+            return new EventBusService();
+        }, IEventBus::apiVersion(), "host");
+        m_registry->add<ILogger>(m_logger.get(), ILogger::apiVersion(), "host");
+    }
+    setupLogLevels();
     
-    // Update navigation with engine reference
-    static_cast<NavigationService*>(navigation)->~NavigationService();
-    new (navigation) NavigationService(m_engine.get(), this);
+    // Create QML engine
+    {
+        MPF_TRACE_SPAN("startup", "QQmlApplicationEngine");
+        m_engine = std::make_unique<QQmlApplicationEngine>();
+    }
     
     setupQmlContext();
     loadPlugins();
+    setupMemoryReport();
     
     if (!loadMainQml()) {
+        StartupTracer::instance().finish();
         return false;
     }
+
+    finishStartupTrace();
     
     emit initialized();
     return true;
 }
 
+void Application::finishStartupTrace()
+{
+    if (!StartupTracer::isEnabled()) {
+        return;
+    }
+
+    // The trace ends with the first rendered frame, or at quit if the
+    // window never renders
+    auto* window = qobject_cast<QQuickWindow*>(m_engine->rootObjects().value(0));
+    if (window) {
+        auto connection = std::make_shared<QMetaObject::Connection>();
+        *connection = connect(window, &QQuickWindow::frameSwapped, this, [connection]() {
+            QObject::disconnect(*connection);
+            StartupTracer::instance().addInstant("startup", "first frame");
+            StartupTracer::instance().finish();
+        });
+    }
+    connect(m_app.get(), &QCoreApplication::aboutToQuit, this, []() {
+        StartupTracer::instance().finish();
+    });
+}
+
 int Application::run()
 {
     connect(m_app.get(), &QCoreApplication::aboutToQuit, this, [this]() {
@@ -142,6 +207,8 @@ static QString expandEnvVars(const QString& path)
 
 void Application::setupPaths()
 {
+    MPF_TRACE_SPAN("startup", "setupPaths");
+
     QString appDir = QCoreApplication::applicationDirPath();
     
     // Determine paths relative to executable
@@ -249,15 +316,109 @@ void Application::setupPaths()
 #endif
 }
 
+void Application::startPreload()
+{
+    if (arguments().contains("--no-preload")) {
+        return;
+    }
+
+    // Plugins plus the SDK libraries they link against (e.g. mpf-http-client)
+    m_preloader = std::make_unique<PluginPreloader>();
+    m_preloader->addDirectory(QCoreApplication::applicationDirPath() + "/../lib", "libmpf-");
+    m_preloader->addDirectory(QCoreApplication::applicationDirPath(), "mpf-");
+#if MPF_SDK_HAS_QML_PATH
+    const QString sdkPath = QDir(QStringLiteral(MPF_SDK_QML_PATH)).absoluteFilePath("..");
+    m_preloader->addDirectory(sdkPath + "/lib", "libmpf-");
+    m_preloader->addDirectory(sdkPath + "/bin", "mpf-");
+#endif
+    m_preloader->addDirectory(m_pluginPath);
+    m_preloader->start(QThread::LowPriority);
+}
+
 void Application::setupLogging()
 {
+    MPF_TRACE_SPAN("startup", "setupLogging");
+
     m_logger = std::make_unique<Logger>(this);
     m_logger->setFormat("[%time%] [%level%] [%tag%] %message%");
     m_logger->setMinLevel(ILogger::Level::Debug);
+
+    // Format and write on a background thread so the GUI thread never
+    // waits on stderr; the logger flushes when it is destroyed
+    if (!arguments().contains("--log-sync")) {
+        const auto policy = arguments().contains("--log-overflow=drop")
+            ? Logger::OverflowPolicy::Drop
+            : Logger::OverflowPolicy::Block;
+        m_logger->startAsync(8192, policy);
+    }
+
+    // --log-file=<path>: also write to a rotating file, sized in MiB and
+    // rotated every N hours; --log-compress gzips the rotated files
+    FileLogSink::Options fileOptions;
+    for (const QString& arg : arguments()) {
+        if (arg.startsWith("--log-structured=")) {
+            // MPF_SLOG_* records go to a binary file for mpf-log-decode
+            m_logger->setStructuredOutput(arg.section('=', 1));
+        } else if (arg.startsWith("--log-file=")) {
+            fileOptions.filePath = arg.section('=', 1);
+        } else if (arg.startsWith("--log-file-size=")) {
+            fileOptions.maxFileSize = arg.section('=', 1).toLongLong() * 1024 * 1024;
+        } else if (arg.startsWith("--log-file-keep=")) {
+            fileOptions.maxFiles = arg.section('=', 1).toInt();
+        } else if (arg.startsWith("--log-rotate-hours=")) {
+            fileOptions.rotateIntervalMs = qint64(arg.section('=', 1).toDouble() * 3600 * 1000);
+        } else if (arg == "--log-compress") {
+            fileOptions.compress = true;
+        } else if (arg == "--log-no-console") {
+            m_logger->setConsoleOutput(false);
+        }
+    }
+    if (!fileOptions.filePath.isEmpty()) {
+        auto sink = std::make_unique<FileLogSink>(fileOptions);
+        if (sink->open()) {
+            m_logger->setFileSink(std::move(sink));
+        } else {
+            m_logger->setConsoleOutput(true);  // Do not lose everything
+            qWarning() << "Cannot open log file:" << sink->errorString();
+        }
+    }
+
+    // Plugins reach the logger (and its level) through LoggerAccess
+    LoggerAccess::setInstance(m_logger.get());
+}
+
+void Application::setupLogLevels()
+{
+    // Per-tag levels ("OrdersPlugin=Trace, EventBus=Warning") come from the
+    // host/logLevels setting and follow it at runtime; --log-levels=<spec>
+    // takes precedence for this run
+    for (const QString& arg : arguments()) {
+        if (arg.startsWith("--log-levels=")) {
+            m_logger->setTagLevels(arg.section('=', 1));
+            return;
+        }
+    }
+
+    auto* settings = dynamic_cast<SettingsService*>(m_registry->get<ISettings>());
+    if (!settings) {
+        return;
+    }
+    const QString spec = settings->value("host", "logLevels").toString();
+    if (!spec.isEmpty()) {
+        m_logger->setTagLevels(spec);
+    }
+    connect(settings, &SettingsService::settingChanged, this,
+            [this](const QString& pluginId, const QString& key, const QVariant& value) {
+        if (pluginId == "host" && key == "logLevels") {
+            m_logger->setTagLevels(value.toString());
+        }
+    });
 }
 
 void Application::setupQmlContext()
 {
+    MPF_TRACE_SPAN("startup", "setupQmlContext");
+
     // Add QML import paths
     m_engine->addImportPath(m_qmlPath);
     m_engine->addImportPath("qrc:/");
@@ -296,6 +457,8 @@ void Application::setupQmlContext()
 
 void Application::loadPlugins()
 {
+    MPF_TRACE_SPAN("startup", "loadPlugins");
+
     m_pluginManager = std::make_unique<PluginManager>(m_registry.get(), this);
     
     // Connect signals for logging
@@ -308,13 +471,71 @@ void Application::loadPlugins()
                 qWarning() << "Plugin error:" << id << "-" << err; 
             });
     
-    // Discover plugins
-    int count = m_pluginManager->discover(m_pluginPath);
+    // Drop cached QML components so a reloaded plugin's pages are re-read
+    connect(m_pluginManager.get(), &PluginManager::pluginSwapped, this,
+            [this](const QString& id, const QStringList&, qint64 elapsedMs) {
+                if (m_engine) {
+                    m_engine->clearComponentCache();
+                }
+                qDebug() << "Swapped plugin:" << id << "in" << elapsedMs << "ms";
+            });
+    
+    // Per-plugin time budgets for initialize()/start(), in milliseconds
+    int initBudgetMs = 500;
+    int startBudgetMs = 500;
+    for (const QString& arg : arguments()) {
+        if (arg.startsWith("--init-budget=")) {
+            initBudgetMs = arg.section('=', 1).toInt();
+        } else if (arg.startsWith("--start-budget=")) {
+            startBudgetMs = arg.section('=', 1).toInt();
+        }
+    }
+    m_pluginManager->setBudgets(initBudgetMs, startBudgetMs);
+    
+    // Warm starts read plugin metadata from the cache instead of the files
+    m_pluginManager->setMetadataCache(QDir(m_configPath).filePath("plugin-cache.bin"),
+                                      arguments().contains("--rescan-plugins"));
+    
+    // Discover plugins; those linked into the host come first so they win
+    // over a stale library with the same ID
+    int count;
+    {
+        MPF_TRACE_SPAN("startup", "PluginManager::discover");
+        count = m_pluginManager->discoverStatic();
+        count += m_pluginManager->discover(m_pluginPath);
+    }
     qDebug() << "Discovered" << count << "plugins";
+
+    setupDeferredPlugins();
     
     // Load, initialize, and start
-    if (m_pluginManager->loadAll()) {
-        if (m_pluginManager->initializeAll()) {
+    if (m_preloader) {
+        m_preloader->report();
+    }
+    bool loaded;
+    {
+        MPF_TRACE_SPAN("startup", "PluginManager::loadAll");
+        loaded = m_pluginManager->loadAll();
+    }
+    if (StartupTracer::isEnabled()) {
+        // Time spent mapping plugin libraries; comparing it with a
+        // --no-preload run gives what the preloader saves
+        qint64 loadNs = 0;
+        for (PluginLoader* plugin : m_pluginManager->plugins()) {
+            if (!plugin->isStatic() && !plugin->isRemote() && plugin->loadDurationNs() > 0) {
+                loadNs += plugin->loadDurationNs();
+            }
+        }
+        StartupTracer::instance().addCounter("plugin load ms", loadNs / 1000000);
+    }
+    if (loaded) {
+        bool initialized;
+        {
+            MPF_TRACE_SPAN("startup", "PluginManager::initializeAll");
+            initialized = m_pluginManager->initializeAll();
+        }
+        if (initialized) {
+            MPF_TRACE_SPAN("startup", "PluginManager::startAll");
             m_pluginManager->startAll();
         }
     }
@@ -325,8 +546,57 @@ void Application::loadPlugins()
     }
 }
 
+void Application::setupMemoryReport()
+{
+    // --memory-report[=<seconds>]: log per-plugin memory usage periodically
+    // (default every 60 s) and at quit
+    int intervalSec = 0;
+    for (const QString& arg : arguments()) {
+        if (arg == "--memory-report") {
+            intervalSec = 60;
+        } else if (arg.startsWith("--memory-report=")) {
+            intervalSec = arg.section('=', 1).toInt();
+        }
+    }
+    if (intervalSec <= 0) {
+        return;
+    }
+
+    auto* timer = new QTimer(this);
+    connect(timer, &QTimer::timeout, this, [this]() {
+        qInfo().noquote() << m_pluginManager->memoryReport();
+    });
+    timer->start(intervalSec * 1000);
+
+    connect(m_app.get(), &QCoreApplication::aboutToQuit, this, [this]() {
+        qInfo().noquote() << m_pluginManager->memoryReport();
+    });
+}
+
+void Application::setupDeferredPlugins()
+{
+    // Plugins with loadOnStartup=false are announced by their metadata only;
+    // the first push to one of their routes or get<T>() of one of their
+    // services loads, initializes and starts them
+    auto activate = [this](const QString& id) {
+        return m_pluginManager->activate(id);
+    };
+    m_registry->setProviderActivator(activate);
+    connect(m_pluginManager.get(), &PluginManager::pluginActivated, this,
+            [this](const QString& id) { m_registry->removeDeferredProviders(id); });
+
+    auto* navigation = dynamic_cast<NavigationService*>(m_registry->get<INavigation>());
+    if (navigation) {
+        navigation->setRouteActivator(activate);
+    }
+
+    m_pluginManager->announceDeferred(m_pluginManager->deferredPlugins());
+}
+
 bool Application::loadMainQml()
 {
+    MPF_TRACE_SPAN("startup", "loadMainQml");
+
     // Try to find entry QML from plugins first
     QString entryQml;
     for (auto* loader : m_pluginManager->plugins()) {
@@ -351,7 +621,10 @@ bool Application::loadMainQml()
     
     qDebug() << "Loading main QML:" << entryQml;
     
-    m_engine->load(QUrl(entryQml));
+    {
+        MPF_TRACE_SPAN("startup", "QQmlApplicationEngine::load");
+        m_engine->load(QUrl(entryQml));
+    }
     
     if (m_engine->rootObjects().isEmpty()) {
         qCritical() << "Failed to load main QML";
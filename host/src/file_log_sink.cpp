@@ -0,0 +1,310 @@
+#include "file_log_sink.h"
+
+#include <QDateTime>
+#include <QDir>
+#include <QFileInfo>
+#include <QSaveFile>
+#include <QDebug>
+#include <array>
+
+namespace mpf {
+
+namespace {
+
+// write() blocks once this many buffers' worth of lines are waiting
+constexpr int MaxBufferedChunks = 4;
+
+quint32 crc32(const QByteArray& data)
+{
+    static const auto table = []() {
+        std::array<quint32, 256> t{};
+        for (quint32 i = 0; i < 256; ++i) {
+            quint32 c = i;
+            for (int k = 0; k < 8; ++k) {
+                c = (c & 1) ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+            }
+            t[i] = c;
+        }
+        return t;
+    }();
+
+    quint32 crc = 0xFFFFFFFFu;
+    for (const char byte : data) {
+        crc = table[(crc ^ quint8(byte)) & 0xFF] ^ (crc >> 8);
+    }
+    return crc ^ 0xFFFFFFFFu;
+}
+
+void appendLittleEndian(QByteArray& out, quint32 value)
+{
+    for (int i = 0; i < 4; ++i) {
+        out.append(char((value >> (8 * i)) & 0xFF));
+    }
+}
+
+} // namespace
+
+FileLogSink::FileLogSink(const Options& options, QObject* parent)
+    : QThread(parent)
+    , m_options(options)
+{
+    setObjectName("FileLogSink");
+    m_compressor.setMaxThreadCount(1);
+}
+
+FileLogSink::~FileLogSink()
+{
+    close();
+    m_compressor.waitForDone();
+}
+
+bool FileLogSink::open()
+{
+    close();
+
+    const QFileInfo info(m_options.filePath);
+    if (!QDir().mkpath(info.absolutePath())) {
+        QMutexLocker locker(&m_mutex);
+        m_error = QString("Cannot create directory %1").arg(info.absolutePath());
+        return false;
+    }
+    if (!openFile()) {
+        return false;
+    }
+
+    {
+        QMutexLocker locker(&m_mutex);
+        m_buffer.reserve(m_options.bufferSize * MaxBufferedChunks);
+        m_running = true;
+        m_stopping = false;
+    }
+    start(QThread::LowPriority);
+    return true;
+}
+
+void FileLogSink::close()
+{
+    {
+        QMutexLocker locker(&m_mutex);
+        if (!m_running) {
+            return;
+        }
+        m_stopping = true;
+        m_wake.wakeOne();
+    }
+    wait();  // Drains the buffer first
+
+    QMutexLocker locker(&m_mutex);
+    m_running = false;
+    m_file.close();
+    m_drained.wakeAll();
+}
+
+QString FileLogSink::errorString() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_error;
+}
+
+void FileLogSink::write(QStringView line, bool urgent)
+{
+    QMutexLocker locker(&m_mutex);
+    if (!m_running || m_stopping) {
+        return;
+    }
+
+    // Back-pressure when the disk cannot keep up; never from the writer itself
+    while (m_buffer.size() >= m_options.bufferSize * MaxBufferedChunks && !m_stopping
+           && QThread::currentThread() != this) {
+        m_wake.wakeOne();
+        m_drained.wait(&m_mutex);
+    }
+
+    // Encode straight into the buffer: no temporary QByteArray per line
+    const qsizetype used = m_buffer.size();
+    m_buffer.resize(used + m_encoder.requiredSpace(line.size()) + 1);
+    char* end = m_encoder.appendToBuffer(m_buffer.data() + used, line);
+    *end++ = '\n';
+    m_buffer.resize(end - m_buffer.constData());
+
+    if (urgent || m_buffer.size() >= m_options.bufferSize) {
+        m_wake.wakeOne();
+    }
+}
+
+void FileLogSink::flush()
+{
+    if (QThread::currentThread() == this) {
+        return;
+    }
+
+    QMutexLocker locker(&m_mutex);
+    const quint64 ticket = ++m_flushRequested;
+    m_wake.wakeOne();
+    while (m_running && m_flushDone < ticket && isRunning()) {
+        m_drained.wait(&m_mutex, 100);
+    }
+}
+
+void FileLogSink::run()
+{
+    QByteArray chunk;
+    chunk.reserve(m_options.bufferSize * MaxBufferedChunks);
+
+    QMutexLocker locker(&m_mutex);
+    for (;;) {
+        if (!m_stopping && m_flushDone == m_flushRequested && m_buffer.size() < m_options.bufferSize) {
+            m_wake.wait(&m_mutex, m_options.flushIntervalMs);
+        }
+
+        // Swap buffers so producers keep appending while we write
+        chunk.swap(m_buffer);
+        const quint64 ticket = m_flushRequested;
+        const bool stopping = m_stopping;
+        m_drained.wakeAll();
+        locker.unlock();
+
+        if (!chunk.isEmpty()) {
+            if (needsRotation(chunk.size())) {
+                rotate();
+            }
+            if (m_file.isOpen()) {
+                if (m_file.write(chunk) != chunk.size()) {
+                    qWarning() << "FileLogSink: Cannot write" << m_file.fileName() << ":"
+                               << m_file.errorString();
+                }
+                m_file.flush();
+                m_fileSize += chunk.size();
+            }
+            chunk.resize(0);  // Keeps the capacity
+        }
+
+        locker.relock();
+        m_flushDone = ticket;
+        m_drained.wakeAll();
+        if (stopping && m_buffer.isEmpty()) {
+            break;
+        }
+    }
+}
+
+bool FileLogSink::openFile()
+{
+    m_file.setFileName(m_options.filePath);
+    if (!m_file.open(QIODevice::WriteOnly | QIODevice::Append)) {
+        QMutexLocker locker(&m_mutex);
+        m_error = QString("Cannot open %1: %2").arg(m_options.filePath, m_file.errorString());
+        qWarning() << "FileLogSink:" << m_error;
+        return false;
+    }
+    m_fileSize = m_file.size();
+    m_openedAtMs = QDateTime::currentMSecsSinceEpoch();
+    return true;
+}
+
+bool FileLogSink::needsRotation(qsizetype incoming) const
+{
+    if (m_fileSize == 0) {
+        return false;  // Never rotate out an empty file
+    }
+    if (m_options.maxFileSize > 0 && m_fileSize + incoming > m_options.maxFileSize) {
+        return true;
+    }
+    return m_options.rotateIntervalMs > 0
+        && QDateTime::currentMSecsSinceEpoch() - m_openedAtMs >= m_options.rotateIntervalMs;
+}
+
+void FileLogSink::rotate()
+{
+    m_file.close();
+
+    // Named after the time the file was started; millisecond stamps keep
+    // the names unique and in order
+    const QFileInfo info(m_options.filePath);
+    QString rotated;
+    for (qint64 stamp = m_openedAtMs;; ++stamp) {
+        rotated = info.dir().filePath(QString("%1-%2.%3")
+            .arg(info.completeBaseName(),
+                 QDateTime::fromMSecsSinceEpoch(stamp).toString("yyyyMMdd-hhmmss-zzz"),
+                 info.suffix()));
+        if (!QFile::exists(rotated) && !QFile::exists(rotated + ".gz")) {
+            break;
+        }
+    }
+
+    if (!QFile::rename(m_options.filePath, rotated)) {
+        qWarning() << "FileLogSink: Cannot rename" << m_options.filePath << "to" << rotated;
+    } else if (m_options.compress) {
+        m_compressor.start([rotated]() { compressFile(rotated); });
+    }
+
+    openFile();
+    prune();
+}
+
+QStringList FileLogSink::rotatedFiles() const
+{
+    const QFileInfo info(m_options.filePath);
+    const QString pattern = info.completeBaseName() + "-????????-??????-???." + info.suffix();
+    const QStringList names = info.dir().entryList({pattern, pattern + ".gz"}, QDir::Files, QDir::Name);
+
+    // A file being compressed may exist as both .log and .log.gz
+    QStringList files;
+    for (const QString& name : names) {
+        const QString path = info.dir().filePath(name);
+        if (name.endsWith(".gz") && names.contains(name.chopped(3))) {
+            continue;
+        }
+        files.append(path);
+    }
+    return files;
+}
+
+void FileLogSink::prune()
+{
+    if (m_options.maxFiles <= 0) {
+        return;
+    }
+
+    const QStringList files = rotatedFiles();
+    for (qsizetype i = 0; i < files.size() - m_options.maxFiles; ++i) {
+        QFile::remove(files.at(i));
+        QFile::remove(files.at(i) + ".gz");
+    }
+}
+
+bool FileLogSink::compressFile(const QString& path)
+{
+    QFile source(path);
+    if (!source.open(QIODevice::ReadOnly)) {
+        return false;  // Already pruned
+    }
+    const QByteArray data = source.readAll();
+    source.close();
+
+    // qCompress() emits a 4-byte length, then a zlib stream: a 2-byte
+    // header, raw deflate data and an Adler-32. gzip wants the same
+    // deflate data between its own header and a CRC-32 + size trailer.
+    const QByteArray zlib = qCompress(data, 6);
+    if (zlib.size() < 4 + 2 + 4) {
+        qWarning() << "FileLogSink: Cannot compress" << path;
+        return false;
+    }
+
+    QByteArray gzip;
+    gzip.reserve(zlib.size() + 10);
+    gzip.append("\x1f\x8b\x08\x00\x00\x00\x00\x00\x00\xff", 10);
+    gzip.append(zlib.constData() + 6, zlib.size() - 10);
+    appendLittleEndian(gzip, crc32(data));
+    appendLittleEndian(gzip, quint32(data.size()));
+
+    QSaveFile target(path + ".gz");
+    if (!target.open(QIODevice::WriteOnly) || target.write(gzip) != gzip.size() || !target.commit()) {
+        qWarning() << "FileLogSink: Cannot write" << target.fileName() << ":" << target.errorString();
+        return false;
+    }
+    QFile::remove(path);
+    return true;
+}
+
+} // namespace mpf
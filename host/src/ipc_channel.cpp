@@ -0,0 +1,220 @@
+#include "ipc_channel.h"
+
+#include <QDataStream>
+#include <QLocalSocket>
+#include <QMetaMethod>
+#include <QtEndian>
+#include <QDebug>
+#include <array>
+
+namespace mpf {
+
+namespace {
+
+constexpr QDataStream::Version StreamVersion = QDataStream::Qt_6_0;
+constexpr int MaxInvokeArgs = 10;  // QMetaMethod::invoke() limit
+
+} // namespace
+
+QDataStream& operator<<(QDataStream& out, const IpcMessage& message)
+{
+    out << quint8(message.type) << message.id << message.ok << message.name
+        << message.method << message.args << message.result;
+    return out;
+}
+
+QDataStream& operator>>(QDataStream& in, IpcMessage& message)
+{
+    quint8 type = 0;
+    in >> type >> message.id >> message.ok >> message.name
+       >> message.method >> message.args >> message.result;
+    message.type = IpcMessage::Type(type);
+    return in;
+}
+
+IpcChannel::IpcChannel(QLocalSocket* socket, QObject* parent)
+    : QObject(parent)
+    , m_socket(socket)
+{
+    connect(socket, &QLocalSocket::readyRead, this, &IpcChannel::onReadyRead);
+    connect(socket, &QLocalSocket::disconnected, this, &IpcChannel::disconnected);
+
+    // Data may have arrived before we were attached
+    if (socket->bytesAvailable() > 0) {
+        QMetaObject::invokeMethod(this, &IpcChannel::onReadyRead, Qt::QueuedConnection);
+    }
+}
+
+IpcChannel::~IpcChannel()
+{
+    flush();
+}
+
+void IpcChannel::send(const IpcMessage& message)
+{
+    QDataStream stream(&m_outgoing, QIODevice::WriteOnly | QIODevice::Append);
+    stream.setVersion(StreamVersion);
+    stream << message;
+    ++m_outgoingCount;
+
+    if (m_outgoing.size() >= FlushThreshold) {
+        flush();
+    } else {
+        scheduleFlush();
+    }
+}
+
+void IpcChannel::scheduleFlush()
+{
+    if (m_flushScheduled) {
+        return;
+    }
+    m_flushScheduled = true;
+    QMetaObject::invokeMethod(this, &IpcChannel::flush, Qt::QueuedConnection);
+}
+
+void IpcChannel::flush()
+{
+    m_flushScheduled = false;
+    if (m_outgoingCount == 0) {
+        return;
+    }
+    if (!isConnected()) {
+        m_outgoing.clear();
+        m_outgoingCount = 0;
+        return;
+    }
+
+    // Frame: payload length, message count, messages
+    std::array<char, 8> header;
+    qToBigEndian<quint32>(quint32(m_outgoing.size() + 4), header.data());
+    qToBigEndian<quint32>(m_outgoingCount, header.data() + 4);
+    m_socket->write(header.data(), qint64(header.size()));
+    m_socket->write(m_outgoing);
+    m_socket->flush();
+
+    ++m_framesSent;
+    m_messagesSent += m_outgoingCount;
+    m_outgoing.clear();
+    m_outgoingCount = 0;
+}
+
+bool IpcChannel::isConnected() const
+{
+    return m_socket && m_socket->state() == QLocalSocket::ConnectedState;
+}
+
+void IpcChannel::onReadyRead()
+{
+    if (!m_socket) {
+        return;
+    }
+    m_incoming.append(m_socket->readAll());
+
+    // Parse every complete frame first, then deliver, so handlers may send
+    // (or delete this channel) freely
+    QList<IpcMessage> messages;
+    qsizetype offset = 0;
+    while (m_incoming.size() - offset >= 4) {
+        const quint32 length = qFromBigEndian<quint32>(m_incoming.constData() + offset);
+        if (m_incoming.size() - offset - 4 < qsizetype(length)) {
+            break;
+        }
+
+        QDataStream stream(QByteArray::fromRawData(m_incoming.constData() + offset + 4, length));
+        stream.setVersion(StreamVersion);
+        quint32 count = 0;
+        stream >> count;
+        for (quint32 i = 0; i < count && stream.status() == QDataStream::Ok; ++i) {
+            IpcMessage message;
+            stream >> message;
+            messages.append(std::move(message));
+        }
+        if (stream.status() != QDataStream::Ok) {
+            qWarning() << "IpcChannel: Dropping malformed frame of" << length << "bytes";
+        }
+        offset += 4 + qsizetype(length);
+    }
+    m_incoming.remove(0, offset);
+
+    QPointer<IpcChannel> self(this);
+    for (const IpcMessage& message : std::as_const(messages)) {
+        emit messageReceived(message);
+        if (!self) {
+            return;
+        }
+    }
+}
+
+bool IpcChannel::invoke(QObject* target, const QString& method, const QVariantList& args,
+                        QVariant* result, QString* error)
+{
+    if (!target) {
+        *error = QStringLiteral("no such service");
+        return false;
+    }
+    if (args.size() > MaxInvokeArgs) {
+        *error = QStringLiteral("too many arguments");
+        return false;
+    }
+
+    const QByteArray name = method.toLatin1();
+    const QMetaObject* meta = target->metaObject();
+    const QMetaType variantType = QMetaType::fromType<QVariant>();
+
+    // Most derived class first
+    for (int i = meta->methodCount() - 1; i >= 0; --i) {
+        const QMetaMethod candidate = meta->method(i);
+        if (candidate.methodType() != QMetaMethod::Method
+            && candidate.methodType() != QMetaMethod::Slot) continue;
+        if (candidate.name() != name || candidate.parameterCount() != args.size()) continue;
+
+        QVariantList converted = args;
+        bool convertible = true;
+        for (int j = 0; j < converted.size() && convertible; ++j) {
+            const QMetaType type = candidate.parameterMetaType(j);
+            if (type != variantType) {
+                convertible = converted[j].convert(type);
+            }
+        }
+        if (!convertible) continue;
+
+        std::array<QByteArray, MaxInvokeArgs> typeNames;
+        std::array<QGenericArgument, MaxInvokeArgs> argv;
+        for (int j = 0; j < converted.size(); ++j) {
+            typeNames[j] = candidate.parameterTypeName(j);
+            const bool isVariant = candidate.parameterMetaType(j) == variantType;
+            argv[j] = QGenericArgument(typeNames[j].constData(),
+                                       isVariant ? static_cast<const void*>(&converted[j])
+                                                 : converted[j].constData());
+        }
+
+        QVariant value;
+        QGenericReturnArgument returnArg;
+        const QMetaType returnType = candidate.returnMetaType();
+        if (returnType == variantType) {
+            returnArg = QGenericReturnArgument("QVariant", &value);
+        } else if (returnType.id() != QMetaType::Void) {
+            value = QVariant(returnType);
+            returnArg = QGenericReturnArgument(candidate.typeName(), value.data());
+        }
+
+        const bool invoked = candidate.invoke(target, Qt::DirectConnection, returnArg,
+                                              argv[0], argv[1], argv[2], argv[3], argv[4],
+                                              argv[5], argv[6], argv[7], argv[8], argv[9]);
+        if (!invoked) {
+            *error = QStringLiteral("invocation of %1 failed").arg(method);
+            return false;
+        }
+        if (result) {
+            *result = value;
+        }
+        return true;
+    }
+
+    *error = QStringLiteral("no invokable method %1 taking %2 argument(s)")
+                 .arg(method).arg(args.size());
+    return false;
+}
+
+} // namespace mpf
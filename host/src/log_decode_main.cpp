@@ -0,0 +1,59 @@
+// mpf-log-decode: renders structured logs written by mpf-host --log-structured.
+//
+// Usage: mpf-log-decode [--tag <tag>] [--min-level <0-4>] <file>...
+//
+// Prints one line per entry, in the format of the text log, to stdout.
+
+#include "structured_log_reader.h"
+
+#include <QCommandLineParser>
+#include <QCoreApplication>
+#include <QTextStream>
+#include <QDebug>
+
+using namespace mpf;
+
+int main(int argc, char* argv[])
+{
+    QCoreApplication app(argc, argv);
+    app.setApplicationName("mpf-log-decode");
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Render MPF structured log files as text.");
+    parser.addHelpOption();
+    parser.addOption({"tag", "Only print entries with this tag.", "tag"});
+    parser.addOption({"min-level", "Only print entries at or above level (0 = trace ... 4 = error).",
+                      "level", "0"});
+    parser.addPositionalArgument("files", "Structured log files.", "<file>...");
+    parser.process(app);
+
+    const QStringList files = parser.positionalArguments();
+    if (files.isEmpty()) {
+        parser.showHelp(2);
+    }
+    const QString tag = parser.value("tag");
+    const int minLevel = parser.value("min-level").toInt();
+
+    QTextStream out(stdout);
+    int result = 0;
+    for (const QString& path : files) {
+        StructuredLogReader reader;
+        if (!reader.open(path)) {
+            qCritical().noquote() << "mpf-log-decode:" << reader.errorString();
+            result = 1;
+            continue;
+        }
+
+        StructuredLogReader::Entry entry;
+        while (reader.readNext(&entry)) {
+            if (int(entry.level) >= minLevel && (tag.isEmpty() || entry.tag == tag)) {
+                out << StructuredLogReader::formatEntry(entry) << '\n';
+            }
+        }
+        if (!reader.errorString().isEmpty()) {
+            qCritical().noquote() << "mpf-log-decode:" << path << ":" << reader.errorString();
+            result = 1;
+        }
+    }
+    return result;
+}
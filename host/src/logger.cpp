@@ -1,14 +1,354 @@
 #include "logger.h"
+#include "file_log_sink.h"
+#include "log_ring_buffer.h"
+#include <mpf/structured_log.h>
+
 #include <QDebug>
 #include <QDateTime>
+#include <QFile>
+#include <QRegularExpression>
+#include <QSemaphore>
+#include <QThread>
+#include <QWaitCondition>
+#include <optional>
+#include <utility>
 
 namespace mpf {
 
+namespace {
+
+struct LogRecord
+{
+    ILogger::Level level = ILogger::Level::Info;
+    qint64 timestampMs = 0;
+    QString tag;      // Implicitly shared: queuing copies no characters
+    QString message;
+};
+
+// Source of Logger::m_generation; never 0
+std::atomic<quint64> s_generations{0};
+
+} // namespace
+
+/**
+ * @brief Background thread draining the async ring buffer
+ *
+ * Producers never take a lock: the writer announces that it is about to
+ * sleep through m_idle, and only the push that finds it idle releases the
+ * semaphore it sleeps on.
+ */
+class Logger::Writer : public QThread
+{
+public:
+    enum class Push {
+        Queued,
+        Dropped,  // Buffer full under OverflowPolicy::Drop
+        Closed    // stop() has begun; the caller has to write the record itself
+    };
+
+    Writer(Logger* logger, int capacity, OverflowPolicy policy)
+        : m_logger(logger)
+        , m_buffer(std::size_t(qMax(capacity, 2)))
+        , m_policy(policy)
+    {
+        setObjectName("LoggerWriter");
+    }
+
+    ~Writer() override { stop(); }
+
+    /**
+     * @brief Queue a record; any thread
+     */
+    Push push(LogRecord& record)
+    {
+        // Pairs with stop(): either it sees us inside and waits, or we see it closed
+        m_producers.fetch_add(1);
+        if (!m_accepting.load()) {
+            m_producers.fetch_sub(1, std::memory_order_release);
+            return Push::Closed;
+        }
+
+        Push result = Push::Queued;
+        while (!m_buffer.tryPush(record)) {
+            // The writer itself (e.g. a handler that logs) must never wait on itself
+            if (m_policy == OverflowPolicy::Drop || QThread::currentThread() == this) {
+                result = Push::Dropped;
+                break;
+            }
+            wake();
+            QThread::yieldCurrentThread();
+        }
+
+        if (result == Push::Queued) {
+            m_pushed.fetch_add(1);
+            wake();
+        }
+        m_producers.fetch_sub(1, std::memory_order_release);
+        return result;
+    }
+
+    void flush()
+    {
+        if (QThread::currentThread() == this) {
+            return;
+        }
+
+        const quint64 target = m_pushed.load();
+        QMutexLocker locker(&m_mutex);
+        while (m_written.load() < target && isRunning()) {
+            wake();
+            m_drained.wait(&m_mutex, 100);
+        }
+    }
+
+    /**
+     * @brief Turn new records away, write the queued ones and end the thread
+     */
+    void stop()
+    {
+        // Records already inside push() still go through the buffer; the
+        // thread keeps draining meanwhile, so Block producers get room
+        m_accepting.store(false);
+        while (m_producers.load(std::memory_order_acquire) != 0) {
+            QThread::yieldCurrentThread();
+        }
+
+        m_stopping.store(true);
+        wake();
+        wait();
+    }
+
+protected:
+    void run() override
+    {
+        LogRecord record;
+        for (;;) {
+            bool wrote = false;
+            while (m_buffer.tryPop(record)) {
+                m_logger->write(record.level, record.tag, record.message, record.timestampMs);
+                record = LogRecord();
+                m_written.fetch_add(1);
+                wrote = true;
+            }
+
+            if (wrote) {
+                QMutexLocker locker(&m_mutex);
+                m_drained.wakeAll();
+            }
+            if (m_stopping.load()) {
+                break;
+            }
+
+            // Announce the sleep, then look again: a producer either pushed
+            // before the announcement and is seen here, or sees it and wakes us
+            m_idle.store(true);
+            if ((m_pushed.load() > m_written.load() || m_stopping.load()) && m_idle.exchange(false)) {
+                continue;
+            }
+            m_signal.acquire();  // Returns at once if the wake-up came in between
+        }
+    }
+
+private:
+    void wake()
+    {
+        // Only on the idle -> busy transition; a busy writer costs one load
+        if (m_idle.load() && m_idle.exchange(false)) {
+            m_signal.release();
+        }
+    }
+
+    Logger* m_logger;
+    LogRingBuffer<LogRecord> m_buffer;
+    const OverflowPolicy m_policy;
+    std::atomic<int> m_producers{0};  // Threads inside push()
+    std::atomic<quint64> m_pushed{0};
+    std::atomic<quint64> m_written{0};
+    std::atomic<bool> m_accepting{true};
+    std::atomic<bool> m_idle{false};
+    std::atomic<bool> m_stopping{false};
+    QSemaphore m_signal;       // Writer sleeps on this when the buffer is empty
+    QMutex m_mutex;
+    QWaitCondition m_drained;  // flush() waits on this
+};
+
+/**
+ * @brief Binary file behind setStructuredOutput()
+ *
+ * Callers append to an in-memory buffer under a mutex; the file is only
+ * written once FlushThreshold bytes have accumulated, on flush() and on
+ * close. Site records are kept so a newly opened file can repeat them.
+ */
+class Logger::StructuredOutput
+{
+public:
+    static constexpr qsizetype FlushThreshold = 256 * 1024;
+
+    ~StructuredOutput() { close(); }
+
+    bool open(const QString& path)
+    {
+        QMutexLocker locker(&m_mutex);
+        closeLocked();
+
+        m_file.setFileName(path);
+        if (!m_file.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+            qWarning() << "Logger: Cannot open structured log" << path << ":" << m_file.errorString();
+            return false;
+        }
+
+        m_buffer.reserve(FlushThreshold + 4096);
+        m_base = QDateTime::currentMSecsSinceEpoch();
+        m_buffer.append(structured::Magic, sizeof(structured::Magic));
+        put(structured::ByteOrderMark);
+        put(m_base);
+        for (qsizetype i = 0; i < m_sites.size(); ++i) {
+            writeSite(quint16(i + 1));
+        }
+        return true;
+    }
+
+    void close()
+    {
+        QMutexLocker locker(&m_mutex);
+        closeLocked();
+    }
+
+    QString path() const
+    {
+        QMutexLocker locker(&m_mutex);
+        return m_file.isOpen() ? m_file.fileName() : QString();
+    }
+
+    quint32 addSite(Level level, const char* tag, const char* format, const char* signature)
+    {
+        QMutexLocker locker(&m_mutex);
+        if (!m_file.isOpen() || m_sites.size() >= 0xFFFF) {
+            return 0;
+        }
+
+        m_sites.append({level, LogTags::id(QString::fromUtf8(tag)), QByteArray(tag),
+                        QByteArray(format), QByteArray(signature)});
+        const quint16 id = quint16(m_sites.size());
+        writeSite(id);
+        return id;
+    }
+
+    /**
+     * @return false if the record could not be kept: no file or unknown
+     *         site (a record below its tag's level counts as kept)
+     */
+    bool append(quint32 siteId, const char* payload, qsizetype size, const Logger& levels)
+    {
+        const qint64 now = QDateTime::currentMSecsSinceEpoch();
+
+        QMutexLocker locker(&m_mutex);
+        if (!m_file.isOpen() || siteId == 0 || siteId > quint32(m_sites.size())) {
+            return false;
+        }
+        if (!levels.isEnabled(m_sites.at(siteId - 1).level, m_sites.at(siteId - 1).tagId)) {
+            return true;
+        }
+
+        qint64 delta = now - m_base;
+        if (delta < 0 || delta > qint64(0xFFFFFFFF)) {
+            m_base = now;
+            delta = 0;
+            put(structured::ClockRecord);
+            put(m_base);
+        }
+        put(structured::EntryRecord);
+        put(quint16(siteId));
+        put(quint32(delta));
+        m_buffer.append(payload, size);
+
+        if (m_buffer.size() >= FlushThreshold) {
+            writeBuffer();
+        }
+        return true;
+    }
+
+    void flush()
+    {
+        QMutexLocker locker(&m_mutex);
+        if (m_file.isOpen()) {
+            writeBuffer();
+            m_file.flush();
+        }
+    }
+
+private:
+    struct SiteInfo
+    {
+        Level level;
+        int tagId;
+        QByteArray tag;        // Copies: the strings may live in a plugin
+        QByteArray format;     // that is unloaded before the next open()
+        QByteArray signature;
+    };
+
+    template<typename T>
+    void put(T value)
+    {
+        m_buffer.append(reinterpret_cast<const char*>(&value), qsizetype(sizeof(value)));
+    }
+
+    void putString(const QByteArray& text)
+    {
+        const QByteArray clipped = text.left(0xFFFF);
+        put(quint16(clipped.size()));
+        m_buffer.append(clipped);
+    }
+
+    void writeSite(quint16 id)
+    {
+        const SiteInfo& site = m_sites.at(id - 1);
+        put(structured::SiteRecord);
+        put(id);
+        put(quint8(site.level));
+        putString(site.tag);
+        putString(site.format);
+        put(quint8(site.signature.size()));
+        m_buffer.append(site.signature);
+    }
+
+    void writeBuffer()
+    {
+        if (!m_buffer.isEmpty() && m_file.write(m_buffer) != m_buffer.size()) {
+            qWarning() << "Logger: Cannot write structured log" << m_file.fileName()
+                       << ":" << m_file.errorString();
+        }
+        m_buffer.resize(0);  // Keeps the capacity
+    }
+
+    void closeLocked()
+    {
+        if (m_file.isOpen()) {
+            writeBuffer();
+            m_file.close();
+        }
+        m_buffer.resize(0);
+    }
+
+    mutable QMutex m_mutex;
+    QFile m_file;
+    QByteArray m_buffer;
+    qint64 m_base = 0;
+    QList<SiteInfo> m_sites;  // Index + 1 is the site ID
+};
+
 Logger* Logger::s_instance = nullptr;
 
 Logger::Logger(QObject* parent)
     : QObject(parent)
+    , m_tagLevels(std::make_unique<std::atomic<Level>[]>(LogTags::MaxTags))
+    , m_structured(std::make_unique<StructuredOutput>())
+    , m_generation(++s_generations)
 {
+    for (int i = 0; i < LogTags::MaxTags; ++i) {
+        m_tagLevels[i].store(m_minLevel.load(), std::memory_order_relaxed);
+    }
+
     if (!s_instance) {
         s_instance = this;
     }
@@ -16,6 +356,11 @@ Logger::Logger(QObject* parent)
 
 Logger::~Logger()
 {
+    stopAsync();
+
+    if (LoggerAccess::instance() == this) {
+        LoggerAccess::setInstance(nullptr);
+    }
     if (s_instance == this) {
         s_instance = nullptr;
     }
@@ -23,46 +368,233 @@ Logger::~Logger()
 
 void Logger::log(Level level, const QString& tag, const QString& message)
 {
-    if (level < m_minLevel) {
+    if (!isEnabled(level)) {
+        return;
+    }
+    if (!m_hasTagOverrides.load(std::memory_order_relaxed)) {
+        logTagged(level, -1, tag, message);
+        return;
+    }
+
+    // Direct callers have no tag ID; they tend to repeat a tag, so keep the
+    // last one per thread rather than take the LogTags mutex every time
+    thread_local QString lastTag;
+    thread_local int lastId = -1;
+    if (lastTag.isNull() || tag != lastTag) {
+        lastId = LogTags::id(tag);
+        lastTag = tag;
+    }
+    logTagged(level, lastId, tag, message);
+}
+
+void Logger::logTagged(Level level, int tagId, const QString& tag, const QString& message)
+{
+    if (!isEnabled(level, tagId)) {
         return;
     }
 
+    const qint64 timestampMs = QDateTime::currentMSecsSinceEpoch();
+    if (Writer* writer = m_writer.load(std::memory_order_acquire)) {
+        LogRecord record{level, timestampMs, tag, message};
+        switch (writer->push(record)) {
+        case Writer::Push::Queued:
+            return;
+        case Writer::Push::Dropped:
+            m_dropped.fetch_add(1, std::memory_order_relaxed);
+            return;
+        case Writer::Push::Closed:
+            break;  // stopAsync() ran meanwhile: the thread is gone, write it here
+        }
+    }
+
+    write(level, tag, message, timestampMs);
+}
+
+void Logger::write(Level level, const QString& tag, const QString& message, qint64 timestampMs)
+{
     QMutexLocker locker(&m_mutex);
     
+    const QString* formatted = nullptr;
+    if (m_fileSink) {
+        formatted = &formatMessage(level, tag, message, timestampMs);
+        m_fileSink->write(*formatted, level == Level::Error);
+    }
+
     if (m_handler) {
         m_handler(level, tag, message);
         return;
     }
+    if (!m_consoleOutput) {
+        return;
+    }
     
-    QString formatted = formatMessage(level, tag, message);
+    if (!formatted) {
+        formatted = &formatMessage(level, tag, message, timestampMs);
+    }
     
     switch (level) {
     case Level::Trace:
     case Level::Debug:
-        qDebug().noquote() << formatted;
+        qDebug().noquote() << *formatted;
         break;
     case Level::Info:
-        qInfo().noquote() << formatted;
+        qInfo().noquote() << *formatted;
         break;
     case Level::Warning:
-        qWarning().noquote() << formatted;
+        qWarning().noquote() << *formatted;
         break;
     case Level::Error:
-        qCritical().noquote() << formatted;
+        qCritical().noquote() << *formatted;
         break;
     }
 }
 
 void Logger::setMinLevel(Level level)
 {
-    QMutexLocker locker(&m_mutex);
-    m_minLevel = level;
+    QMutexLocker locker(&m_levelMutex);
+    m_minLevel.store(level, std::memory_order_relaxed);
+    updateLevels();
 }
 
 ILogger::Level Logger::minLevel() const
 {
-    QMutexLocker locker(&m_mutex);
-    return m_minLevel;
+    return m_minLevel.load(std::memory_order_relaxed);
+}
+
+void Logger::setTagLevel(const QString& tag, Level level)
+{
+    QMutexLocker locker(&m_levelMutex);
+    m_tagOverrides.insert(tag, level);
+    updateLevels();
+}
+
+void Logger::clearTagLevel(const QString& tag)
+{
+    QMutexLocker locker(&m_levelMutex);
+    if (m_tagOverrides.remove(tag)) {
+        updateLevels();
+    }
+}
+
+bool Logger::setTagLevels(const QString& spec)
+{
+    std::optional<Level> global;
+    QHash<QString, Level> overrides;
+    for (const QString& part : spec.split(QRegularExpression("[,;]"), Qt::SkipEmptyParts)) {
+        const QString entry = part.trimmed();
+        if (entry.isEmpty()) {
+            continue;
+        }
+        const qsizetype equals = entry.indexOf('=');
+        const QString tag = entry.left(equals).trimmed();
+        Level level;
+        if (equals <= 0 || tag.isEmpty()
+            || !parseLevel(QStringView(entry).sliced(equals + 1).trimmed(), &level)) {
+            qWarning() << "Logger: Invalid tag level" << entry << "in" << spec;
+            return false;
+        }
+        if (tag == QLatin1String("*")) {
+            global = level;
+        } else {
+            overrides.insert(tag, level);
+        }
+    }
+
+    QMutexLocker locker(&m_levelMutex);
+    if (global) {
+        m_minLevel.store(*global, std::memory_order_relaxed);
+    }
+    m_tagOverrides = std::move(overrides);
+    updateLevels();
+    return true;
+}
+
+QHash<QString, ILogger::Level> Logger::tagLevels() const
+{
+    QMutexLocker locker(&m_levelMutex);
+    return m_tagOverrides;
+}
+
+bool Logger::parseLevel(QStringView name, Level* level)
+{
+    static const struct {
+        QLatin1String name;
+        Level level;
+    } levels[] = {
+        {QLatin1String("trace"), Level::Trace},
+        {QLatin1String("debug"), Level::Debug},
+        {QLatin1String("info"), Level::Info},
+        {QLatin1String("warning"), Level::Warning},
+        {QLatin1String("warn"), Level::Warning},
+        {QLatin1String("error"), Level::Error},
+    };
+    for (const auto& entry : levels) {
+        if (name.compare(entry.name, Qt::CaseInsensitive) == 0) {
+            *level = entry.level;
+            return true;
+        }
+    }
+    return false;
+}
+
+void Logger::updateLevels()
+{
+    // Rewrites the whole table: level changes are rare, checks are not
+    const Level global = m_minLevel.load(std::memory_order_relaxed);
+    for (int i = 0; i < LogTags::MaxTags; ++i) {
+        m_tagLevels[i].store(global, std::memory_order_relaxed);
+    }
+
+    Level lowest = global;
+    for (auto it = m_tagOverrides.cbegin(); it != m_tagOverrides.cend(); ++it) {
+        const int id = LogTags::id(it.key());
+        if (id < 0) {
+            qWarning() << "Logger: Too many log tags, ignoring the level of" << it.key();
+            continue;
+        }
+        m_tagLevels[id].store(it.value(), std::memory_order_relaxed);
+        lowest = qMin(lowest, it.value());
+    }
+    m_lowestLevel.store(lowest, std::memory_order_relaxed);
+    m_hasTagOverrides.store(!m_tagOverrides.isEmpty(), std::memory_order_relaxed);
+
+    // Plugins check the cached copy before calling into the logger
+    if (LoggerAccess::instance() == this) {
+        LoggerAccess::setMinLevel(lowest);
+    }
+}
+
+quint32 Logger::structuredSite(Level level, const char* tag, const char* format,
+                               const char* signature)
+{
+    return m_structured->addSite(level, tag, format, signature);
+}
+
+bool Logger::logStructured(quint32 siteId, const char* payload, qsizetype size)
+{
+    return m_structured->append(siteId, payload, size, *this);
+}
+
+bool Logger::setStructuredOutput(const QString& path)
+{
+    // Sites fall back to text from here on; open() closes the current file
+    // even if the new one fails
+    m_structuredEpoch.store(0, std::memory_order_relaxed);
+    if (path.isEmpty()) {
+        m_structured->close();
+        return true;
+    }
+    if (!m_structured->open(path)) {
+        return false;
+    }
+    // Sites are kept across files, so their IDs stay valid
+    m_structuredEpoch.store(m_generation, std::memory_order_relaxed);
+    return true;
+}
+
+QString Logger::structuredOutput() const
+{
+    return m_structured->path();
 }
 
 void Logger::setHandler(LogHandler handler)
@@ -71,10 +603,41 @@ void Logger::setHandler(LogHandler handler)
     m_handler = std::move(handler);
 }
 
+void Logger::setFileSink(std::unique_ptr<FileLogSink> sink)
+{
+    std::unique_ptr<FileLogSink> previous;
+    {
+        QMutexLocker locker(&m_mutex);
+        previous = std::exchange(m_fileSink, std::move(sink));
+    }
+    // Closed outside the lock: it waits for its thread to write everything
+}
+
+FileLogSink* Logger::fileSink() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_fileSink.get();
+}
+
+void Logger::setConsoleOutput(bool enabled)
+{
+    QMutexLocker locker(&m_mutex);
+    m_consoleOutput = enabled;
+}
+
+bool Logger::consoleOutput() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_consoleOutput;
+}
+
 void Logger::setFormat(const QString& format)
 {
+    QList<FormatToken> tokens = compileFormat(format);
+
     QMutexLocker locker(&m_mutex);
     m_format = format;
+    m_tokens = std::move(tokens);
 }
 
 QString Logger::format() const
@@ -83,6 +646,39 @@ QString Logger::format() const
     return m_format;
 }
 
+void Logger::startAsync(int capacity, OverflowPolicy policy)
+{
+    stopAsync();
+
+    // A caller may still hold the previous writer (see log()); keep it
+    if (m_ownedWriter) {
+        m_retiredWriters.push_back(std::move(m_ownedWriter));
+    }
+    m_ownedWriter = std::make_unique<Writer>(this, capacity, policy);
+    m_ownedWriter->start();
+    m_writer.store(m_ownedWriter.get(), std::memory_order_release);
+}
+
+void Logger::stopAsync()
+{
+    if (Writer* writer = m_writer.exchange(nullptr, std::memory_order_acq_rel)) {
+        writer->stop();  // Drains the buffer first
+    }
+}
+
+void Logger::flush()
+{
+    if (Writer* writer = m_writer.load(std::memory_order_acquire)) {
+        writer->flush();
+    }
+    m_structured->flush();
+
+    QMutexLocker locker(&m_mutex);
+    if (m_fileSink) {
+        m_fileSink->flush();
+    }
+}
+
 Logger* Logger::instance()
 {
     return s_instance;
@@ -93,27 +689,114 @@ void Logger::setInstance(Logger* logger)
     s_instance = logger;
 }
 
-QString Logger::formatMessage(Level level, const QString& tag, const QString& message)
+QList<Logger::FormatToken> Logger::compileFormat(const QString& format)
+{
+    static const struct {
+        QLatin1String placeholder;
+        FormatToken::Kind kind;
+    } placeholders[] = {
+        {QLatin1String("%level%"), FormatToken::Kind::Level},
+        {QLatin1String("%tag%"), FormatToken::Kind::Tag},
+        {QLatin1String("%message%"), FormatToken::Kind::Message},
+        {QLatin1String("%time%"), FormatToken::Kind::Time},
+        {QLatin1String("%date%"), FormatToken::Kind::Date},
+    };
+
+    QList<FormatToken> tokens;
+    QString literal;
+    qsizetype pos = 0;
+    while (pos < format.size()) {
+        bool matched = false;
+        if (format.at(pos) == u'%') {
+            for (const auto& entry : placeholders) {
+                if (QStringView(format).sliced(pos).startsWith(entry.placeholder)) {
+                    if (!literal.isEmpty()) {
+                        tokens.append({FormatToken::Kind::Literal, literal});
+                        literal.clear();
+                    }
+                    tokens.append({entry.kind, QString()});
+                    pos += entry.placeholder.size();
+                    matched = true;
+                    break;
+                }
+            }
+        }
+        if (!matched) {
+            literal.append(format.at(pos++));
+        }
+    }
+    if (!literal.isEmpty()) {
+        tokens.append({FormatToken::Kind::Literal, literal});
+    }
+    return tokens;
+}
+
+void Logger::updateClock(qint64 timestampMs)
 {
-    QString result = m_format;
-    result.replace("%level%", levelToString(level));
-    result.replace("%tag%", tag);
-    result.replace("%message%", message);
-    result.replace("%time%", QDateTime::currentDateTime().toString("hh:mm:ss.zzz"));
-    result.replace("%date%", QDateTime::currentDateTime().toString("yyyy-MM-dd"));
-    return result;
+    // Convert to local time once per second; the date string only changes daily
+    const qint64 second = timestampMs >= 0 ? timestampMs / 1000 : (timestampMs - 999) / 1000;
+    if (second == m_clockSecond) {
+        return;
+    }
+    m_clockSecond = second;
+
+    const QDateTime time = QDateTime::fromMSecsSinceEpoch(second * 1000);
+    m_secondText = time.toString("hh:mm:ss");
+    if (time.date() != m_day) {
+        m_day = time.date();
+        m_dateText = m_day.toString("yyyy-MM-dd");
+    }
+}
+
+const QString& Logger::formatMessage(Level level, const QString& tag, const QString& message,
+                                     qint64 timestampMs)
+{
+    // m_line keeps its capacity across messages, so steady-state
+    // formatting does not allocate
+    m_line.resize(0);
+
+    for (const FormatToken& token : std::as_const(m_tokens)) {
+        switch (token.kind) {
+        case FormatToken::Kind::Literal:
+            m_line.append(token.text);
+            break;
+        case FormatToken::Kind::Level:
+            m_line.append(levelToString(level));
+            break;
+        case FormatToken::Kind::Tag:
+            m_line.append(tag);
+            break;
+        case FormatToken::Kind::Message:
+            m_line.append(message);
+            break;
+        case FormatToken::Kind::Time: {
+            updateClock(timestampMs);
+            const int ms = int(timestampMs - m_clockSecond * 1000);
+            const char millis[] = {'.', char('0' + ms / 100), char('0' + ms / 10 % 10),
+                                   char('0' + ms % 10)};
+            m_line.append(m_secondText);
+            m_line.append(QLatin1String(millis, 4));
+            break;
+        }
+        case FormatToken::Kind::Date:
+            updateClock(timestampMs);
+            m_line.append(m_dateText);
+            break;
+        }
+    }
+    return m_line;
 }
 
-QString Logger::levelToString(Level level)
+QLatin1String Logger::levelToString(Level level)
 {
     switch (level) {
-    case Level::Trace:   return "TRACE";
-    case Level::Debug:   return "DEBUG";
-    case Level::Info:    return "INFO ";
-    case Level::Warning: return "WARN ";
-    case Level::Error:   return "ERROR";
+    case Level::Trace:   return QLatin1String("TRACE");
+    case Level::Debug:   return QLatin1String("DEBUG");
+    case Level::Info:    return QLatin1String("INFO ");
+    case Level::Warning: return QLatin1String("WARN ");
+    case Level::Error:   return QLatin1String("ERROR");
     }
-    return "?????";
+    return QLatin1String("?????");
 }
 
 } // namespace mpf
@@ -1,4 +1,5 @@
 #include "navigation_service.h"
+#include "plugin_context.h"
 #include <QQmlApplicationEngine>
 #include <QQmlComponent>
 #include <QQmlContext>
@@ -142,11 +143,24 @@ bool NavigationService::canGoBack() const
 
 void NavigationService::registerRoute(const QString& route, const QString& qmlComponent)
 {
-    RouteEntry entry{route, qmlComponent};
+    RouteEntry entry{route, qmlComponent, PluginContext::current()};
     m_routes.append(entry);
     qDebug() << "NavigationService: Registered route" << route << "->" << qmlComponent;
 }
 
+void NavigationService::unregisterPlugin(const QString& pluginId)
+{
+    m_routes.removeIf([&pluginId](const RouteEntry& e) { return e.owner == pluginId; });
+    m_deferredRoutes.removeIf([&pluginId](const RouteEntry& e) { return e.component == pluginId; });
+}
+
+void NavigationService::registerDeferredRoute(const QString& route, const QString& pluginId)
+{
+    RouteEntry entry{route, pluginId};
+    m_deferredRoutes.append(entry);
+    qDebug() << "NavigationService: Deferred route" << route << "->" << pluginId;
+}
+
 QObject* NavigationService::stackView() const
 {
     if (!m_engine) return nullptr;
@@ -157,21 +171,48 @@ QObject* NavigationService::stackView() const
     return roots.first()->findChild<QObject*>(m_stackViewId);
 }
 
+bool NavigationService::routeMatches(const QString& pattern, const QString& route)
+{
+    // Simple pattern matching (could be enhanced with regex)
+    if (pattern == route || pattern == "*") {
+        return true;
+    }
+
+    // Wildcard prefix matching
+    if (pattern.endsWith("/*")) {
+        QString prefix = pattern.left(pattern.length() - 2);
+        return route.startsWith(prefix);
+    }
+    return false;
+}
+
 QVariant NavigationService::resolveComponent(const QString& route)
 {
     // Find matching route
     for (const RouteEntry& entry : m_routes) {
-        // Simple pattern matching (could be enhanced with regex)
-        if (entry.pattern == route || entry.pattern == "*") {
+        if (routeMatches(entry.pattern, route)) {
             return QVariant::fromValue(QUrl(entry.component));
         }
-        
-        // Wildcard prefix matching
-        if (entry.pattern.endsWith("/*")) {
-            QString prefix = entry.pattern.left(entry.pattern.length() - 2);
-            if (route.startsWith(prefix)) {
-                return QVariant::fromValue(QUrl(entry.component));
-            }
+    }
+
+    // Load the plugin behind a deferred route, then look again
+    QString pluginId;
+    for (const RouteEntry& entry : std::as_const(m_deferredRoutes)) {
+        if (routeMatches(entry.pattern, route)) {
+            pluginId = entry.component;
+            break;
+        }
+    }
+
+    if (!pluginId.isEmpty() && m_activator) {
+        // Drop the plugin's stubs first so activation is attempted only once
+        m_deferredRoutes.removeIf([&pluginId](const RouteEntry& e) {
+            return e.component == pluginId;
+        });
+
+        qDebug() << "NavigationService: Activating" << pluginId << "for route" << route;
+        if (m_activator(pluginId)) {
+            return resolveComponent(route);
         }
     }
 
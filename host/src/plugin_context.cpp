@@ -0,0 +1,24 @@
+#include "plugin_context.h"
+
+namespace mpf {
+
+thread_local QString PluginContext::s_current;
+
+QString PluginContext::current()
+{
+    return s_current;
+}
+
+PluginContext::Scope::Scope(const QString& pluginId)
+    : m_previous(s_current)
+    , m_memory(PluginMemory::isEnabled() ? PluginMemory::slotFor(pluginId) : 0)
+{
+    s_current = pluginId;
+}
+
+PluginContext::Scope::~Scope()
+{
+    s_current = m_previous;
+}
+
+} // namespace mpf
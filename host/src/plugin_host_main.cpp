@@ -0,0 +1,256 @@
+// mpf-plugin-host: runs one out-of-process plugin for mpf-host.
+//
+// Usage: mpf-plugin-host --server <local server name> --token <token> --plugin <library>
+//
+// Connects back to the host, loads the plugin library and serves the
+// RemotePlugin protocol (see ipc_channel.h) until told to stop or the
+// host goes away.
+
+#include "event_bus_service.h"
+#include "ipc_channel.h"
+#include "logger.h"
+#include "plugin_context.h"
+#include "service_registry.h"
+#include <mpf/interfaces/iplugin.h>
+#include <mpf/logger_access.h>
+
+#include <QCommandLineParser>
+#include <QCoreApplication>
+#include <QFuture>
+#include <QJsonArray>
+#include <QLocalSocket>
+#include <QPluginLoader>
+#include <QPointer>
+#include <QScopedValueRollback>
+#include <QDebug>
+
+using namespace mpf;
+
+namespace {
+
+constexpr int ConnectTimeoutMs = 5000;
+
+struct PluginHost
+{
+    ServiceRegistryImpl registry;
+    Logger logger;
+    EventBusService eventBus;
+    QPluginLoader loader;
+    IPlugin* plugin = nullptr;
+    QString pluginId;
+    QStringList provides;
+    QHash<QString, QPointer<QObject>> services;  // Resolved on first call
+    bool asyncStart = false;
+    bool running = false;
+    bool relaying = false;
+};
+
+void sendSubscriptions(PluginHost& host, IpcChannel& channel)
+{
+    IpcMessage message;
+    message.type = IpcMessage::Type::Subscriptions;
+    for (const QString& pattern : host.eventBus.activeTopics()) {
+        message.args.append(pattern);
+    }
+    channel.send(message);
+}
+
+void started(PluginHost& host, IpcChannel& channel, bool ok)
+{
+    host.running = ok;
+
+    IpcMessage message;
+    message.type = IpcMessage::Type::Started;
+    message.ok = ok;
+    if (ok) {
+        for (const QString& name : std::as_const(host.provides)) {
+            if (host.registry.serviceNamed(name)) {
+                message.args.append(name);
+            }
+        }
+    }
+    channel.send(message);
+}
+
+void startPlugin(PluginHost& host, IpcChannel& channel)
+{
+    if (!host.plugin) {
+        started(host, channel, false);
+        return;
+    }
+
+    bool startedSync = false;
+    QFuture<bool> future;
+    {
+        PluginContext::Scope scope(host.pluginId);
+        if (!host.plugin->initialize(&host.registry)) {
+            qWarning() << "mpf-plugin-host:" << host.pluginId << "failed to initialize";
+            started(host, channel, false);
+            return;
+        }
+        // Same contract as in-process: startAsync() only when opted in
+        if (!host.asyncStart) {
+            startedSync = host.plugin->start();
+        } else {
+            future = host.plugin->startAsync();
+        }
+    }
+
+    if (!host.asyncStart) {
+        started(host, channel, startedSync);
+        return;
+    }
+    if (future.isFinished()) {
+        started(host, channel, future.resultCount() > 0 && future.result());
+        return;
+    }
+    future.then(&channel, [&host, &channel](bool ok) {
+        started(host, channel, ok);
+    }).onFailed(&channel, [&host, &channel]() {
+        started(host, channel, false);
+    }).onCanceled(&channel, [&host, &channel]() {
+        started(host, channel, false);
+    });
+}
+
+void stopPlugin(PluginHost& host)
+{
+    if (host.running) {
+        PluginContext::Scope scope(host.pluginId);
+        host.plugin->stop();
+        host.running = false;
+    }
+}
+
+void handleCall(PluginHost& host, IpcChannel& channel, const IpcMessage& call)
+{
+    QPointer<QObject>& target = host.services[call.name];
+    if (!target) {
+        target = host.registry.serviceNamed(call.name);
+    }
+
+    IpcMessage reply;
+    reply.type = IpcMessage::Type::Reply;
+    reply.id = call.id;
+    {
+        PluginContext::Scope scope(host.pluginId);
+        reply.ok = IpcChannel::invoke(target, call.method, call.args, &reply.result, &reply.method);
+    }
+
+    if (call.id != 0) {
+        channel.send(reply);
+    } else if (!reply.ok) {
+        qWarning() << "mpf-plugin-host: Posted call" << call.name << call.method
+                   << "failed:" << reply.method;
+    }
+}
+
+} // namespace
+
+int main(int argc, char* argv[])
+{
+    QCoreApplication app(argc, argv);
+    app.setApplicationName("mpf-plugin-host");
+
+    QCommandLineParser parser;
+    parser.addOption({"server", "Local server of the host to connect to.", "name"});
+    parser.addOption({"token", "Token proving to the host that it spawned us.", "token"});
+    parser.addOption({"plugin", "Plugin library to load.", "path"});
+    parser.process(app);
+
+    if (!parser.isSet("server") || !parser.isSet("token") || !parser.isSet("plugin")) {
+        qCritical() << "mpf-plugin-host: --server, --token and --plugin are required";
+        return 2;
+    }
+
+    PluginHost host;
+    Logger::setInstance(&host.logger);
+    LoggerAccess::setInstance(&host.logger);
+    host.registry.add<ILogger>(&host.logger, ILogger::apiVersion(), "host");
+    host.registry.add<IEventBus>(&host.eventBus, IEventBus::apiVersion(), "host");
+
+    QLocalSocket socket;
+    socket.connectToServer(parser.value("server"));
+    if (!socket.waitForConnected(ConnectTimeoutMs)) {
+        qCritical() << "mpf-plugin-host: Cannot connect to" << parser.value("server")
+                    << ":" << socket.errorString();
+        return 1;
+    }
+    IpcChannel channel(&socket);
+
+    // Load the plugin and report back
+    IpcMessage hello;
+    hello.type = IpcMessage::Type::Hello;
+    hello.args = {parser.value("token")};
+    host.loader.setFileName(parser.value("plugin"));
+    if (host.loader.load()) {
+        host.plugin = qobject_cast<IPlugin*>(host.loader.instance());
+    }
+    if (host.plugin) {
+        host.plugin->attachLogger(LoggerAccess::shared());
+        const QJsonObject metadata = host.plugin->metadata();
+        host.pluginId = metadata.value("id").toString();
+        host.asyncStart = metadata.value("asyncStart").toBool();
+        for (const auto& value : metadata.value("provides").toArray()) {
+            host.provides.append(value.toString());
+        }
+        hello.name = host.pluginId;
+    } else {
+        hello.ok = false;
+        hello.method = host.loader.isLoaded() ? QStringLiteral("Plugin does not implement IPlugin interface")
+                                              : host.loader.errorString();
+    }
+    channel.send(hello);
+
+    // Local events go to the host, except the ones it relayed to us
+    QObject::connect(&host.eventBus, &EventBusService::eventPublished, &channel,
+                     [&host, &channel](const QString& topic, const QVariantMap& data, const QString& senderId) {
+        if (host.relaying) return;
+        IpcMessage message;
+        message.type = IpcMessage::Type::Event;
+        message.name = topic;
+        message.args = {data, senderId};
+        channel.send(message);
+    });
+    QObject::connect(&host.eventBus, &EventBusService::topicsChanged, &channel,
+                     [&host, &channel]() { sendSubscriptions(host, channel); });
+
+    QObject::connect(&channel, &IpcChannel::messageReceived, &app,
+                     [&host, &channel, &app](const IpcMessage& message) {
+        switch (message.type) {
+        case IpcMessage::Type::Start:
+            startPlugin(host, channel);
+            break;
+        case IpcMessage::Type::Call:
+            handleCall(host, channel, message);
+            break;
+        case IpcMessage::Type::Event: {
+            QScopedValueRollback<bool> guard(host.relaying, true);
+            host.eventBus.publishSync(message.name, message.args.value(0).toMap(),
+                                      message.args.value(1).toString());
+            break;
+        }
+        case IpcMessage::Type::Stop:
+            stopPlugin(host);
+            channel.flush();
+            app.quit();
+            break;
+        default:
+            qWarning() << "mpf-plugin-host: Unexpected message" << int(message.type);
+            break;
+        }
+    });
+
+    // The host exited or crashed
+    QObject::connect(&channel, &IpcChannel::disconnected, &app, [&host, &app]() {
+        stopPlugin(host);
+        app.quit();
+    });
+
+    const int result = app.exec();
+
+    host.services.clear();
+    host.registry.removeServicesFrom(host.pluginId);
+    Logger::setInstance(nullptr);
+    return result;
+}
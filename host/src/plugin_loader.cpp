@@ -1,18 +1,31 @@
 #include "plugin_loader.h"
 #include <mpf/interfaces/iplugin.h>
+#include <mpf/logger_access.h>
 #include "plugin_metadata.h"
+#include "plugin_memory.h"
+#include "remote_plugin.h"
 
+#include <QElapsedTimer>
 #include <QFileInfo>
 #include <QJsonDocument>
 #include <QDebug>
 
 namespace mpf {
 
-PluginLoader::PluginLoader(const QString& path, QObject* parent)
+PluginLoader::PluginLoader(const QString& path, const PluginMetadata& metadata, QObject* parent)
     : QObject(parent)
     , m_path(path)
-    , m_loader(std::make_unique<QPluginLoader>(path, this))
-    , m_metadata(std::make_unique<PluginMetadata>())
+    , m_metadata(std::make_unique<PluginMetadata>(metadata))
+    , m_memorySlot(PluginMemory::isEnabled() ? PluginMemory::slotFor(metadata.id()) : 0)
+{
+}
+
+PluginLoader::PluginLoader(const QStaticPlugin& plugin, const PluginMetadata& metadata, QObject* parent)
+    : QObject(parent)
+    , m_path(QStringLiteral(":static/") + plugin.metaData().value("className").toString())
+    , m_staticPlugin(plugin)
+    , m_metadata(std::make_unique<PluginMetadata>(metadata))
+    , m_memorySlot(PluginMemory::isEnabled() ? PluginMemory::slotFor(metadata.id()) : 0)
 {
 }
 
@@ -29,11 +42,7 @@ bool PluginLoader::load()
         return true;
     }
 
-    // Load metadata from plugin
-    QJsonObject metaJson = m_loader->metaData().value("MetaData").toObject();
-    *m_metadata = PluginMetadata(metaJson);
-    
-    // Validate metadata
+    // Validate metadata (read once by PluginManager::discover)
     QStringList errors = m_metadata->validate();
     if (!errors.isEmpty()) {
         m_errorString = QString("Invalid metadata: %1").arg(errors.join("; "));
@@ -42,33 +51,72 @@ bool PluginLoader::load()
         return false;
     }
 
-    // Load the plugin
-    if (!m_loader->load()) {
-        m_errorString = m_loader->errorString();
-        m_state = State::Error;
-        emit errorOccurred(m_errorString);
-        return false;
+    QElapsedTimer timer;
+    timer.start();
+
+    QObject* instance = nullptr;
+    if (isRemote()) {
+        // The library is loaded by the child process, never mapped here
+        m_remote = std::make_unique<RemotePlugin>(m_path, m_metadata->toJson());
+        connect(m_remote.get(), &RemotePlugin::crashed, this, [this](const QString& reason) {
+            m_errorString = reason;
+            m_state = State::Error;
+            emit stateChanged(m_state);
+            emit errorOccurred(m_errorString);
+            emit crashed(reason);
+        });
+        if (!m_remote->launch()) {
+            m_remote.reset();
+            m_errorString = "Failed to launch plugin host process";
+            m_state = State::Error;
+            emit errorOccurred(m_errorString);
+            return false;
+        }
+        instance = m_remote.get();
+    } else if (isStatic()) {
+        // Linked into the host: nothing to map or resolve
+        instance = m_staticPlugin.instance();
+        m_staticInstance = instance;
+    } else {
+        if (!m_loader) {
+            m_loader = std::make_unique<QPluginLoader>(m_path, this);
+        }
+
+        // Load the plugin
+        if (!m_loader->load()) {
+            m_errorString = m_loader->errorString();
+            m_state = State::Error;
+            emit errorOccurred(m_errorString);
+            return false;
+        }
+
+        // Get the plugin instance
+        instance = m_loader->instance();
     }
 
-    // Get the plugin instance
-    QObject* instance = m_loader->instance();
     if (!instance) {
         m_errorString = "Failed to get plugin instance";
         m_state = State::Error;
-        m_loader->unload();
+        if (m_loader) m_loader->unload();
         emit errorOccurred(m_errorString);
         return false;
     }
 
     m_plugin = qobject_cast<IPlugin*>(instance);
     if (!m_plugin) {
-        m_errorString = "Plugin does not implement IPlugin interface";
+        m_errorString = QString("Plugin does not implement IPlugin interface %1"
+                                " (built against another SDK version?)")
+                            .arg(QLatin1String(MPF_IPlugin_iid));
         m_state = State::Error;
-        m_loader->unload();
+        if (m_loader) m_loader->unload();
         emit errorOccurred(m_errorString);
         return false;
     }
 
+    // Before any plugin code runs, so its MPF_LOG_* reach the host's logger
+    m_plugin->attachLogger(LoggerAccess::shared());
+
+    m_loadNs = timer.nsecsElapsed();
     m_state = State::Loaded;
     emit stateChanged(m_state);
     return true;
@@ -81,8 +129,15 @@ bool PluginLoader::unload()
     }
 
     m_plugin = nullptr;
+
+    // Like QPluginLoader::unload(), drop the root object so the next load()
+    // starts from a fresh instance; the code itself stays in the host
+    delete m_staticInstance.data();
+
+    // Stops the child process
+    m_remote.reset();
     
-    if (!m_loader->unload()) {
+    if (m_loader && !m_loader->unload()) {
         m_errorString = m_loader->errorString();
         emit errorOccurred(m_errorString);
         return false;
@@ -93,4 +148,33 @@ bool PluginLoader::unload()
     return true;
 }
 
+bool PluginLoader::isRemote() const
+{
+    return !isStatic() && m_metadata->outOfProcess();
+}
+
+PluginLoader::MemoryUsage PluginLoader::sampleMemory()
+{
+    MemoryUsage usage;
+
+    if (m_memorySlot != 0) {
+        const PluginMemory::Usage counters = PluginMemory::usage(m_memorySlot);
+        usage.liveBytes = counters.liveBytes;
+        usage.peakBytes = counters.peakBytes;
+        usage.allocatedBytes = counters.allocatedBytes;
+
+        if (m_sampleTimer.isValid() && m_sampleTimer.elapsed() > 0) {
+            usage.allocationRate = double(counters.allocatedBytes - m_sampledBytes) * 1000.0
+                / double(m_sampleTimer.elapsed());
+        }
+        m_sampledBytes = counters.allocatedBytes;
+        m_sampleTimer.start();
+    }
+
+    if (auto* root = dynamic_cast<QObject*>(m_plugin)) {
+        usage.objectCount = 1 + int(root->findChildren<QObject*>().size());
+    }
+    return usage;
+}
+
 } // namespace mpf
@@ -2,25 +2,52 @@
 #include "plugin_loader.h"
 #include "service_registry.h"
 #include "plugin_metadata.h"
+#include "plugin_metadata_cache.h"
+#include "plugin_context.h"
+#include "navigation_service.h"
+#include "startup_tracer.h"
+#include "plugin_watchdog.h"
+#include "plugin_memory.h"
 #include <mpf/interfaces/iplugin.h>
+#include <mpf/interfaces/ieventbus.h>
+#include <mpf/interfaces/imenu.h>
+#include <mpf/interfaces/inavigation.h>
 
 #include <QDir>
+#include <QFile>
 #include <QFileInfo>
+#include <QPluginLoader>
+#include <QThread>
+#include <QThreadPool>
+#include <QElapsedTimer>
+#include <QSet>
+#include <QTemporaryDir>
+#include <QScopedValueRollback>
+#include <QFuture>
+#include <QTextStream>
 #include <QDebug>
 #include <algorithm>
+#include <queue>
+#include <utility>
+#include <vector>
 
 namespace mpf {
 
 PluginManager::PluginManager(ServiceRegistry* registry, QObject* parent)
     : QObject(parent)
     , m_registry(registry)
+    , m_watchdog(std::make_unique<PluginWatchdog>())
 {
+    connect(m_watchdog.get(), &PluginWatchdog::budgetExceeded,
+            this, &PluginManager::budgetExceeded);
+    m_watchdog->start();
 }
 
 PluginManager::~PluginManager()
 {
     stopAll();
     unloadAll();
+    m_watchdog->shutdown();
 }
 
 int PluginManager::discover(const QString& path)
@@ -42,62 +69,191 @@ int PluginManager::discover(const QString& path)
     QStringList filters = {"*.so"};
 #endif
 
-    for (const QFileInfo& info : dir.entryInfoList(filters, QDir::Files)) {
-        QString pluginPath = info.absoluteFilePath();
-        
-        auto loader = std::make_unique<PluginLoader>(pluginPath, this);
-        
-        // Try to read metadata without fully loading
-        QPluginLoader tempLoader(pluginPath);
-        QJsonObject meta = tempLoader.metaData().value("MetaData").toObject();
+    const QFileInfoList files = dir.entryInfoList(filters, QDir::Files, QDir::Name);
+    if (files.isEmpty()) {
+        return 0;
+    }
+
+    // Reading metadata maps and parses each library, which dominates
+    // discovery on cold disks; do it once per file, in parallel. Each task
+    // writes only its own slot, so no locking is needed.
+    std::vector<QJsonObject> metadata(files.size());
+    {
+        QThreadPool pool;
+        pool.setMaxThreadCount(std::min<int>(files.size(),
+                                             std::max(4, QThread::idealThreadCount())));
+        for (int i = 0; i < files.size(); ++i) {
+            pool.start([this, &metadata, &files, i]() {
+                MPF_TRACE_SPAN("metadata", files.at(i).fileName());
+                metadata[i] = readMetadata(files.at(i));
+            });
+        }
+        pool.waitForDone();
+    }
+
+    if (m_metadataCache) {
+        QStringList livePaths;
+        for (const QFileInfo& info : files) {
+            livePaths.append(info.absoluteFilePath());
+        }
+        m_metadataCache->prune(path, livePaths);
+        m_metadataCache->save();
+        qDebug() << "Plugin metadata cache:" << m_metadataCache->hits() << "hits,"
+                 << m_metadataCache->misses() << "misses";
+    }
+
+    for (int i = 0; i < files.size(); ++i) {
+        const QFileInfo& info = files.at(i);
+        const QJsonObject& meta = metadata[i];
         
         if (meta.isEmpty()) {
             qDebug() << "Skipping non-MPF plugin:" << info.fileName();
             continue;
         }
 
-        PluginMetadata metadata(meta);
-        if (!metadata.isValid()) {
+        PluginMetadata pluginMetadata(meta);
+        if (!pluginMetadata.isValid()) {
             qWarning() << "Invalid plugin metadata:" << info.fileName();
             continue;
         }
 
-        QString id = metadata.id();
-        
-        if (m_pluginMap.contains(id)) {
-            qWarning() << "Duplicate plugin ID:" << id;
+        if (addPlugin(std::make_unique<PluginLoader>(info.absoluteFilePath(), pluginMetadata, this))) {
+            count++;
+        }
+    }
+
+    return count;
+}
+
+int PluginManager::discoverStatic()
+{
+    int count = 0;
+
+    const QList<QStaticPlugin> plugins = QPluginLoader::staticPlugins();
+    for (const QStaticPlugin& plugin : plugins) {
+        const QJsonObject raw = plugin.metaData();
+        if (raw.value("IID").toString() != QLatin1String(MPF_IPlugin_iid)) {
+            continue;  // Qt's own static plugins (platforms, image formats, ...)
+        }
+
+        PluginMetadata pluginMetadata(raw.value("MetaData").toObject());
+        if (!pluginMetadata.isValid()) {
+            qWarning() << "Invalid static plugin metadata:" << raw.value("className").toString();
             continue;
         }
 
-        m_pluginMap[id] = loader.get();
-        m_loaders.push_back(std::move(loader));
-        
-        emit pluginDiscovered(id);
-        count++;
+        if (addPlugin(std::make_unique<PluginLoader>(plugin, pluginMetadata, this))) {
+            count++;
+        }
     }
 
     return count;
 }
 
+bool PluginManager::addPlugin(std::unique_ptr<PluginLoader> loader)
+{
+    const QString id = loader->metadata().id();
+    if (m_pluginMap.contains(id)) {
+        qWarning() << "Duplicate plugin ID:" << id << "- ignoring" << loader->path()
+                   << "in favour of" << m_pluginMap.value(id)->path();
+        return false;
+    }
+
+    m_pluginMap[id] = loader.get();
+    watchCrashes(loader.get());
+    invalidateOrder();
+    m_loaders.push_back(std::move(loader));
+
+    emit pluginDiscovered(id);
+    return true;
+}
+
+void PluginManager::setMetadataCache(const QString& filePath, bool rescan)
+{
+    m_metadataCache = std::make_unique<PluginMetadataCache>(filePath);
+    if (rescan) {
+        m_metadataCache->clear();
+    } else {
+        m_metadataCache->load();
+    }
+}
+
+QJsonObject PluginManager::readMetadata(const QFileInfo& info) const
+{
+    QJsonObject meta;
+    if (m_metadataCache && m_metadataCache->lookup(info, &meta)) {
+        return meta;
+    }
+
+    // Only reads the embedded metadata; the library is not loaded
+    QPluginLoader loader(info.absoluteFilePath());
+    meta = loader.metaData().value("MetaData").toObject();
+
+    // Non-MPF libraries are cached too (as empty), so they are skipped cheaply
+    if (m_metadataCache) {
+        m_metadataCache->insert(info, meta);
+    }
+    return meta;
+}
+
+QJsonObject PluginManager::rereadMetadata(const QString& path) const
+{
+    // A rebuild may keep size and mtime; never trust the cache here
+    const QFileInfo info(path);
+    if (m_metadataCache) {
+        m_metadataCache->remove(info.absoluteFilePath());
+    }
+
+    // Qt keeps the metadata it read for a path while any loader of that
+    // path is alive, which includes the running build; read a copy instead
+    QJsonObject meta;
+    QTemporaryDir dir;
+    const QString copy = dir.filePath(info.fileName());
+    if (dir.isValid() && QFile::copy(info.absoluteFilePath(), copy)) {
+        meta = QPluginLoader(copy).metaData().value("MetaData").toObject();
+    }
+
+    if (m_metadataCache) {
+        m_metadataCache->insert(info, meta);
+        m_metadataCache->save();
+    }
+    return meta;
+}
+
 bool PluginManager::loadAll()
 {
-    QStringList order = computeLoadOrder();
+    ensureOrder();
+    reportCycles();
+    const QStringList order = m_ordering.order;
+    const QStringList deferred = deferredPlugins();
+
+    // Resolve every plugin and service dependency before loading any code,
+    // so nothing is loaded that could not start anyway
+    QStringList startup;
+    for (const QString& id : order) {
+        if (!deferred.contains(id)) {
+            startup.append(id);
+        }
+    }
+    const QSet<QString> rejected = rejectUnresolvable(startup);
     
-    bool allLoaded = true;
+    bool allLoaded = rejected.isEmpty();
     for (const QString& id : order) {
         PluginLoader* loader = m_pluginMap.value(id);
-        if (!loader) continue;
+        if (!loader || rejected.contains(id)) continue;
 
-        // Check dependencies
-        QStringList unsatisfied = checkDependencies(loader->metadata());
-        if (!unsatisfied.isEmpty()) {
-            QString error = QString("Unsatisfied dependencies: %1").arg(unsatisfied.join(", "));
-            emit pluginError(id, error);
-            allLoaded = false;
+        if (deferred.contains(id)) {
+            qDebug() << "Deferring plugin until first use:" << id;
             continue;
         }
 
-        if (!loader->load()) {
+        bool loaded;
+        {
+            MPF_TRACE_SPAN("load", id);
+            loaded = loader->load();
+        }
+
+        if (!loaded) {
             emit pluginError(id, loader->errorString());
             allLoaded = false;
             continue;
@@ -109,69 +265,667 @@ bool PluginManager::loadAll()
     return allLoaded;
 }
 
-bool PluginManager::initializeAll()
+bool PluginManager::activate(const QString& id)
 {
-    QStringList order = computeLoadOrder();
-    
-    bool allInitialized = true;
-    for (const QString& id : order) {
-        PluginLoader* loader = m_pluginMap.value(id);
-        if (!loader || !loader->isLoaded()) continue;
-        if (loader->state() >= PluginLoader::State::Initialized) continue;
+    PluginLoader* target = m_pluginMap.value(id);
+    if (!target) {
+        qWarning() << "PluginManager: Cannot activate unknown plugin" << id;
+        return false;
+    }
+    if (isRunning(target)) {
+        return true;
+    }
 
-        IPlugin* plugin = loader->plugin();
-        if (!plugin) continue;
+    ensureOrder();
+    const QSet<QString> needed = requiredClosure({id});
 
-        if (!plugin->initialize(m_registry)) {
-            emit pluginError(id, "Initialization failed");
-            allInitialized = false;
-            continue;
+    MPF_TRACE_SPAN("activate", id);
+    QElapsedTimer timer;
+    timer.start();
+
+    // Dependencies first, in load order
+    for (const QString& pluginId : std::as_const(m_ordering.order)) {
+        if (needed.contains(pluginId) && !bringUp(pluginId)) {
+            qWarning() << "PluginManager: Activation of" << id << "failed at" << pluginId;
+            return false;
         }
+    }
 
+    // Initialized here means it waits for an asynchronously starting
+    // dependency and is started once that finishes
+    if (target->state() < PluginLoader::State::Initialized
+        || target->state() == PluginLoader::State::Error) {
+        return false;  // Excluded from the load order by a cycle
+    }
+
+    const qint64 elapsedMs = timer.elapsed();
+    qDebug() << "PluginManager: Activated" << id << "in" << elapsedMs << "ms";
+    emit pluginActivated(id, elapsedMs);
+    return true;
+}
+
+bool PluginManager::bringUp(const QString& id)
+{
+    PluginLoader* loader = m_pluginMap.value(id);
+    if (!loader || loader->state() == PluginLoader::State::Error) {
+        return false;
+    }
+
+    if (loader->state() == PluginLoader::State::Unloaded) {
+        QStringList unsatisfied = checkDependencies(loader->metadata());
+        if (!unsatisfied.isEmpty()) {
+            emit pluginError(id, QString("Unsatisfied dependencies: %1").arg(unsatisfied.join(", ")));
+            return false;
+        }
+        if (!loader->load()) {
+            emit pluginError(id, loader->errorString());
+            return false;
+        }
+        emit pluginLoaded(id);
+    }
+
+    if (loader->state() == PluginLoader::State::Loaded) {
+        qint64 elapsedNs = 0;
+        const bool initialized = runStep("initialize", id, loader,
+            [this](const QString&, PluginLoader* l) { return l->plugin()->initialize(m_registry); },
+            &elapsedNs);
+        loader->setInitializeDuration(elapsedNs);
+        if (!initialized) {
+            emit pluginError(id, "Initialization failed");
+            return false;
+        }
         loader->setState(PluginLoader::State::Initialized);
         emit pluginInitialized(id);
     }
 
-    return allInitialized;
+    if (loader->state() == PluginLoader::State::Initialized && !hasStartingDependency(loader)) {
+        qint64 elapsedNs = 0;
+        const bool started = runStep("start", id, loader,
+            [this](const QString& pluginId, PluginLoader* l) {
+                return l->metadata().asyncStart() ? beginAsyncStart(pluginId, l)
+                                                  : l->plugin()->start();
+            },
+            &elapsedNs);
+        if (!started) {
+            loader->setStartDuration(elapsedNs);
+            emit pluginError(id, "Start failed");
+            return false;
+        }
+        if (m_asyncStarts.contains(id)) {
+            loader->setState(PluginLoader::State::Starting);
+        } else if (loader->state() != PluginLoader::State::Started) {
+            loader->setStartDuration(elapsedNs);
+            loader->setState(PluginLoader::State::Started);
+            emit pluginStarted(id);
+        }
+    }
+
+    return true;
 }
 
-bool PluginManager::startAll()
+bool PluginManager::unload(const QString& id)
 {
-    QStringList order = computeLoadOrder();
-    
+    if (!m_pluginMap.contains(id)) {
+        qWarning() << "PluginManager: Cannot unload unknown plugin" << id;
+        return false;
+    }
+
+    QElapsedTimer timer;
+    timer.start();
+
+    const QStringList affected = dependentClosure(id);
+    tearDown(affected);
+
+    // Known but not loaded, like a deferred plugin: first use brings it back
+    announceDeferred(affected);
+
+    const qint64 elapsedMs = timer.elapsed();
+    qDebug() << "PluginManager: Unloaded" << affected << "in" << elapsedMs << "ms";
+    emit pluginSwapped(id, affected, elapsedMs);
+    return true;
+}
+
+bool PluginManager::reload(const QString& id)
+{
+    PluginLoader* old = m_pluginMap.value(id);
+    if (!old) {
+        qWarning() << "PluginManager: Cannot reload unknown plugin" << id;
+        return false;
+    }
+
+    // Fresh loader: the new build may declare different metadata. Static
+    // plugins can't change, so they just restart with a new instance. Read
+    // before tearing anything down, so a broken build leaves all running.
+    std::unique_ptr<PluginLoader> loader;
+    if (old->isStatic()) {
+        loader = std::make_unique<PluginLoader>(old->staticPlugin(), old->metadata(), this);
+    } else {
+        const QString path = old->path();
+        PluginMetadata metadata(rereadMetadata(path));
+        if (!metadata.isValid() || metadata.id() != id) {
+            emit pluginError(id, QString("Reload failed: %1 no longer provides plugin %2").arg(path, id));
+            return false;
+        }
+        loader = std::make_unique<PluginLoader>(path, metadata, this);
+    }
+
+    QElapsedTimer timer;
+    timer.start();
+
+    const QStringList affected = dependentClosure(id);
+    QStringList restart;
+    for (const QString& pluginId : affected) {
+        PluginLoader* dependent = m_pluginMap.value(pluginId);
+        if (dependent->isLoaded() || pluginId == id) {
+            restart.append(pluginId);
+        }
+    }
+
+    tearDown(affected);
+
+    m_pluginMap[id] = loader.get();
+    watchCrashes(loader.get());
+    for (auto& slot : m_loaders) {
+        if (slot.get() == old) {
+            slot = std::move(loader);
+            break;
+        }
+    }
+    invalidateOrder();
+    ensureOrder();
+
     bool allStarted = true;
-    for (const QString& id : order) {
+    QStringList idle;
+    for (const QString& pluginId : std::as_const(m_ordering.order)) {
+        if (!affected.contains(pluginId)) continue;
+        if (!restart.contains(pluginId)) {
+            idle.append(pluginId);
+        } else if (!bringUp(pluginId)) {
+            allStarted = false;
+        }
+    }
+    announceDeferred(idle);
+
+    const qint64 elapsedMs = timer.elapsed();
+    qDebug() << "PluginManager: Reloaded" << id << "with" << restart.size() - 1
+             << "dependent(s) in" << elapsedMs << "ms";
+    emit pluginSwapped(id, affected, elapsedMs);
+    return allStarted;
+}
+
+QStringList PluginManager::dependentClosure(const QString& id) const
+{
+    ensureOrder();
+
+    // Anything that names id as a dependency, optional or not, may hold
+    // pointers into it
+    QSet<QString> closure{id};
+    bool grown = true;
+    while (grown) {
+        grown = false;
+        for (auto it = m_pluginMap.constBegin(); it != m_pluginMap.constEnd(); ++it) {
+            if (closure.contains(it.key())) continue;
+            for (const QString& dependency : dependencyIds(it.value()->metadata(), true)) {
+                if (closure.contains(dependency)) {
+                    closure.insert(it.key());
+                    grown = true;
+                    break;
+                }
+            }
+        }
+    }
+
+    QStringList ordered;
+    for (const QString& pluginId : std::as_const(m_ordering.order)) {
+        if (closure.contains(pluginId)) {
+            ordered.append(pluginId);
+        }
+    }
+    return ordered;
+}
+
+void PluginManager::tearDown(const QStringList& ids)
+{
+    // Stop everything first, dependents before their dependencies
+    for (auto it = ids.crbegin(); it != ids.crend(); ++it) {
+        PluginLoader* loader = m_pluginMap.value(*it);
+        if (!loader || !isRunning(loader)) continue;
+        cancelAsyncStart(*it);
+
+        {
+            PluginContext::Scope scope(*it);
+            loader->plugin()->stop();
+        }
+        loader->setState(PluginLoader::State::Initialized);
+        emit pluginStopped(*it);
+    }
+
+    auto* registry = static_cast<ServiceRegistryImpl*>(m_registry);
+    auto* eventBus = registry->get<IEventBus>();
+    auto* menu = registry->get<IMenu>();
+    auto* navigation = dynamic_cast<NavigationService*>(registry->get<INavigation>());
+
+    // Then drop what each plugin left in host services, while its code is
+    // still mapped, and unload it
+    for (auto it = ids.crbegin(); it != ids.crend(); ++it) {
+        PluginLoader* loader = m_pluginMap.value(*it);
+        if (!loader || !loader->isLoaded()) continue;
+
+        if (eventBus) eventBus->unsubscribeAll(*it);
+        if (menu) menu->unregisterPlugin(*it);
+        if (navigation) navigation->unregisterPlugin(*it);
+        registry->removeServicesFrom(*it);
+
+        loader->unload();
+        emit pluginUnloaded(*it);
+    }
+}
+
+void PluginManager::watchCrashes(PluginLoader* loader)
+{
+    const QString id = loader->metadata().id();
+    connect(loader, &PluginLoader::crashed, this, [this, id](const QString& reason) {
+        // The loader is in Error now; drop what the plugin left behind,
+        // its RemoteServiceProxy entries included, so lookups fail fast
+        const bool wasStarting = m_asyncStarts.contains(id);
+        cancelAsyncStart(id);
+
+        auto* registry = static_cast<ServiceRegistryImpl*>(m_registry);
+        if (auto* eventBus = registry->get<IEventBus>()) eventBus->unsubscribeAll(id);
+        if (auto* menu = registry->get<IMenu>()) menu->unregisterPlugin(id);
+        if (auto* navigation = dynamic_cast<NavigationService*>(registry->get<INavigation>())) {
+            navigation->unregisterPlugin(id);
+        }
+        registry->removeServicesFrom(id);
+        emit pluginError(id, QString("Crashed: %1").arg(reason));
+
+        // Dependents held back for it now report the failed dependency
+        if (wasStarting && !m_inWaves) {
+            startWaitingDependents(id);
+        }
+    });
+}
+
+void PluginManager::announceDeferred(const QStringList& ids)
+{
+    auto* registry = static_cast<ServiceRegistryImpl*>(m_registry);
+    auto* navigation = dynamic_cast<NavigationService*>(registry->get<INavigation>());
+
+    for (const QString& id : ids) {
         PluginLoader* loader = m_pluginMap.value(id);
-        if (!loader || loader->state() != PluginLoader::State::Initialized) continue;
+        if (!loader || loader->isLoaded()) continue;
 
-        IPlugin* plugin = loader->plugin();
-        if (!plugin) continue;
+        const PluginMetadata& metadata = loader->metadata();
+        if (navigation) {
+            for (const QString& route : metadata.routes()) {
+                navigation->registerDeferredRoute(route, id);
+            }
+        }
+        for (const QString& service : metadata.provides()) {
+            registry->addDeferredProvider(service, id);
+        }
+    }
+}
 
-        if (!plugin->start()) {
-            emit pluginError(id, "Start failed");
-            allStarted = false;
-            continue;
+QStringList PluginManager::deferredPlugins() const
+{
+    QStringList startup;
+    for (auto it = m_pluginMap.constBegin(); it != m_pluginMap.constEnd(); ++it) {
+        if (it.value()->metadata().loadOnStartup()) {
+            startup.append(it.key());
+        }
+    }
+
+    // A deferred plugin required by a startup plugin has to load anyway
+    const QSet<QString> needed = requiredClosure(startup);
+
+    QStringList deferred;
+    for (auto it = m_pluginMap.constBegin(); it != m_pluginMap.constEnd(); ++it) {
+        if (!needed.contains(it.key())) {
+            deferred.append(it.key());
+        }
+    }
+    deferred.sort();
+    return deferred;
+}
+
+QSet<QString> PluginManager::requiredClosure(const QStringList& ids) const
+{
+    ensureOrder();
+
+    QSet<QString> closure;
+    QStringList pending = ids;
+
+    while (!pending.isEmpty()) {
+        const QString id = pending.takeLast();
+        PluginLoader* loader = m_pluginMap.value(id);
+        if (!loader || closure.contains(id)) continue;
+
+        closure.insert(id);
+        pending.append(dependencyIds(loader->metadata(), false));
+    }
+    return closure;
+}
+
+bool PluginManager::initializeAll()
+{
+    return runInWaves("initialize",
+        [](PluginLoader* loader) {
+            return loader->isLoaded() && loader->plugin()
+                && loader->state() < PluginLoader::State::Initialized;
+        },
+        [](PluginLoader* loader) { return loader->metadata().concurrentInit(); },
+        [this](const QString&, PluginLoader* loader) {
+            return loader->plugin()->initialize(m_registry);
+        },
+        [this](const QString& id, PluginLoader* loader, bool ok, qint64 elapsedNs) {
+            loader->setInitializeDuration(elapsedNs);
+            if (!ok) {
+                emit pluginError(id, "Initialization failed");
+                return;
+            }
+            loader->setState(PluginLoader::State::Initialized);
+            emit pluginInitialized(id);
+        });
+}
+
+bool PluginManager::startAll()
+{
+    return runInWaves("start",
+        [this](PluginLoader* loader) {
+            // Dependents of a plugin still in startAsync() wait for it
+            return loader->plugin() && loader->state() == PluginLoader::State::Initialized
+                && !hasStartingDependency(loader);
+        },
+        [](PluginLoader* loader) {
+            return loader->metadata().concurrentStart() && !loader->metadata().asyncStart();
+        },
+        [this](const QString& id, PluginLoader* loader) {
+            if (loader->metadata().asyncStart()) {
+                return beginAsyncStart(id, loader);
+            }
+            return loader->plugin()->start();
+        },
+        [this](const QString& id, PluginLoader* loader, bool ok, qint64 elapsedNs) {
+            if (!ok) {
+                loader->setStartDuration(elapsedNs);
+                emit pluginError(id, "Start failed");
+                return;
+            }
+            if (m_asyncStarts.contains(id)) {
+                loader->setState(PluginLoader::State::Starting);
+                return;
+            }
+            if (loader->state() == PluginLoader::State::Started) {
+                return;  // startAsync() completed while the wave was running
+            }
+            loader->setStartDuration(elapsedNs);
+            loader->setState(PluginLoader::State::Started);
+            emit pluginStarted(id);
+        });
+}
+
+void PluginManager::setBudgets(int initializeMs, int startMs)
+{
+    m_initializeBudgetMs = initializeMs;
+    m_startBudgetMs = startMs;
+}
+
+bool PluginManager::isRunning(PluginLoader* loader)
+{
+    return loader->state() == PluginLoader::State::Started
+        || loader->state() == PluginLoader::State::Starting;
+}
+
+void PluginManager::cancelAsyncStart(const QString& id)
+{
+    if (m_asyncStarts.remove(id)) {
+        m_watchdog->disarm(id, "startAsync");
+    }
+}
+
+bool PluginManager::hasStartingDependency(PluginLoader* loader) const
+{
+    // Also through a dependency that is itself held back
+    const QStringList dependencies = dependencyIds(loader->metadata(), true);
+    return std::any_of(dependencies.begin(), dependencies.end(), [this](const QString& id) {
+        if (m_asyncStarts.contains(id)) {
+            return true;
         }
+        PluginLoader* dependency = m_pluginMap.value(id);
+        return dependency && dependency->state() == PluginLoader::State::Initialized
+            && hasStartingDependency(dependency);
+    });
+}
 
+QString PluginManager::failedDependency(PluginLoader* loader, PluginLoader::State reached) const
+{
+    for (const QString& id : dependencyIds(loader->metadata(), false)) {
+        PluginLoader* dependency = m_pluginMap.value(id);
+        if (dependency && (dependency->state() < reached
+                           || dependency->state() == PluginLoader::State::Error)) {
+            return id;
+        }
+    }
+    return QString();
+}
+
+bool PluginManager::beginAsyncStart(const QString& id, PluginLoader* loader)
+{
+    QElapsedTimer timer;
+    timer.start();
+
+    QFuture<bool> future;
+    {
+        PluginContext::Scope scope(id);
+        future = loader->plugin()->startAsync();
+    }
+
+    // The default startAsync() finishes before returning; treat it like start()
+    if (future.isFinished()) {
+        try {
+            return future.resultCount() > 0 && future.result();
+        } catch (...) {
+            return false;
+        }
+    }
+
+    m_asyncStarts.insert(id, timer);
+    m_watchdog->arm(id, "startAsync", m_startBudgetMs);
+
+    // Continuations run on this thread; if the plugin is stopped or unloaded
+    // first, finishAsyncStart() ignores the stale result. A future canceled
+    // (e.g. its promise destroyed unfinished) counts as a failed start.
+    future.then(this, [this, id](bool ok) {
+        finishAsyncStart(id, ok);
+    }).onFailed(this, [this, id]() {
+        finishAsyncStart(id, false);
+    }).onCanceled(this, [this, id]() {
+        finishAsyncStart(id, false);
+    });
+    return true;
+}
+
+void PluginManager::finishAsyncStart(const QString& id, bool ok)
+{
+    auto it = m_asyncStarts.find(id);
+    if (it == m_asyncStarts.end()) {
+        return;
+    }
+    const qint64 elapsedNs = it->nsecsElapsed();
+    m_asyncStarts.erase(it);
+    m_watchdog->disarm(id, "startAsync");
+
+    PluginLoader* loader = m_pluginMap.value(id);
+    if (!loader || !loader->isLoaded()) {
+        return;
+    }
+
+    loader->setStartDuration(elapsedNs);
+    if (ok) {
         loader->setState(PluginLoader::State::Started);
+        qDebug() << "PluginManager:" << id << "started asynchronously in"
+                 << elapsedNs / 1000000 << "ms";
         emit pluginStarted(id);
+    } else {
+        loader->setState(PluginLoader::State::Initialized);
+        emit pluginError(id, "Asynchronous start failed");
     }
 
-    return allStarted;
+    // Within startAll() the remaining waves pick them up
+    if (!m_inWaves) {
+        startWaitingDependents(id);
+    }
+}
+
+void PluginManager::startWaitingDependents(const QString& id)
+{
+    ensureOrder();
+
+    // Plugins held back behind id, directly or through another held-back
+    // plugin; load order brings each one's dependencies up first
+    QSet<QString> chain{id};
+    for (const QString& pluginId : std::as_const(m_ordering.order)) {
+        PluginLoader* loader = m_pluginMap.value(pluginId);
+        if (!loader || loader->state() != PluginLoader::State::Initialized) continue;
+
+        const QStringList dependencies = dependencyIds(loader->metadata(), true);
+        if (std::none_of(dependencies.begin(), dependencies.end(),
+                         [&chain](const QString& dependency) { return chain.contains(dependency); })) {
+            continue;
+        }
+        chain.insert(pluginId);
+
+        if (hasStartingDependency(loader)) {
+            continue;  // Still waiting for another plugin
+        }
+        const QString failed = failedDependency(loader, PluginLoader::State::Started);
+        if (!failed.isEmpty()) {
+            emit pluginError(pluginId, QString("Skipped start: required plugin %1 failed").arg(failed));
+            continue;
+        }
+        bringUp(pluginId);
+    }
+}
+
+bool PluginManager::runStep(const char* phase, const QString& id, PluginLoader* loader,
+                            const WaveStep& step, qint64* elapsedNs)
+{
+    const int budgetMs = qstrcmp(phase, "initialize") == 0 ? m_initializeBudgetMs
+                                                           : m_startBudgetMs;
+    MPF_TRACE_SPAN(phase, id);
+    PluginContext::Scope scope(id);
+
+    m_watchdog->arm(id, QString::fromLatin1(phase), budgetMs);
+    const bool ok = step(id, loader);
+    *elapsedNs = m_watchdog->disarm(id, QString::fromLatin1(phase));
+    return ok;
+}
+
+bool PluginManager::runInWaves(const char* phase, const WavePredicate& eligible,
+                               const WavePredicate& concurrent, const WaveStep& step,
+                               const WaveResult& finished)
+{
+    ensureOrder();
+    const QList<QStringList> levels = m_ordering.levels;
+
+    // A plugin runs a phase only once its required dependencies have
+    // completed it; failures in one wave thereby skip their dependents,
+    // transitively, in the next ones
+    const PluginLoader::State reached = qstrcmp(phase, "initialize") == 0
+        ? PluginLoader::State::Initialized : PluginLoader::State::Started;
+
+    QThreadPool pool;
+    bool allSucceeded = true;
+    QScopedValueRollback<bool> inWaves(m_inWaves, true);
+
+    for (int wave = 0; wave < levels.size(); ++wave) {
+        QStringList ids;
+        QList<PluginLoader*> loaders;
+        for (const QString& id : levels.at(wave)) {
+            PluginLoader* loader = m_pluginMap.value(id);
+            if (!loader || !eligible(loader)) continue;
+
+            const QString failed = failedDependency(loader, reached);
+            if (!failed.isEmpty()) {
+                qWarning() << "PluginManager: Skipping" << phase << "of" << id
+                           << "- required plugin" << failed << "did not complete it";
+                emit pluginError(id, QString("Skipped %1: required plugin %2 failed")
+                                         .arg(QString::fromLatin1(phase), failed));
+                allSucceeded = false;
+                continue;
+            }
+            ids.append(id);
+            loaders.append(loader);
+        }
+        if (ids.isEmpty()) continue;
+
+        // A single concurrent plugin gains nothing from the pool
+        std::vector<char> offload(ids.size(), 0);
+        int offloaded = 0;
+        for (int i = 0; i < ids.size(); ++i) {
+            offload[i] = concurrent(loaders.at(i));
+            offloaded += offload[i];
+        }
+        if (offloaded < 2) {
+            std::fill(offload.begin(), offload.end(), 0);
+            offloaded = 0;
+        }
+
+        MPF_TRACE_SPAN(phase, "wave ", QString::number(wave));
+        QElapsedTimer timer;
+        timer.start();
+
+        // Each task writes only its own slots; they are read after waitForDone()
+        std::vector<char> results(ids.size(), 0);
+        std::vector<qint64> durations(ids.size(), 0);
+        for (int i = 0; i < ids.size(); ++i) {
+            if (!offload[i]) continue;
+            pool.start([this, &ids, &loaders, &results, &durations, &step, phase, i]() {
+                results[i] = runStep(phase, ids.at(i), loaders.at(i), step, &durations[i]);
+            });
+        }
+
+        // Plugins not marked concurrent stay on this (the GUI) thread,
+        // overlapping with the pool
+        for (int i = 0; i < ids.size(); ++i) {
+            if (offload[i]) continue;
+            results[i] = runStep(phase, ids.at(i), loaders.at(i), step, &durations[i]);
+        }
+
+        pool.waitForDone();
+        const qint64 elapsedMs = timer.elapsed();
+
+        // Report in level order, on this thread, independent of completion order
+        for (int i = 0; i < ids.size(); ++i) {
+            finished(ids.at(i), loaders.at(i), results[i], durations[i]);
+            allSucceeded = allSucceeded && results[i];
+        }
+
+        qDebug() << "PluginManager:" << phase << "wave" << wave << "-"
+                 << ids.size() << "plugin(s)," << offloaded << "concurrent,"
+                 << elapsedMs << "ms";
+        emit waveFinished(QString::fromLatin1(phase), wave, ids, elapsedMs);
+    }
+
+    return allSucceeded;
 }
 
 void PluginManager::stopAll()
 {
     // Stop in reverse order
-    QStringList order = computeLoadOrder();
+    ensureOrder();
+    QStringList order = m_ordering.order;
     std::reverse(order.begin(), order.end());
     
     for (const QString& id : order) {
         PluginLoader* loader = m_pluginMap.value(id);
-        if (!loader || loader->state() != PluginLoader::State::Started) continue;
+        if (!loader || !isRunning(loader)) continue;
+        cancelAsyncStart(id);
 
         IPlugin* plugin = loader->plugin();
         if (plugin) {
+            PluginContext::Scope scope(id);
             plugin->stop();
         }
 
@@ -183,7 +937,8 @@ void PluginManager::stopAll()
 void PluginManager::unloadAll()
 {
     // Unload in reverse order
-    QStringList order = computeLoadOrder();
+    ensureOrder();
+    QStringList order = m_ordering.order;
     std::reverse(order.begin(), order.end());
     
     for (const QString& id : order) {
@@ -196,6 +951,7 @@ void PluginManager::unloadAll()
 
     m_pluginMap.clear();
     m_loaders.clear();
+    invalidateOrder();
 }
 
 QList<PluginLoader*> PluginManager::plugins() const
@@ -235,8 +991,15 @@ QString PluginManager::entryQml(const QString& pluginId) const
     return QString();
 }
 
+bool PluginManager::hostProvides(const QString& serviceName) const
+{
+    auto* registry = dynamic_cast<ServiceRegistryImpl*>(m_registry);
+    return registry && registry->hasServiceNamed(serviceName);
+}
+
 QStringList PluginManager::checkDependencies(const PluginMetadata& metadata) const
 {
+    ensureOrder();
     QStringList unsatisfied;
     
     for (const PluginDependency& dep : metadata.requires()) {
@@ -250,9 +1013,9 @@ QStringList PluginManager::checkDependencies(const PluginMetadata& metadata) con
                 unsatisfied.append(QString("plugin:%1>=%2")
                     .arg(dep.id, dep.minVersion.toString()));
             }
-        } else {
-            // Service dependency - check at runtime
-            // We can't fully check this until initialization
+        } else if (serviceProvider(dep.id).isEmpty() && !hostProvides(dep.id)
+                   && !metadata.provides().contains(dep.id)) {
+            unsatisfied.append(QString("service:%1").arg(dep.id));
         }
     }
     
@@ -261,52 +1024,294 @@ QStringList PluginManager::checkDependencies(const PluginMetadata& metadata) con
 
 QStringList PluginManager::loadOrder() const
 {
-    return computeLoadOrder();
+    ensureOrder();
+    return m_ordering.order;
 }
 
-QStringList PluginManager::computeLoadOrder() const
+QStringList PluginManager::cyclicPlugins() const
 {
-    QStringList order;
-    QHash<QString, int> state; // 0=unvisited, 1=visiting, 2=visited
-    
-    for (auto it = m_pluginMap.begin(); it != m_pluginMap.end(); ++it) {
-        state[it.key()] = 0;
+    ensureOrder();
+    return m_ordering.cyclic + m_ordering.blocked;
+}
+
+QList<QStringList> PluginManager::dependencyCycles() const
+{
+    ensureOrder();
+    return m_ordering.cycles;
+}
+
+void PluginManager::invalidateOrder()
+{
+    m_ordering = Ordering();
+}
+
+void PluginManager::ensureOrder() const
+{
+    if (m_ordering.valid) {
+        return;
     }
-    
-    for (auto it = m_pluginMap.begin(); it != m_pluginMap.end(); ++it) {
-        if (!topologicalSort(it.key(), state, order)) {
-            qWarning() << "Circular dependency detected involving:" << it.key();
+
+    Ordering& ordering = m_ordering;
+    ordering = Ordering();
+    ordering.valid = true;
+    ordering.providers = buildProviderIndex();
+
+    // Edges run from a dependency (a required plugin, or the plugin
+    // providing a required service) to its dependents
+    QHash<QString, int> inDegree;
+    QHash<QString, QStringList> dependents;
+    inDegree.reserve(m_pluginMap.size());
+
+    for (auto it = m_pluginMap.constBegin(); it != m_pluginMap.constEnd(); ++it) {
+        inDegree.insert(it.key(), 0);
+    }
+    for (auto it = m_pluginMap.constBegin(); it != m_pluginMap.constEnd(); ++it) {
+        for (const QString& dependency : dependencyIds(it.value()->metadata(), true)) {
+            ++inDegree[it.key()];
+            dependents[dependency].append(it.key());
+        }
+    }
+
+    // Kahn's algorithm; among ready plugins the smallest (priority, id) goes first
+    using Key = std::pair<int, QString>;
+    std::priority_queue<Key, std::vector<Key>, std::greater<Key>> ready;
+    QHash<QString, int> level;
+
+    for (auto it = inDegree.constBegin(); it != inDegree.constEnd(); ++it) {
+        if (it.value() == 0) {
+            ready.emplace(m_pluginMap.value(it.key())->metadata().priority(), it.key());
+            level.insert(it.key(), 0);
+        }
+    }
+
+    while (!ready.empty()) {
+        const QString id = ready.top().second;
+        ready.pop();
+
+        const int idLevel = level.value(id);
+        if (ordering.levels.size() <= idLevel) {
+            ordering.levels.resize(idLevel + 1);
+        }
+        ordering.order.append(id);
+        ordering.levels[idLevel].append(id);  // Stays in (priority, id) order per level
+
+        for (const QString& dependent : dependents.value(id)) {
+            level[dependent] = std::max(level.value(dependent), idLevel + 1);
+            if (--inDegree[dependent] == 0) {
+                ready.emplace(m_pluginMap.value(dependent)->metadata().priority(), dependent);
+            }
+        }
+    }
+
+    if (ordering.order.size() < m_pluginMap.size()) {
+        // Whatever is left is on a cycle or depends on one. Cycles are the
+        // strongly connected components of more than one plugin (Tarjan);
+        // everything else left over is only blocked behind them.
+        QStringList remaining;
+        for (auto it = inDegree.constBegin(); it != inDegree.constEnd(); ++it) {
+            if (it.value() > 0) {
+                remaining.append(it.key());
+            }
+        }
+        remaining.sort();
+        const QSet<QString> left(remaining.begin(), remaining.end());
+
+        QHash<QString, int> index;
+        QHash<QString, int> lowLink;
+        QStringList stack;
+        QSet<QString> onStack;
+        QSet<QString> onCycle;
+
+        std::function<void(const QString&)> strongConnect = [&](const QString& id) {
+            index.insert(id, index.size());
+            lowLink.insert(id, index.value(id));
+            stack.append(id);
+            onStack.insert(id);
+
+            for (const QString& next : dependents.value(id)) {
+                if (!left.contains(next)) continue;
+                if (!index.contains(next)) {
+                    strongConnect(next);
+                    lowLink[id] = std::min(lowLink.value(id), lowLink.value(next));
+                } else if (onStack.contains(next)) {
+                    lowLink[id] = std::min(lowLink.value(id), index.value(next));
+                }
+            }
+
+            if (lowLink.value(id) == index.value(id)) {
+                QStringList component;
+                QString member;
+                do {
+                    member = stack.takeLast();
+                    onStack.remove(member);
+                    component.append(member);
+                } while (member != id);
+
+                if (component.size() > 1) {
+                    component.sort();
+                    ordering.cycles.append(component);
+                    onCycle.unite(QSet<QString>(component.begin(), component.end()));
+                }
+            }
+        };
+
+        for (const QString& id : std::as_const(remaining)) {
+            if (!index.contains(id)) {
+                strongConnect(id);
+            }
+        }
+
+        std::sort(ordering.cycles.begin(), ordering.cycles.end());
+        for (const QString& id : std::as_const(remaining)) {
+            (onCycle.contains(id) ? ordering.cyclic : ordering.blocked).append(id);
         }
     }
-    
-    return order;
 }
 
-bool PluginManager::topologicalSort(const QString& id, 
-                                     QHash<QString, int>& state, 
-                                     QStringList& order) const
+QHash<QString, QStringList> PluginManager::buildProviderIndex() const
 {
-    if (state.value(id) == 2) return true;  // Already visited
-    if (state.value(id) == 1) return false; // Circular dependency
-    
-    state[id] = 1; // Visiting
-    
-    PluginLoader* loader = m_pluginMap.value(id);
-    if (loader) {
-        for (const PluginDependency& dep : loader->metadata().requires()) {
-            if (dep.type == PluginDependency::Type::Plugin) {
-                if (m_pluginMap.contains(dep.id)) {
-                    if (!topologicalSort(dep.id, state, order)) {
-                        return false;
-                    }
-                }
+    // Preferred provider first: loaded at startup, then by priority and ID
+    auto preferred = [this](const QString& a, const QString& b) {
+        const PluginMetadata& ma = m_pluginMap.value(a)->metadata();
+        const PluginMetadata& mb = m_pluginMap.value(b)->metadata();
+        if (ma.loadOnStartup() != mb.loadOnStartup()) return ma.loadOnStartup();
+        if (ma.priority() != mb.priority()) return ma.priority() < mb.priority();
+        return a < b;
+    };
+
+    QHash<QString, QStringList> index;
+    for (auto it = m_pluginMap.constBegin(); it != m_pluginMap.constEnd(); ++it) {
+        for (const QString& service : it.value()->metadata().provides()) {
+            QStringList& providers = index[service];
+            if (!providers.contains(it.key())) {
+                providers.append(it.key());
             }
         }
     }
-    
-    state[id] = 2; // Visited
-    order.append(id);
-    return true;
+    for (QStringList& providers : index) {
+        std::sort(providers.begin(), providers.end(), preferred);
+    }
+    return index;
+}
+
+QString PluginManager::serviceProvider(const QString& serviceName) const
+{
+    ensureOrder();
+
+    // "requires" may name a service qualified or not ("mpf::IFoo" vs "IFoo")
+    auto it = m_ordering.providers.constFind(serviceName);
+    if (it == m_ordering.providers.constEnd()) {
+        it = m_ordering.providers.constFind(serviceName.section(QStringLiteral("::"), -1));
+    }
+    return it == m_ordering.providers.constEnd() ? QString() : it->value(0);
+}
+
+QStringList PluginManager::dependencyIds(const PluginMetadata& metadata, bool includeOptional) const
+{
+    QStringList ids;
+    for (const PluginDependency& dep : metadata.requires()) {
+        if (dep.optional && !includeOptional) continue;
+
+        QString id;
+        if (dep.type == PluginDependency::Type::Plugin) {
+            id = dep.id;
+        } else {
+            id = serviceProvider(dep.id);
+        }
+
+        if (!id.isEmpty() && id != metadata.id() && m_pluginMap.contains(id) && !ids.contains(id)) {
+            ids.append(id);
+        }
+    }
+    return ids;
+}
+
+QSet<QString> PluginManager::rejectUnresolvable(const QStringList& ids)
+{
+    ensureOrder();
+
+    QSet<QString> rejected;
+    for (const QString& id : std::as_const(m_ordering.order)) {
+        if (!ids.contains(id)) continue;
+        const PluginMetadata& metadata = m_pluginMap.value(id)->metadata();
+
+        QStringList unsatisfied = checkDependencies(metadata);
+        for (const QString& dependency : dependencyIds(metadata, false)) {
+            if (rejected.contains(dependency)) {
+                unsatisfied.append(QString("plugin:%1 (unavailable)").arg(dependency));
+            }
+        }
+
+        if (!unsatisfied.isEmpty()) {
+            rejected.insert(id);
+            emit pluginError(id, QString("Unsatisfied dependencies: %1").arg(unsatisfied.join(", ")));
+        }
+    }
+    return rejected;
+}
+
+void PluginManager::reportCycles()
+{
+    if (m_ordering.reported) {
+        return;
+    }
+    m_ordering.reported = true;
+
+    for (const QStringList& cycle : std::as_const(m_ordering.cycles)) {
+        qWarning() << "Circular dependency among plugins:" << cycle;
+        const QString members = cycle.join(", ");
+        for (const QString& id : cycle) {
+            emit pluginError(id, QString("Circular dependency: %1").arg(members));
+        }
+    }
+
+    for (const QString& id : std::as_const(m_ordering.blocked)) {
+        // Name only the cycles this plugin actually depends on
+        QSet<QString> upstream;
+        QStringList pending = dependencyIds(m_pluginMap.value(id)->metadata(), true);
+        while (!pending.isEmpty()) {
+            const QString dependency = pending.takeLast();
+            if (upstream.contains(dependency) || !m_pluginMap.contains(dependency)) continue;
+            upstream.insert(dependency);
+            pending.append(dependencyIds(m_pluginMap.value(dependency)->metadata(), true));
+        }
+
+        QStringList reached;
+        for (const QStringList& cycle : std::as_const(m_ordering.cycles)) {
+            if (upstream.contains(cycle.first())) {
+                reached.append(cycle.join(", "));
+            }
+        }
+        emit pluginError(id, QString("Depends on a plugin in a dependency cycle (%1)")
+                                 .arg(reached.join("; ")));
+    }
+}
+
+QString PluginManager::memoryReport()
+{
+    QString out;
+    QTextStream stream(&out);
+
+    if (!PluginMemory::isEnabled()) {
+        stream << "Heap accounting disabled (build with MPF_MEMORY_TRACKING)\n";
+    }
+
+    stream << "Memory (plugin: live KiB, peak KiB, KiB/s, QObjects):\n";
+    const PluginMemory::Usage host = PluginMemory::usage(0);
+    stream << "  host: " << host.liveBytes / 1024 << ", " << host.peakBytes / 1024 << ", -, -\n";
+
+    for (const auto& loader : m_loaders) {
+        if (!loader->isLoaded()) continue;
+
+        const PluginLoader::MemoryUsage usage = loader->sampleMemory();
+        stream << "  " << loader->metadata().id()
+               << ": " << usage.liveBytes / 1024
+               << ", " << usage.peakBytes / 1024
+               << ", " << QString::number(usage.allocationRate / 1024, 'f', 1)
+               << ", " << usage.objectCount
+               << "\n";
+    }
+    return out;
 }
 
 } // namespace mpf
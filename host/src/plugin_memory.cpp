@@ -0,0 +1,193 @@
+#include "plugin_memory.h"
+
+#include <QHash>
+#include <QMutex>
+#include <QStringList>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <new>
+
+namespace mpf {
+
+namespace {
+
+// Constant-initialized, so usable by operator new before any dynamic
+// initialization has run
+struct alignas(64) SlotCounters
+{
+    std::atomic<qint64> live{0};
+    std::atomic<qint64> peak{0};
+    std::atomic<quint64> allocated{0};
+    std::atomic<quint64> allocations{0};
+};
+
+SlotCounters s_counters[PluginMemory::MaxSlots];
+
+QMutex& slotMutex()
+{
+    static QMutex mutex;
+    return mutex;
+}
+
+// Index = slot; entry 0 is the host
+QStringList& slotNames()
+{
+    static QStringList names{QString()};
+    return names;
+}
+
+} // namespace
+
+thread_local int PluginMemory::s_slot = 0;
+
+int PluginMemory::slotFor(const QString& pluginId)
+{
+    if (pluginId.isEmpty() || pluginId == QLatin1String("host")) {
+        return 0;
+    }
+
+    QMutexLocker locker(&slotMutex());
+    QStringList& names = slotNames();
+    const int slot = int(names.indexOf(pluginId));
+    if (slot >= 0) {
+        return slot;
+    }
+    if (names.size() >= MaxSlots) {
+        return 0;
+    }
+    names.append(pluginId);
+    return int(names.size()) - 1;
+}
+
+QString PluginMemory::pluginId(int slot)
+{
+    QMutexLocker locker(&slotMutex());
+    return slotNames().value(slot);
+}
+
+PluginMemory::Usage PluginMemory::usage(int slot)
+{
+    Usage usage;
+    if (slot < 0 || slot >= MaxSlots) {
+        return usage;
+    }
+
+    const SlotCounters& counters = s_counters[slot];
+    usage.liveBytes = counters.live.load(std::memory_order_relaxed);
+    usage.peakBytes = counters.peak.load(std::memory_order_relaxed);
+    usage.allocatedBytes = counters.allocated.load(std::memory_order_relaxed);
+    usage.allocations = counters.allocations.load(std::memory_order_relaxed);
+    return usage;
+}
+
+PluginMemory::Scope::Scope(int slot)
+    : m_previous(s_slot)
+{
+    s_slot = slot;
+}
+
+PluginMemory::Scope::~Scope()
+{
+    s_slot = m_previous;
+}
+
+int PluginMemory::currentSlot()
+{
+    return s_slot;
+}
+
+void PluginMemory::recordAllocation(int slot, std::size_t size)
+{
+    SlotCounters& counters = s_counters[slot];
+    const qint64 live = counters.live.fetch_add(qint64(size), std::memory_order_relaxed) + qint64(size);
+    counters.allocated.fetch_add(size, std::memory_order_relaxed);
+    counters.allocations.fetch_add(1, std::memory_order_relaxed);
+
+    qint64 peak = counters.peak.load(std::memory_order_relaxed);
+    while (live > peak
+           && !counters.peak.compare_exchange_weak(peak, live, std::memory_order_relaxed)) {
+    }
+}
+
+void PluginMemory::recordFree(int slot, std::size_t size)
+{
+    s_counters[slot].live.fetch_sub(qint64(size), std::memory_order_relaxed);
+}
+
+} // namespace mpf
+
+#ifdef MPF_MEMORY_TRACKING
+
+// Global allocation hooks. Each block carries a header with its size and
+// owning slot; the header is padded to max_align_t so the payload keeps
+// the alignment malloc guarantees. Over-aligned new (std::align_val_t) is
+// left to the runtime and is not counted.
+namespace {
+
+struct BlockHeader
+{
+    std::size_t size;
+    std::uint32_t slot;
+};
+
+constexpr std::size_t HeaderSize = alignof(std::max_align_t);
+static_assert(sizeof(BlockHeader) <= HeaderSize, "header must fit in its padding");
+
+void* trackedAlloc(std::size_t size) noexcept
+{
+    void* raw = std::malloc(size + HeaderSize);
+    if (!raw) {
+        return nullptr;
+    }
+
+    const int slot = mpf::PluginMemory::currentSlot();
+    auto* header = static_cast<BlockHeader*>(raw);
+    header->size = size;
+    header->slot = std::uint32_t(slot);
+    mpf::PluginMemory::recordAllocation(slot, size);
+    return static_cast<char*>(raw) + HeaderSize;
+}
+
+void* trackedAllocOrThrow(std::size_t size)
+{
+    for (;;) {
+        if (void* p = trackedAlloc(size)) {
+            return p;
+        }
+        std::new_handler handler = std::get_new_handler();
+        if (!handler) {
+            throw std::bad_alloc();
+        }
+        handler();
+    }
+}
+
+void trackedFree(void* p) noexcept
+{
+    if (!p) {
+        return;
+    }
+
+    char* raw = static_cast<char*>(p) - HeaderSize;
+    const auto* header = reinterpret_cast<const BlockHeader*>(raw);
+    mpf::PluginMemory::recordFree(int(header->slot), header->size);
+    std::free(raw);
+}
+
+} // namespace
+
+void* operator new(std::size_t size) { return trackedAllocOrThrow(size); }
+void* operator new[](std::size_t size) { return trackedAllocOrThrow(size); }
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept { return trackedAlloc(size); }
+void* operator new[](std::size_t size, const std::nothrow_t&) noexcept { return trackedAlloc(size); }
+
+void operator delete(void* p) noexcept { trackedFree(p); }
+void operator delete[](void* p) noexcept { trackedFree(p); }
+void operator delete(void* p, std::size_t) noexcept { trackedFree(p); }
+void operator delete[](void* p, std::size_t) noexcept { trackedFree(p); }
+void operator delete(void* p, const std::nothrow_t&) noexcept { trackedFree(p); }
+void operator delete[](void* p, const std::nothrow_t&) noexcept { trackedFree(p); }
+
+#endif // MPF_MEMORY_TRACKING
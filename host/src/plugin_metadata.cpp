@@ -72,10 +72,19 @@ void PluginMetadata::parse(const QJsonObject& json)
     }
     
     m_entryQml = json.value("entryQml").toString();
+
+    QJsonArray routesArray = json.value("routes").toArray();
+    for (const auto& val : routesArray) {
+        m_routes.append(val.toString());
+    }
     
     // Loading hints
     m_priority = json.value("priority").toInt(0);
     m_loadOnStartup = json.value("loadOnStartup").toBool(true);
+    m_concurrentInit = json.value("concurrentInit").toBool(false);
+    m_concurrentStart = json.value("concurrentStart").toBool(false);
+    m_asyncStart = json.value("asyncStart").toBool(false);
+    m_outOfProcess = json.value("outOfProcess").toBool(false);
 }
 
 QStringList PluginMetadata::validate() const
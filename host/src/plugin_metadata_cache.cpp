@@ -0,0 +1,192 @@
+#include "plugin_metadata_cache.h"
+
+#include <QCborValue>
+#include <QCryptographicHash>
+#include <QDataStream>
+#include <QDateTime>
+#include <QDir>
+#include <QFile>
+#include <QSaveFile>
+#include <QDebug>
+
+namespace mpf {
+
+namespace {
+
+constexpr quint32 CacheMagic = 0x4d504643;  // "MPFC"
+constexpr quint32 CacheFormatVersion = 1;
+
+} // namespace
+
+PluginMetadataCache::PluginMetadataCache(const QString& filePath)
+    : m_filePath(filePath)
+{
+}
+
+PluginMetadataCache::~PluginMetadataCache() = default;
+
+bool PluginMetadataCache::load()
+{
+    QFile file(m_filePath);
+    if (!file.open(QIODevice::ReadOnly)) {
+        return false;
+    }
+
+    QDataStream in(&file);
+    in.setVersion(QDataStream::Qt_6_0);
+
+    quint32 magic = 0;
+    quint32 version = 0;
+    qint32 count = 0;
+    in >> magic >> version >> count;
+    if (magic != CacheMagic || version != CacheFormatVersion || count < 0) {
+        qDebug() << "PluginMetadataCache: Ignoring incompatible cache" << m_filePath;
+        return false;
+    }
+
+    QHash<QString, Entry> entries;
+    entries.reserve(count);
+    for (qint32 i = 0; i < count; ++i) {
+        QString path;
+        Entry entry;
+        QByteArray cbor;
+        in >> path >> entry.size >> entry.mtime >> entry.hash >> cbor;
+        entry.metadata = QCborValue::fromCbor(cbor).toMap().toJsonObject();
+        entries.insert(path, entry);
+    }
+
+    if (in.status() != QDataStream::Ok) {
+        qWarning() << "PluginMetadataCache: Corrupt cache" << m_filePath;
+        return false;
+    }
+
+    QMutexLocker locker(&m_mutex);
+    m_entries = std::move(entries);
+    m_dirty = false;
+    return true;
+}
+
+bool PluginMetadataCache::save()
+{
+    QMutexLocker locker(&m_mutex);
+    if (!m_dirty) {
+        return true;
+    }
+
+    // QSaveFile so an interrupted write never leaves a truncated cache
+    QSaveFile file(m_filePath);
+    if (!file.open(QIODevice::WriteOnly)) {
+        qWarning() << "PluginMetadataCache: Cannot write" << m_filePath;
+        return false;
+    }
+
+    QDataStream out(&file);
+    out.setVersion(QDataStream::Qt_6_0);
+    out << CacheMagic << CacheFormatVersion << qint32(m_entries.size());
+    for (auto it = m_entries.constBegin(); it != m_entries.constEnd(); ++it) {
+        out << it.key() << it->size << it->mtime << it->hash
+            << QCborValue::fromJsonValue(it->metadata).toCbor();
+    }
+
+    if (!file.commit()) {
+        qWarning() << "PluginMetadataCache: Cannot write" << m_filePath;
+        return false;
+    }
+
+    m_dirty = false;
+    return true;
+}
+
+void PluginMetadataCache::clear()
+{
+    QMutexLocker locker(&m_mutex);
+    m_entries.clear();
+    m_dirty = true;
+}
+
+bool PluginMetadataCache::lookup(const QFileInfo& info, QJsonObject* metadata)
+{
+    const QString path = info.absoluteFilePath();
+    const qint64 size = info.size();
+    const qint64 mtime = info.lastModified().toMSecsSinceEpoch();
+
+    QByteArray hash;
+    {
+        QMutexLocker locker(&m_mutex);
+        auto it = m_entries.constFind(path);
+        if (it == m_entries.constEnd() || it->size != size || it->mtime != mtime) {
+            m_misses.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+        if (!m_verifyHash) {
+            *metadata = it->metadata;
+            m_hits.fetch_add(1, std::memory_order_relaxed);
+            return true;
+        }
+        hash = it->hash;
+        *metadata = it->metadata;
+    }
+
+    // Hashing reads the file, so do it without holding the lock
+    if (hash.isEmpty() || hash != contentHash(path)) {
+        m_misses.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+
+    m_hits.fetch_add(1, std::memory_order_relaxed);
+    return true;
+}
+
+void PluginMetadataCache::insert(const QFileInfo& info, const QJsonObject& metadata)
+{
+    Entry entry;
+    entry.size = info.size();
+    entry.mtime = info.lastModified().toMSecsSinceEpoch();
+    entry.metadata = metadata;
+    if (m_verifyHash) {
+        entry.hash = contentHash(info.absoluteFilePath());
+    }
+
+    QMutexLocker locker(&m_mutex);
+    m_entries.insert(info.absoluteFilePath(), entry);
+    m_dirty = true;
+}
+
+void PluginMetadataCache::remove(const QString& path)
+{
+    QMutexLocker locker(&m_mutex);
+    if (m_entries.remove(path) > 0) {
+        m_dirty = true;
+    }
+}
+
+void PluginMetadataCache::prune(const QString& dirPath, const QStringList& livePaths)
+{
+    const QString prefix = QDir(dirPath).absolutePath() + QLatin1Char('/');
+
+    QMutexLocker locker(&m_mutex);
+    for (auto it = m_entries.begin(); it != m_entries.end();) {
+        const QString& path = it.key();
+        if (path.startsWith(prefix) && !path.mid(prefix.size()).contains(QLatin1Char('/'))
+                && !livePaths.contains(path)) {
+            it = m_entries.erase(it);
+            m_dirty = true;
+        } else {
+            ++it;
+        }
+    }
+}
+
+QByteArray PluginMetadataCache::contentHash(const QString& path)
+{
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly)) {
+        return {};
+    }
+
+    QCryptographicHash hash(QCryptographicHash::Sha1);
+    hash.addData(&file);
+    return hash.result();
+}
+
+} // namespace mpf
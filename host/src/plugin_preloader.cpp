@@ -0,0 +1,113 @@
+#include "plugin_preloader.h"
+#include "startup_tracer.h"
+
+#include <QDir>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QLibrary>
+#include <QDebug>
+#include <vector>
+
+#ifdef Q_OS_LINUX
+#include <fcntl.h>
+#endif
+
+namespace mpf {
+
+PluginPreloader::PluginPreloader(QObject* parent)
+    : QThread(parent)
+{
+    setObjectName("PluginPreloader");
+}
+
+PluginPreloader::~PluginPreloader()
+{
+    requestInterruption();
+    wait();
+}
+
+void PluginPreloader::addDirectory(const QString& path, const QString& prefix)
+{
+    const QFileInfoList entries = QDir(path).entryInfoList(QDir::Files, QDir::Name);
+
+    QMutexLocker locker(&m_mutex);
+    for (const QFileInfo& info : entries) {
+        if (!prefix.isEmpty() && !info.fileName().startsWith(prefix)) continue;
+        if (!QLibrary::isLibrary(info.fileName())) continue;
+
+        const QString filePath = info.canonicalFilePath();
+        if (!filePath.isEmpty() && !m_files.contains(filePath)) {
+            m_files.append(filePath);
+        }
+    }
+}
+
+QStringList PluginPreloader::files() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_files;
+}
+
+void PluginPreloader::report() const
+{
+    const int total = files().size();
+    const qint64 busyMs = busyNs() / 1000000;
+
+    qDebug() << "PluginPreloader:" << filesDone() << "of" << total << "libraries,"
+             << bytesDone() / 1024 << "KiB preloaded in" << busyMs << "ms"
+             << (isFinished() ? "" : "(still running)");
+
+    if (StartupTracer::isEnabled()) {
+        StartupTracer& tracer = StartupTracer::instance();
+        tracer.addInstant("preload", QString("preloaded %1/%2 before loadAll").arg(filesDone()).arg(total));
+        tracer.addCounter("preload busy ms", busyMs);
+        tracer.addCounter("preload KiB", bytesDone() / 1024);
+    }
+}
+
+void PluginPreloader::run()
+{
+    StartupTracer::instance().setThreadName(objectName());
+    const QStringList queued = files();
+
+    for (const QString& filePath : queued) {
+        if (isInterruptionRequested()) break;
+
+        MPF_TRACE_SPAN("preload", QFileInfo(filePath).fileName());
+        QElapsedTimer timer;
+        timer.start();
+
+        const qint64 bytes = preload(filePath);
+        if (bytes < 0) continue;
+
+        m_busyNs.fetch_add(timer.nsecsElapsed(), std::memory_order_relaxed);
+        m_bytesDone.fetch_add(bytes, std::memory_order_relaxed);
+        m_filesDone.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+qint64 PluginPreloader::preload(const QString& filePath)
+{
+    QFile file(filePath);
+    if (!file.open(QIODevice::ReadOnly | QIODevice::Unbuffered)) {
+        return -1;
+    }
+
+#ifdef Q_OS_LINUX
+    // Queue readahead of the whole file, not just the default window
+    posix_fadvise(file.handle(), 0, 0, POSIX_FADV_WILLNEED);
+#endif
+
+    // Reading through the file waits for it to be resident (and is the
+    // only way to prefetch where there is no advice API); the data is
+    // discarded, the page cache keeps it
+    std::vector<char> buffer(1 << 20);
+    qint64 total = 0;
+    qint64 n;
+    while ((n = file.read(buffer.data(), qint64(buffer.size()))) > 0) {
+        total += n;
+    }
+    return total;
+}
+
+} // namespace mpf
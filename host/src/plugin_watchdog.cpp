@@ -0,0 +1,105 @@
+#include "plugin_watchdog.h"
+#include <QDeadlineTimer>
+#include <QDebug>
+#include <algorithm>
+#include <limits>
+
+namespace mpf {
+
+PluginWatchdog::PluginWatchdog(QObject* parent)
+    : QThread(parent)
+{
+    m_clock.start();
+    setObjectName("PluginWatchdog");
+}
+
+PluginWatchdog::~PluginWatchdog()
+{
+    shutdown();
+}
+
+void PluginWatchdog::arm(const QString& pluginId, const QString& phase, int budgetMs)
+{
+    const qint64 now = m_clock.nsecsElapsed();
+    Watch watch{pluginId, phase, now,
+                budgetMs > 0 ? now + qint64(budgetMs) * 1000000 : -1, budgetMs};
+
+    QMutexLocker locker(&m_mutex);
+    m_watches.insert(pluginId + QLatin1Char('/') + phase, watch);
+    m_wake.wakeOne();
+}
+
+qint64 PluginWatchdog::disarm(const QString& pluginId, const QString& phase)
+{
+    const qint64 now = m_clock.nsecsElapsed();
+
+    QMutexLocker locker(&m_mutex);
+    auto it = m_watches.find(pluginId + QLatin1Char('/') + phase);
+    if (it == m_watches.end()) {
+        return -1;
+    }
+
+    const Watch watch = *it;
+    m_watches.erase(it);
+    locker.unlock();
+
+    const qint64 elapsed = now - watch.startNs;
+    if (watch.deadlineNs >= 0 && now > watch.deadlineNs) {
+        qWarning() << "PluginWatchdog:" << pluginId << phase << "took"
+                   << elapsed / 1000000 << "ms, budget" << watch.budgetMs << "ms";
+    }
+    return elapsed;
+}
+
+void PluginWatchdog::shutdown()
+{
+    {
+        QMutexLocker locker(&m_mutex);
+        m_stopping = true;
+        m_wake.wakeOne();
+    }
+    wait();
+}
+
+void PluginWatchdog::run()
+{
+    QMutexLocker locker(&m_mutex);
+
+    while (!m_stopping) {
+        const qint64 now = m_clock.nsecsElapsed();
+        qint64 next = std::numeric_limits<qint64>::max();
+        QList<Watch> expired;
+
+        for (Watch& watch : m_watches) {
+            if (watch.reported || watch.deadlineNs < 0) continue;
+
+            if (now >= watch.deadlineNs) {
+                watch.reported = true;
+                expired.append(watch);
+            } else {
+                next = std::min(next, watch.deadlineNs);
+            }
+        }
+
+        if (!expired.isEmpty()) {
+            // Report without the lock so receivers may arm()/disarm()
+            locker.unlock();
+            for (const Watch& watch : std::as_const(expired)) {
+                qWarning() << "PluginWatchdog:" << watch.pluginId << watch.phase
+                           << "still running after" << watch.budgetMs << "ms budget";
+                emit budgetExceeded(watch.pluginId, watch.phase, watch.budgetMs);
+            }
+            locker.relock();
+            continue;
+        }
+
+        if (next == std::numeric_limits<qint64>::max()) {
+            m_wake.wait(&m_mutex);
+        } else {
+            // Round up so we don't wake just before the deadline
+            m_wake.wait(&m_mutex, QDeadlineTimer((next - now) / 1000000 + 1));
+        }
+    }
+}
+
+} // namespace mpf
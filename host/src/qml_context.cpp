@@ -1,5 +1,6 @@
 #include "qml_context.h"
 #include "service_registry.h"
+#include "service_stats_model.h"
 #include <mpf/version.h>
 #include <mpf/interfaces/inavigation.h>
 #include <mpf/interfaces/isettings.h>
@@ -15,6 +16,7 @@ namespace mpf {
 QmlContext::QmlContext(ServiceRegistry* registry, QObject* parent)
     : QObject(parent)
     , m_registry(static_cast<ServiceRegistryImpl*>(registry))
+    , m_serviceStats(new ServiceStatsModel(&m_registry->stats(), this))
 {
 }
 
@@ -65,4 +67,9 @@ QObject* QmlContext::eventBus() const
     return m_registry->getObject<IEventBus>();
 }
 
+QObject* QmlContext::serviceStats() const
+{
+    return m_serviceStats;
+}
+
 } // namespace mpf
@@ -0,0 +1,444 @@
+#include "remote_plugin.h"
+#include "event_bus_service.h"
+#include "service_registry.h"
+
+#include <QCoreApplication>
+#include <QDir>
+#include <QJsonArray>
+#include <QLocalServer>
+#include <QLocalSocket>
+#include <QProcess>
+#include <QRandomGenerator>
+#include <QScopedValueRollback>
+#include <QThread>
+#include <QTimer>
+#include <QDebug>
+
+namespace mpf {
+
+namespace {
+
+constexpr int StopTimeoutMs = 2000;
+
+} // namespace
+
+RemotePlugin::RemotePlugin(const QString& libraryPath, const QJsonObject& metadata, QObject* parent)
+    : QObject(parent)
+    , m_libraryPath(libraryPath)
+    , m_metadata(metadata)
+    , m_pluginId(metadata.value("id").toString())
+{
+}
+
+RemotePlugin::~RemotePlugin()
+{
+    // Usually already asked to stop by stopAll(), together with the others
+    stop();
+    waitForExit();
+    failPending(QStringLiteral("plugin unloaded"));
+}
+
+QString RemotePlugin::hostExecutable()
+{
+    return QDir(QCoreApplication::applicationDirPath()).filePath(QStringLiteral("mpf-plugin-host"));
+}
+
+bool RemotePlugin::launch()
+{
+    // Relaunching after stop(): start over with a fresh server and process
+    waitForExit();
+    delete m_channel;
+    delete m_server;  // Owns m_socket
+    delete m_process;
+    m_channel = nullptr;
+    m_socket = nullptr;
+    m_stopping = false;
+
+    m_server = new QLocalServer(this);
+    m_server->setSocketOptions(QLocalServer::UserAccessOption);
+
+    const QString name = QString("mpf-%1-%2-%3")
+        .arg(m_pluginId)
+        .arg(QCoreApplication::applicationPid())
+        .arg(quintptr(this), 0, 16);
+    QLocalServer::removeServer(name);
+    if (!m_server->listen(name)) {
+        qWarning() << "RemotePlugin:" << m_pluginId << "cannot listen on" << name
+                   << ":" << m_server->errorString();
+        return false;
+    }
+    connect(m_server, &QLocalServer::newConnection, this, &RemotePlugin::onNewConnection);
+
+    quint64 token[2];
+    QRandomGenerator::system()->fillRange(token);
+    m_token = QString::fromLatin1(QByteArray(reinterpret_cast<const char*>(token), sizeof(token)).toHex());
+
+    m_process = new QProcess(this);
+    m_process->setProcessChannelMode(QProcess::ForwardedChannels);
+    connect(m_process, &QProcess::finished, this, &RemotePlugin::onProcessFinished);
+    connect(m_process, &QProcess::errorOccurred, this, [this](QProcess::ProcessError error) {
+        if (error == QProcess::FailedToStart) {
+            onProcessFinished();
+        }
+    });
+
+    m_process->start(hostExecutable(), {
+        QStringLiteral("--server"), m_server->fullServerName(),
+        QStringLiteral("--token"), m_token,
+        QStringLiteral("--plugin"), m_libraryPath
+    });
+    qDebug() << "RemotePlugin: Spawned" << hostExecutable() << "for" << m_pluginId;
+    return true;
+}
+
+bool RemotePlugin::initialize(ServiceRegistry* registry)
+{
+    // Only the host's registry is handed to plugins
+    m_registry = static_cast<ServiceRegistryImpl*>(registry);
+
+    // Registered up front so dependents can look them up in initialize();
+    // calls made before the child is up are queued behind Start
+    const QJsonArray provides = m_metadata.value("provides").toArray();
+    for (const auto& value : provides) {
+        const QString name = value.toString();
+        auto* proxy = new RemoteServiceProxy(name, this);
+        if (!m_registry->addNamedService(name, proxy, IRemoteService::apiVersion(), m_pluginId)) {
+            delete proxy;
+        }
+    }
+
+    m_eventBus = dynamic_cast<EventBusService*>(m_registry->get<IEventBus>());
+    return true;
+}
+
+bool RemotePlugin::start()
+{
+    // Not used by the host: outOfProcess implies asyncStart
+    startAsync();
+    return true;
+}
+
+QFuture<bool> RemotePlugin::startAsync()
+{
+    m_startPromise = std::make_shared<QPromise<bool>>();
+    m_startPromise->start();
+    QFuture<bool> future = m_startPromise->future();
+
+    // A child still exiting from stop() can't be started again
+    if ((!m_process || m_process->state() == QProcess::NotRunning || m_stopping) && !launch()) {
+        m_startPromise->addResult(false);
+        m_startPromise->finish();
+        m_startPromise.reset();
+        return future;
+    }
+
+    if (m_eventBus) {
+        connect(m_eventBus, &EventBusService::eventPublished, this, &RemotePlugin::onHostEvent,
+                Qt::UniqueConnection);
+    }
+
+    // The child runs initialize() and start() on this
+    IpcMessage message;
+    message.type = IpcMessage::Type::Start;
+    send(message);
+    return future;
+}
+
+void RemotePlugin::stop()
+{
+    if (!m_process || m_process->state() == QProcess::NotRunning || m_stopping) {
+        return;
+    }
+
+    m_stopping = true;
+    if (m_channel) {
+        IpcMessage message;
+        message.type = IpcMessage::Type::Stop;
+        m_channel->send(message);
+        m_channel->flush();
+
+        // Don't block the GUI thread on the child; onProcessFinished() cleans up
+        QTimer::singleShot(StopTimeoutMs, m_process, [process = m_process, id = m_pluginId]() {
+            if (process->state() != QProcess::NotRunning) {
+                qWarning() << "RemotePlugin:" << id << "did not exit, killing it";
+                process->kill();
+            }
+        });
+    } else {
+        // Never connected, so nothing was started in the child
+        m_process->kill();
+    }
+
+    if (m_eventBus) {
+        disconnect(m_eventBus, nullptr, this, nullptr);
+        m_eventBus->unsubscribeAll(m_pluginId);
+    }
+    m_subscriptions.clear();
+    failPending(QStringLiteral("plugin stopped"));
+}
+
+QFuture<QVariant> RemotePlugin::call(const QString& service, const QString& method,
+                                     const QVariantList& args, bool wantReply)
+{
+    auto promise = std::make_shared<QPromise<QVariant>>();
+    promise->start();
+    QFuture<QVariant> future = promise->future();
+
+    IpcMessage message;
+    message.type = IpcMessage::Type::Call;
+    message.name = service;
+    message.method = method;
+    message.args = args;
+
+    std::shared_ptr<QPromise<QVariant>> pending = wantReply ? promise : nullptr;
+    if (QThread::currentThread() == thread()) {
+        dispatchCall(std::move(message), pending);
+    } else {
+        QMetaObject::invokeMethod(this, [this, message, pending]() {
+            dispatchCall(message, pending);
+        }, Qt::QueuedConnection);
+    }
+    return future;
+}
+
+void RemotePlugin::dispatchCall(IpcMessage message, const std::shared_ptr<QPromise<QVariant>>& promise)
+{
+    if (!m_process || m_process->state() == QProcess::NotRunning) {
+        qWarning() << "RemotePlugin: Dropping call" << message.name << message.method
+                   << "- process of" << m_pluginId << "is not running";
+        return;  // promise goes out of scope: canceled
+    }
+
+    if (promise) {
+        message.id = m_nextCallId++;
+        m_pending.insert(message.id, promise);
+    }
+    send(message);
+}
+
+bool RemotePlugin::isConnected() const
+{
+    return m_channel && m_channel->isConnected();
+}
+
+void RemotePlugin::send(const IpcMessage& message)
+{
+    if (m_channel) {
+        m_channel->send(message);
+    } else {
+        m_backlog.append(message);
+    }
+}
+
+void RemotePlugin::waitForExit()
+{
+    if (!m_process || m_process->state() == QProcess::NotRunning) {
+        return;
+    }
+    if (!m_process->waitForFinished(StopTimeoutMs)) {
+        qWarning() << "RemotePlugin:" << m_pluginId << "did not exit, killing it";
+        m_process->kill();
+        m_process->waitForFinished(StopTimeoutMs);
+    }
+}
+
+void RemotePlugin::onNewConnection()
+{
+    while (QLocalSocket* socket = m_server->nextPendingConnection()) {
+        if (m_socket) {
+            delete socket;
+            continue;
+        }
+
+        // Untrusted until its Hello carries our token; owned by the socket
+        // so a rejected connection takes its channel with it
+        auto* channel = new IpcChannel(socket, socket);
+        connect(channel, &IpcChannel::messageReceived, this,
+                [this, socket, channel](const IpcMessage& message) {
+            onHandshake(socket, channel, message);
+        });
+        connect(socket, &QLocalSocket::disconnected, socket, &QObject::deleteLater);
+    }
+}
+
+void RemotePlugin::onHandshake(QLocalSocket* socket, IpcChannel* channel, const IpcMessage& message)
+{
+    disconnect(channel, &IpcChannel::messageReceived, this, nullptr);
+    if (m_socket || message.type != IpcMessage::Type::Hello
+        || message.args.value(0).toString() != m_token) {
+        qWarning() << "RemotePlugin: Rejecting a connection for" << m_pluginId
+                   << "that did not present the launch token";
+        socket->abort();
+        socket->deleteLater();
+        return;
+    }
+
+    // Only the child we spawned may connect; the socket now lives as long
+    // as the server (see launch())
+    disconnect(socket, &QLocalSocket::disconnected, socket, &QObject::deleteLater);
+    m_socket = socket;
+    m_channel = channel;
+    connect(m_channel, &IpcChannel::messageReceived, this, &RemotePlugin::onMessage);
+    m_server->close();
+
+    for (const IpcMessage& queued : std::as_const(m_backlog)) {
+        m_channel->send(queued);
+    }
+    m_backlog.clear();
+
+    onMessage(message);
+}
+
+void RemotePlugin::onMessage(const IpcMessage& message)
+{
+    switch (message.type) {
+    case IpcMessage::Type::Hello:
+        if (!message.ok) {
+            qWarning() << "RemotePlugin:" << m_pluginId << "failed to load:" << message.method;
+        }
+        break;
+
+    case IpcMessage::Type::Started: {
+        QStringList missing;
+        const QJsonArray provides = m_metadata.value("provides").toArray();
+        for (const auto& value : provides) {
+            if (!message.args.contains(value.toString())) {
+                missing.append(value.toString());
+            }
+        }
+        if (message.ok && !missing.isEmpty()) {
+            qWarning() << "RemotePlugin:" << m_pluginId << "did not register" << missing;
+        }
+        if (m_startPromise) {
+            m_startPromise->addResult(message.ok);
+            m_startPromise->finish();
+            m_startPromise.reset();
+        }
+        break;
+    }
+
+    case IpcMessage::Type::Reply: {
+        std::shared_ptr<QPromise<QVariant>> promise = m_pending.take(message.id);
+        if (!promise) break;
+        if (message.ok) {
+            promise->addResult(message.result);
+            promise->finish();
+        } else {
+            qWarning() << "RemotePlugin: Call to" << m_pluginId << "failed:" << message.method;
+        }
+        break;
+    }
+
+    case IpcMessage::Type::Event:
+        if (m_eventBus) {
+            // Deliver synchronously so onHostEvent() sees the guard
+            QScopedValueRollback<bool> guard(m_relaying, true);
+            m_eventBus->publishSync(message.name, message.args.value(0).toMap(),
+                                    message.args.value(1).toString());
+        }
+        break;
+
+    case IpcMessage::Type::Subscriptions: {
+        QStringList patterns;
+        for (const QVariant& pattern : message.args) {
+            patterns.append(pattern.toString());
+        }
+        setSubscriptions(patterns);
+        break;
+    }
+
+    default:
+        qWarning() << "RemotePlugin: Unexpected message" << int(message.type) << "from" << m_pluginId;
+        break;
+    }
+}
+
+void RemotePlugin::onHostEvent(const QString& topic, const QVariantMap& data, const QString& senderId)
+{
+    if (m_relaying || senderId == m_pluginId || !isConnected()) {
+        return;
+    }
+
+    for (const QString& pattern : std::as_const(m_subscriptions)) {
+        if (m_eventBus->matchesTopic(topic, pattern)) {
+            IpcMessage message;
+            message.type = IpcMessage::Type::Event;
+            message.name = topic;
+            message.args = {data, senderId};
+            m_channel->send(message);
+            return;
+        }
+    }
+}
+
+void RemotePlugin::setSubscriptions(const QStringList& patterns)
+{
+    m_subscriptions = patterns;
+    if (!m_eventBus) {
+        return;
+    }
+
+    // Mirror them on the host bus so subscriber counts include the child
+    m_eventBus->unsubscribeAll(m_pluginId);
+    for (const QString& pattern : patterns) {
+        m_eventBus->subscribe(pattern, m_pluginId);
+    }
+}
+
+void RemotePlugin::onProcessFinished()
+{
+    if (!m_stopping) {
+        const QString reason = m_process->error() == QProcess::FailedToStart
+            ? QString("cannot start %1: %2").arg(hostExecutable(), m_process->errorString())
+            : QString("process exited with code %1").arg(m_process->exitCode());
+        qWarning() << "RemotePlugin:" << m_pluginId << reason;
+        emit crashed(reason);
+    }
+
+    if (m_startPromise) {
+        m_startPromise->addResult(false);
+        m_startPromise->finish();
+        m_startPromise.reset();
+    }
+    failPending(QStringLiteral("process exited"));
+}
+
+void RemotePlugin::failPending(const QString& reason)
+{
+    if (!m_pending.isEmpty()) {
+        qWarning() << "RemotePlugin: Canceling" << m_pending.size() << "call(s) to"
+                   << m_pluginId << "-" << reason;
+    }
+    // Dropping the promises cancels their futures
+    m_pending.clear();
+    m_backlog.clear();
+}
+
+RemoteServiceProxy::RemoteServiceProxy(const QString& serviceName, RemotePlugin* owner)
+    : QObject(owner)
+    , m_serviceName(serviceName)
+    , m_owner(owner)
+{
+}
+
+QFuture<QVariant> RemoteServiceProxy::call(const QString& method, const QVariantList& args)
+{
+    if (!m_owner) {
+        return {};
+    }
+    return m_owner->call(m_serviceName, method, args);
+}
+
+void RemoteServiceProxy::post(const QString& method, const QVariantList& args)
+{
+    if (m_owner) {
+        m_owner->call(m_serviceName, method, args, false);
+    }
+}
+
+bool RemoteServiceProxy::isConnected() const
+{
+    return m_owner && m_owner->isConnected();
+}
+
+} // namespace mpf
@@ -0,0 +1,158 @@
+#include "service_call_batch.h"
+#include "service_stats.h"
+#include "plugin_context.h"
+#include "plugin_memory.h"
+#include <QElapsedTimer>
+#include <QMetaObject>
+#include <QDebug>
+
+namespace mpf {
+
+ServiceCallBatch::ServiceCallBatch(QObject* target)
+    : m_target(target)
+{
+}
+
+ServiceCallBatch::~ServiceCallBatch() = default;
+
+void ServiceCallBatch::enqueue(std::function<void()> call, quint64 coalesceKey)
+{
+    enqueue(0, std::move(call), coalesceKey);
+}
+
+void ServiceCallBatch::enqueue(quint64 scope, std::function<void()> call, quint64 coalesceKey)
+{
+    QMutexLocker locker(&m_mutex);
+
+    if (!m_target) {
+        // Service is gone; dropping the call cancels any attached promise
+        return;
+    }
+
+    const Key key(scope, coalesceKey);
+    if (coalesceKey != 0) {
+        auto it = m_keyIndex.constFind(key);
+        if (it != m_keyIndex.constEnd()) {
+            m_pending[*it].call = std::move(call);
+            m_coalesced.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+        m_keyIndex.insert(key, m_pending.size());
+    }
+
+    m_pending.push_back(PendingCall{std::move(call), key});
+
+    if (m_flushScheduled) {
+        return;
+    }
+    m_flushScheduled = true;
+
+    QObject* target = m_target.data();
+    locker.unlock();
+
+    // The lambda keeps the batch alive until the flush has run
+    QMetaObject::invokeMethod(target, [self = shared_from_this()]() {
+        self->flush();
+    }, Qt::QueuedConnection);
+}
+
+void ServiceCallBatch::detach()
+{
+    std::vector<PendingCall> dropped;
+
+    {
+        QMutexLocker locker(&m_mutex);
+        m_target.clear();
+        dropped.swap(m_pending);
+        m_keyIndex.clear();
+    }
+
+    if (!dropped.empty()) {
+        qDebug() << "ServiceCallBatch: Dropped" << dropped.size() << "pending call(s)";
+    }
+}
+
+void ServiceCallBatch::flush()
+{
+    std::vector<PendingCall> calls;
+
+    {
+        QMutexLocker locker(&m_mutex);
+        calls.swap(m_pending);
+        m_keyIndex.clear();
+        m_flushScheduled = false;
+    }
+
+    m_flushes.fetch_add(1, std::memory_order_relaxed);
+    m_calls.fetch_add(calls.size(), std::memory_order_relaxed);
+
+    for (PendingCall& pending : calls) {
+        pending.call();
+    }
+}
+
+namespace {
+
+std::atomic<quint64> nextChannelScope{1};
+
+} // namespace
+
+ServiceCallChannel::ServiceCallChannel(std::shared_ptr<ServiceCallBatch> batch,
+                                       const QString& interfaceName,
+                                       std::shared_ptr<ServiceStats> stats, int providerSlot)
+    : m_batch(std::move(batch))
+    , m_scope(nextChannelScope.fetch_add(1, std::memory_order_relaxed))
+    , m_interfaceName(interfaceName)
+    , m_consumer(PluginContext::current())
+    , m_stats(std::move(stats))
+    , m_providerSlot(providerSlot)
+{
+}
+
+const std::shared_ptr<ServiceStats::Counters>& ServiceCallChannel::counters()
+{
+    // Resolved once, so timed calls only touch atomics
+    std::call_once(m_countersOnce, [this]() {
+        m_counters = m_stats->counters(m_consumer, m_interfaceName);
+    });
+    return m_counters;
+}
+
+void ServiceCallChannel::enqueue(std::function<void()> call, quint64 coalesceKey)
+{
+    if (m_providerSlot != 0) {
+        call = [call = std::move(call), slot = m_providerSlot]() {
+            PluginMemory::Scope memory(slot);
+            call();
+        };
+    }
+
+    if (!m_stats->isEnabled()) {
+        m_batch->enqueue(m_scope, std::move(call), coalesceKey);
+        return;
+    }
+
+    m_batch->enqueue(m_scope, [call = std::move(call), stats = m_stats, usage = counters()]() {
+        QElapsedTimer timer;
+        timer.start();
+        call();
+        stats->recordCall(*usage, timer.nsecsElapsed());
+    }, coalesceKey);
+}
+
+void ServiceCallChannel::execute(const std::function<void()>& call)
+{
+    PluginMemory::Scope memory(m_providerSlot != 0 ? m_providerSlot : PluginMemory::currentSlot());
+
+    if (!m_stats->isEnabled()) {
+        call();
+        return;
+    }
+
+    QElapsedTimer timer;
+    timer.start();
+    call();
+    m_stats->recordCall(*counters(), timer.nsecsElapsed());
+}
+
+} // namespace mpf
@@ -1,20 +1,66 @@
 #include "service_registry.h"
+#include "service_call_batch.h"
+#include "plugin_memory.h"
+#include "startup_tracer.h"
+#include <QThread>
+#include <QTextStream>
 #include <QDebug>
+#include <algorithm>
+#include <cstdlib>
+#include <utility>
+
+#if defined(__GNUG__)
+#include <cxxabi.h>
+#endif
 
 namespace mpf {
 
+LazyServiceState::~LazyServiceState()
+{
+    if (owned) {
+        delete instance;
+    }
+}
+
 ServiceRegistryImpl::ServiceRegistryImpl(QObject* parent)
     : QObject(parent)
+    , m_stats(std::make_shared<ServiceStats>())
 {
+    // Direct connection: waiters resolve on the thread that added the service
+    connect(this, &ServiceRegistryImpl::serviceAdded,
+            this, &ServiceRegistryImpl::resolveWaiters, Qt::DirectConnection);
 }
 
 ServiceRegistryImpl::~ServiceRegistryImpl()
 {
-    QMutexLocker locker(&m_mutex);
-    m_services.clear();
+    QHash<QString, QList<ServiceWaiter>> waiters;
+    QHash<QObject*, std::shared_ptr<ServiceCallBatch>> callQueues;
+    QHash<QString, ServiceSlot> services;
+
+    {
+        QMutexLocker locker(&m_mutex);
+        callQueues.swap(m_callQueues);
+        services.swap(m_services);
+        waiters.swap(m_waiters);
+    }
+
+    // Dropping the entries also deletes registry-owned lazy instances, whose
+    // destructors may still use the registry, so only once it is unlocked
+    services.clear();
+
+    for (const auto& queue : std::as_const(callQueues)) {
+        queue->detach();
+    }
+
+    for (const QList<ServiceWaiter>& list : std::as_const(waiters)) {
+        for (const ServiceWaiter& waiter : list) {
+            waiter.promise->future().cancel();
+            waiter.promise->finish();
+        }
+    }
 }
 
-bool ServiceRegistryImpl::addService(const char* typeName, QObject* instance, 
+bool ServiceRegistryImpl::addService(const char* typeName, QObject* instance,
                                   int version, const QString& providerId)
 {
     if (!instance) {
@@ -22,113 +68,708 @@ bool ServiceRegistryImpl::addService(const char* typeName, QObject* instance,
         return false;
     }
 
-    QString name = QString::fromLatin1(typeName);
-    
-    QMutexLocker locker(&m_mutex);
-    
-    if (m_services.contains(name)) {
-        qWarning() << "ServiceRegistry: Service already registered:" << name;
+    ServiceEntry entry;
+    entry.interfaceName = QString::fromLatin1(typeName);
+    entry.version = version;
+    entry.instance = instance;
+    entry.providerId = providerId;
+
+    return insertEntry(std::move(entry), true);
+}
+
+bool ServiceRegistryImpl::addNamedService(const QString& name, QObject* instance,
+                                          int version, const QString& providerId)
+{
+    return addService(name.toLatin1().constData(), instance, version, providerId);
+}
+
+bool ServiceRegistryImpl::addServiceProvider(const char* typeName, QObject* instance, int rank,
+                                             int version, const QString& providerId)
+{
+    if (!instance) {
+        qWarning() << "ServiceRegistry: Cannot register null service for" << typeName;
         return false;
     }
 
     ServiceEntry entry;
-    entry.interfaceName = name;
+    entry.interfaceName = QString::fromLatin1(typeName);
     entry.version = version;
     entry.instance = instance;
     entry.providerId = providerId;
+    entry.rank = rank;
+
+    return insertEntry(std::move(entry), false);
+}
+
+bool ServiceRegistryImpl::addServiceFactory(const char* typeName, ServiceFactory factory,
+                                            int version, const QString& providerId)
+{
+    if (!factory) {
+        qWarning() << "ServiceRegistry: Cannot register null factory for" << typeName;
+        return false;
+    }
+
+    auto lazy = std::make_shared<LazyServiceState>();
+    lazy->create = std::move(factory);
+
+    ServiceEntry entry;
+    entry.interfaceName = QString::fromLatin1(typeName);
+    entry.version = version;
+    entry.instance = nullptr;
+    entry.providerId = providerId;
+    entry.lazy = std::move(lazy);
+
+    return insertEntry(std::move(entry), true);
+}
+
+bool ServiceRegistryImpl::insertEntry(ServiceEntry entry, bool exclusive)
+{
+    const QString name = entry.interfaceName;
+    const int version = entry.version;
+    const int rank = entry.rank;
+    const QString providerId = entry.providerId;
+    const bool deferred = entry.lazy != nullptr;
+
+    QMutexLocker locker(&m_mutex);
+
+    // A rejected registration must not leave an empty slot behind
+    auto it = m_services.find(name);
+    if (it != m_services.end()) {
+        if (exclusive && !it->providers.isEmpty()) {
+            qWarning() << "ServiceRegistry: Service already registered:" << name;
+            return false;
+        }
+
+        if (entry.instance) {
+            for (const ServiceEntry& existing : std::as_const(it->providers)) {
+                if (existing.instance == entry.instance) {
+                    qWarning() << "ServiceRegistry: Provider already registered for" << name;
+                    return false;
+                }
+            }
+        }
+    } else {
+        it = m_services.insert(name, ServiceSlot());
+    }
+
+    // Keep providers sorted by rank; equal ranks stay in registration order
+    ServiceSlot& slot = *it;
+    auto pos = std::upper_bound(slot.providers.begin(), slot.providers.end(), rank,
+        [](int r, const ServiceEntry& e) { return r > e.rank; });
+    slot.providers.insert(pos, std::move(entry));
 
-    m_services.insert(name, entry);
-    
     locker.unlock();
     emit serviceAdded(name);
-    
-    qDebug() << "ServiceRegistry: Registered" << name << "v" << version 
-             << "from" << providerId;
+
+    qDebug() << "ServiceRegistry: Registered" << name << "v" << version
+             << "from" << providerId << "rank" << rank << (deferred ? "(lazy)" : "");
     return true;
 }
 
 QObject* ServiceRegistryImpl::getService(const char* typeName, int minVersion)
 {
     QString name = QString::fromLatin1(typeName);
-    
+    m_stats->recordLookup(name);
+
+    QObject* instance = lookup(name, minVersion);
+    if (!instance && activateDeferred(name)) {
+        instance = lookup(name, minVersion);
+    }
+    return instance;
+}
+
+QObject* ServiceRegistryImpl::acquireService(const char* typeName, int minVersion)
+{
+    QString name = QString::fromLatin1(typeName);
+    m_stats->recordLookup(name);
+
+    QObject* instance = lookup(name, minVersion, true);
+    if (!instance && activateDeferred(name)) {
+        instance = lookup(name, minVersion, true);
+    }
+    return instance;
+}
+
+void ServiceRegistryImpl::releaseService(const char* typeName, QObject* instance, qint64 heldNs)
+{
+    QString name = QString::fromLatin1(typeName);
+    m_stats->recordCall(name, heldNs);
+
     QMutexLocker locker(&m_mutex);
-    
+
     auto it = m_services.find(name);
     if (it == m_services.end()) {
+        return;  // Provider was removed while leased
+    }
+
+    for (const ServiceEntry& entry : std::as_const(it->providers)) {
+        if (entry.instance == instance) {
+            entry.counters->outstanding.fetch_sub(1, std::memory_order_relaxed);
+            return;
+        }
+    }
+}
+
+std::shared_ptr<ServiceCallQueue> ServiceRegistryImpl::callQueue(const char* typeName,
+                                                                QObject* instance)
+{
+    if (!instance) {
+        return nullptr;
+    }
+
+    QMutexLocker locker(&m_mutex);
+
+    // One batch per instance, so calls through any of its interfaces share a flush
+    std::shared_ptr<ServiceCallBatch>& queue = m_callQueues[instance];
+    if (!queue) {
+        queue = std::make_shared<ServiceCallBatch>(instance);
+    }
+
+    int providerSlot = 0;
+    if (PluginMemory::isEnabled()) {
+        auto it = m_services.constFind(QString::fromLatin1(typeName));
+        if (it != m_services.constEnd()) {
+            for (const ServiceEntry& entry : it->providers) {
+                if (entry.instance == instance) {
+                    providerSlot = PluginMemory::slotFor(entry.providerId);
+                    break;
+                }
+            }
+        }
+    }
+    return std::make_shared<ServiceCallChannel>(queue, QString::fromLatin1(typeName), m_stats,
+                                                providerSlot);
+}
+
+void ServiceRegistryImpl::setServiceSelectionPolicy(const char* typeName, SelectionPolicy policy)
+{
+    QString name = QString::fromLatin1(typeName);
+
+    QMutexLocker locker(&m_mutex);
+    m_services[name].policy = policy;
+}
+
+ServiceEntry* ServiceRegistryImpl::select(ServiceSlot& slot, int minVersion)
+{
+    // Note: must be called with m_mutex held
+    QList<ServiceEntry*> eligible;
+    for (ServiceEntry& entry : slot.providers) {
+        if (minVersion <= 0 || entry.version >= minVersion) {
+            eligible.append(&entry);
+        }
+    }
+
+    if (eligible.isEmpty()) {
         return nullptr;
     }
 
-    if (minVersion > 0 && it->version < minVersion) {
-        qWarning() << "ServiceRegistry: Service" << name 
-                   << "version" << it->version 
-                   << "is below required" << minVersion;
+    switch (slot.policy) {
+    case SelectionPolicy::RoundRobin:
+        return eligible.at(static_cast<int>(slot.cursor++ % eligible.size()));
+    case SelectionPolicy::LeastOutstanding:
+        // min_element keeps the first minimum, i.e. the highest rank on ties
+        return *std::min_element(eligible.begin(), eligible.end(),
+            [](const ServiceEntry* a, const ServiceEntry* b) {
+                return a->counters->outstanding.load(std::memory_order_relaxed)
+                     < b->counters->outstanding.load(std::memory_order_relaxed);
+            });
+    case SelectionPolicy::Ranked:
+        break;
+    }
+    return eligible.first();
+}
+
+QObject* ServiceRegistryImpl::lookup(const QString& name, int minVersion, bool lease)
+{
+    std::shared_ptr<LazyServiceState> lazy;
+    std::shared_ptr<ServiceCounters> counters;
+
+    {
+        QMutexLocker locker(&m_mutex);
+
+        auto it = m_services.find(name);
+        if (it == m_services.end() || it->providers.isEmpty()) {
+            return nullptr;
+        }
+
+        ServiceEntry* entry = select(*it, minVersion);
+        if (!entry) {
+            qWarning() << "ServiceRegistry: Service" << name
+                       << "version" << maxVersion(*it)
+                       << "is below required" << minVersion;
+            return nullptr;
+        }
+
+        entry->counters->calls.fetch_add(1, std::memory_order_relaxed);
+        if (lease) {
+            entry->counters->outstanding.fetch_add(1, std::memory_order_relaxed);
+        }
+
+        if (entry->instance || !entry->lazy) {
+            return entry->instance;
+        }
+        lazy = entry->lazy;
+        counters = entry->counters;
+    }
+
+    QObject* instance = instantiate(name, lazy);
+    if (!instance && lease) {
+        counters->outstanding.fetch_sub(1, std::memory_order_relaxed);
+    }
+    return instance;
+}
+
+QObject* ServiceRegistryImpl::instantiate(const QString& name,
+                                          const std::shared_ptr<LazyServiceState>& lazy)
+{
+    // The factory runs outside m_mutex so it can resolve its own dependencies
+    // through the registry; call_once makes concurrent first requests wait.
+    std::call_once(lazy->once, [&]() {
+        MPF_TRACE_SPAN("service", "construct ", displayName(name));
+        QObject* obj = lazy->create();
+        if (!obj) {
+            qWarning() << "ServiceRegistry: Factory returned null for" << name;
+            return;
+        }
+
+        if (!obj->parent()) {
+            lazy->owned = true;
+            // Keep affinity independent of whichever thread asked first
+            if (obj->thread() != thread()) {
+                obj->moveToThread(thread());
+            }
+        }
+        lazy->instance = obj;
+        qDebug() << "ServiceRegistry: Constructed lazy service" << name;
+    });
+
+    if (!lazy->instance) {
         return nullptr;
     }
 
-    return it->instance;
+    QMutexLocker locker(&m_mutex);
+    auto it = m_services.find(name);
+    if (it != m_services.end()) {
+        for (ServiceEntry& entry : it->providers) {
+            if (entry.lazy == lazy) {
+                entry.instance = lazy->instance;
+                break;
+            }
+        }
+    }
+    return lazy->instance;
 }
 
 bool ServiceRegistryImpl::hasService(const char* typeName, int minVersion) const
 {
     QString name = QString::fromLatin1(typeName);
-    
+    m_stats->recordLookup(name);
+
     QMutexLocker locker(&m_mutex);
-    
+
     auto it = m_services.find(name);
-    if (it == m_services.end()) {
-        return false;
+    if (it == m_services.end() || it->providers.isEmpty()) {
+        // Version of a deferred service is unknown until its plugin loads
+        locker.unlock();
+        return !deferredProvider(name).isEmpty();
     }
 
-    if (minVersion > 0 && it->version < minVersion) {
+    if (minVersion > 0 && maxVersion(*it) < minVersion) {
         return false;
     }
 
     return true;
 }
 
+void ServiceRegistryImpl::addDeferredProvider(const QString& serviceName, const QString& providerId)
+{
+    QMutexLocker locker(&m_mutex);
+    m_deferred.insert(serviceName, providerId);
+    qDebug() << "ServiceRegistry: Deferred" << serviceName << "from" << providerId;
+}
+
+void ServiceRegistryImpl::removeDeferredProviders(const QString& providerId)
+{
+    QMutexLocker locker(&m_mutex);
+    m_deferred.removeIf([&providerId](const QHash<QString, QString>::iterator& it) {
+        return it.value() == providerId;
+    });
+}
+
+void ServiceRegistryImpl::setProviderActivator(ProviderActivator activator)
+{
+    QMutexLocker locker(&m_mutex);
+    m_activator = std::move(activator);
+}
+
+QString ServiceRegistryImpl::deferredProvider(const QString& name) const
+{
+    {
+        QMutexLocker locker(&m_mutex);
+        if (m_deferred.isEmpty()) {
+            return QString();
+        }
+    }
+
+    // "provides" lists plain names, registry keys are typeid names
+    const QString qualified = displayName(name);
+    const QString unqualified = qualified.section(QStringLiteral("::"), -1);
+
+    QMutexLocker locker(&m_mutex);
+    for (const QString& candidate : {name, qualified, unqualified}) {
+        auto it = m_deferred.constFind(candidate);
+        if (it != m_deferred.constEnd()) {
+            return it.value();
+        }
+    }
+    return QString();
+}
+
+bool ServiceRegistryImpl::activateDeferred(const QString& name)
+{
+    const QString providerId = deferredProvider(name);
+    if (providerId.isEmpty()) {
+        return false;
+    }
+
+    if (QThread::currentThread() != thread()) {
+        qWarning() << "ServiceRegistry: Deferred plugin" << providerId
+                   << "can only be activated from the main thread; requested"
+                   << displayName(name);
+        return false;
+    }
+
+    ProviderActivator activator;
+    {
+        QMutexLocker locker(&m_mutex);
+        activator = m_activator;
+    }
+    if (!activator) {
+        return false;
+    }
+
+    // Drop the plugin's stubs first so a failed or recursive activation
+    // is attempted only once
+    removeDeferredProviders(providerId);
+
+    qDebug() << "ServiceRegistry: Activating" << providerId << "for" << displayName(name);
+    return activator(providerId);
+}
+
+QFuture<QObject*> ServiceRegistryImpl::whenService(const char* typeName, int minVersion)
+{
+    QString name = QString::fromLatin1(typeName);
+
+    auto promise = std::make_shared<QPromise<QObject*>>();
+    QFuture<QObject*> future = promise->future();
+    promise->start();
+
+    {
+        QMutexLocker locker(&m_mutex);
+
+        auto it = m_services.find(name);
+        if (it == m_services.end() || it->providers.isEmpty()
+            || (minVersion > 0 && maxVersion(*it) < minVersion)) {
+            m_waiters[name].append(ServiceWaiter{minVersion, promise});
+            return future;
+        }
+    }
+
+    promise->addResult(lookup(name, minVersion));
+    promise->finish();
+    return future;
+}
+
+void ServiceRegistryImpl::resolveWaiters(const QString& interfaceName)
+{
+    QList<ServiceWaiter> ready;
+
+    {
+        QMutexLocker locker(&m_mutex);
+
+        auto waiters = m_waiters.find(interfaceName);
+        if (waiters == m_waiters.end()) {
+            return;
+        }
+
+        auto it = m_services.find(interfaceName);
+        if (it == m_services.end()) {
+            return;
+        }
+
+        const int version = maxVersion(*it);
+        for (auto w = waiters->begin(); w != waiters->end();) {
+            if (w->minVersion <= 0 || version >= w->minVersion) {
+                ready.append(*w);
+                w = waiters->erase(w);
+            } else {
+                ++w;
+            }
+        }
+
+        if (waiters->isEmpty()) {
+            m_waiters.erase(waiters);
+        }
+    }
+
+    // Resolving constructs lazy services; someone is waiting for them anyway
+    for (const ServiceWaiter& waiter : std::as_const(ready)) {
+        waiter.promise->addResult(lookup(interfaceName, waiter.minVersion));
+        waiter.promise->finish();
+    }
+
+    if (!ready.isEmpty()) {
+        qDebug() << "ServiceRegistry: Resolved" << ready.size() << "waiter(s) for" << interfaceName;
+    }
+}
+
+int ServiceRegistryImpl::maxVersion(const ServiceSlot& slot)
+{
+    int version = -1;
+    for (const ServiceEntry& entry : slot.providers) {
+        version = std::max(version, entry.version);
+    }
+    return version;
+}
+
 int ServiceRegistryImpl::serviceVersion(const char* typeName) const
 {
     QString name = QString::fromLatin1(typeName);
-    
+
     QMutexLocker locker(&m_mutex);
-    
+
     auto it = m_services.find(name);
-    if (it == m_services.end()) {
+    if (it == m_services.end() || it->providers.isEmpty()) {
         return -1;
     }
 
-    return it->version;
+    return it->providers.first().version;
 }
 
 void ServiceRegistryImpl::removeService(const char* typeName)
 {
     QString name = QString::fromLatin1(typeName);
-    
-    QMutexLocker locker(&m_mutex);
-    
-    if (m_services.remove(name) > 0) {
-        locker.unlock();
+
+    ServiceSlot removed;
+    QList<std::shared_ptr<ServiceCallBatch>> detached;
+
+    {
+        QMutexLocker locker(&m_mutex);
+
+        auto it = m_services.find(name);
+        if (it == m_services.end()) {
+            return;
+        }
+
+        for (const ServiceEntry& entry : std::as_const(it->providers)) {
+            if (auto queue = m_callQueues.take(entry.instance)) {
+                detached.append(queue);
+            }
+        }
+        removed = std::move(*it);
+        m_services.erase(it);
+    }
+
+    for (const auto& queue : std::as_const(detached)) {
+        queue->detach();
+    }
+
+    // Owned lazy instances are deleted here, outside the lock, so their
+    // destructors may use the registry
+    const bool hadProviders = !removed.providers.isEmpty();
+    removed.providers.clear();
+
+    if (hadProviders) {
         emit serviceRemoved(name);
         qDebug() << "ServiceRegistry: Removed" << name;
     }
 }
 
+int ServiceRegistryImpl::removeServicesFrom(const QString& providerId)
+{
+    QStringList emptied;
+    QList<std::shared_ptr<ServiceCallBatch>> detached;
+    QList<std::shared_ptr<LazyServiceState>> released;
+    int removed = 0;
+
+    {
+        QMutexLocker locker(&m_mutex);
+
+        for (auto it = m_services.begin(); it != m_services.end(); ++it) {
+            QList<ServiceEntry>& providers = it->providers;
+            const bool hadProviders = !providers.isEmpty();
+
+            for (auto entry = providers.begin(); entry != providers.end();) {
+                if (entry->providerId != providerId) {
+                    ++entry;
+                    continue;
+                }
+                if (auto queue = m_callQueues.take(entry->instance)) {
+                    detached.append(queue);
+                }
+                if (entry->lazy) {
+                    released.append(entry->lazy);
+                }
+                entry = providers.erase(entry);
+                ++removed;
+            }
+
+            if (hadProviders && providers.isEmpty()) {
+                emptied.append(it.key());
+            }
+        }
+    }
+
+    for (const auto& queue : std::as_const(detached)) {
+        queue->detach();
+    }
+
+    // Owned lazy instances are deleted here, outside the lock, while the
+    // plugin's code is still loaded
+    released.clear();
+
+    for (const QString& name : std::as_const(emptied)) {
+        emit serviceRemoved(name);
+    }
+
+    if (removed > 0) {
+        qDebug() << "ServiceRegistry: Removed" << removed << "provider(s) of" << providerId;
+    }
+    return removed;
+}
+
 QStringList ServiceRegistryImpl::registeredServices() const
 {
     QMutexLocker locker(&m_mutex);
-    return m_services.keys();
+
+    QStringList names;
+    for (auto it = m_services.constBegin(); it != m_services.constEnd(); ++it) {
+        if (!it->providers.isEmpty()) {
+            names.append(it.key());
+        }
+    }
+    return names;
 }
 
-const ServiceEntry* ServiceRegistryImpl::entry(const QString& interfaceName) const
+std::optional<ServiceEntry> ServiceRegistryImpl::entry(const QString& interfaceName) const
 {
     QMutexLocker locker(&m_mutex);
-    
-    auto it = m_services.find(interfaceName);
-    if (it == m_services.end()) {
-        return nullptr;
+
+    auto it = m_services.constFind(interfaceName);
+    if (it == m_services.constEnd() || it->providers.isEmpty()) {
+        return std::nullopt;
+    }
+
+    return it->providers.first();
+}
+
+QList<ServiceEntry> ServiceRegistryImpl::providers(const QString& interfaceName) const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_services.value(interfaceName).providers;
+}
+
+bool ServiceRegistryImpl::hasServiceNamed(const QString& name) const
+{
+    QMutexLocker locker(&m_mutex);
+    for (auto it = m_services.constBegin(); it != m_services.constEnd(); ++it) {
+        if (it->providers.isEmpty()) continue;
+
+        const QString qualified = displayName(it.key());
+        if (it.key() == name || qualified == name
+            || qualified.section(QStringLiteral("::"), -1) == name) {
+            return true;
+        }
+    }
+    return false;
+}
+
+QObject* ServiceRegistryImpl::serviceNamed(const QString& name)
+{
+    QString key;
+    {
+        QMutexLocker locker(&m_mutex);
+        for (auto it = m_services.constBegin(); it != m_services.constEnd() && key.isEmpty(); ++it) {
+            if (it->providers.isEmpty()) continue;
+
+            const QString qualified = displayName(it.key());
+            if (it.key() == name || qualified == name
+                || qualified.section(QStringLiteral("::"), -1) == name) {
+                key = it.key();
+            }
+        }
+    }
+    // Outside the lock: a lazy service is constructed here
+    return key.isEmpty() ? nullptr : lookup(key, 0);
+}
+
+QString ServiceRegistryImpl::registryStats() const
+{
+    QString out;
+    QTextStream stream(&out);
+
+    stream << "Services:\n";
+    {
+        QMutexLocker locker(&m_mutex);
+
+        QStringList names = m_services.keys();
+        names.sort();
+        for (const QString& name : std::as_const(names)) {
+            const ServiceSlot& slot = *m_services.constFind(name);
+            for (const ServiceEntry& entry : slot.providers) {
+                stream << "  " << displayName(name)
+                       << " v" << entry.version
+                       << " rank " << entry.rank
+                       << " from " << (entry.providerId.isEmpty() ? QStringLiteral("host") : entry.providerId)
+                       << (entry.instance ? "" : " (not constructed)")
+                       << " selected " << entry.counters->calls.load(std::memory_order_relaxed)
+                       << " outstanding " << entry.counters->outstanding.load(std::memory_order_relaxed)
+                       << "\n";
+            }
+        }
+    }
+
+    if (!m_stats->isEnabled()) {
+        stream << "Usage: collection disabled\n";
+        return out;
+    }
+
+    stream << "Usage (consumer -> interface: lookups, calls, total ms):\n";
+    const QList<ServiceStats::Row> rows = m_stats->snapshot();
+    for (const ServiceStats::Row& row : rows) {
+        stream << "  " << (row.consumer.isEmpty() ? QStringLiteral("host") : row.consumer)
+               << " -> " << displayName(row.interfaceName)
+               << ": " << row.lookups
+               << ", " << row.calls
+               << ", " << QString::number(row.totalNs / 1e6, 'f', 3)
+               << "\n";
+    }
+    return out;
+}
+
+QString ServiceRegistryImpl::displayName(const QString& interfaceName)
+{
+#if defined(__GNUG__)
+    int status = 0;
+    QByteArray mangled = interfaceName.toLatin1();
+    char* demangled = abi::__cxa_demangle(mangled.constData(), nullptr, nullptr, &status);
+    if (status == 0 && demangled) {
+        QString name = QString::fromLatin1(demangled);
+        std::free(demangled);
+        return name;
+    }
+    std::free(demangled);
+    return interfaceName;
+#else
+    // MSVC type names are already readable ("class mpf::INavigation")
+    QString name = interfaceName;
+    if (name.startsWith(QLatin1String("class "))) {
+        name.remove(0, 6);
+    } else if (name.startsWith(QLatin1String("struct "))) {
+        name.remove(0, 7);
     }
-    
-    return &it.value();
+    return name;
+#endif
 }
 
 } // namespace mpf
@@ -0,0 +1,116 @@
+#include "service_stats.h"
+#include "plugin_context.h"
+
+#include <algorithm>
+
+namespace mpf {
+
+namespace {
+
+std::atomic<quint64> nextStatsId{1};
+
+} // namespace
+
+ServiceStats::ServiceStats()
+    : m_id(nextStatsId.fetch_add(1, std::memory_order_relaxed))
+{
+}
+
+ServiceStats::~ServiceStats() = default;
+
+ServiceStats::Counters* ServiceStats::cachedCounters(const QString& interfaceName)
+{
+    // A thread usually records the same pair many times in a row; the
+    // cache spares it the shared lock. Holding the counters keeps them
+    // valid even if this ServiceStats is gone by the next lookup.
+    struct Cache
+    {
+        quint64 owner = 0;
+        QString consumer;
+        QString interfaceName;
+        std::shared_ptr<Counters> counters;
+    };
+    thread_local Cache cache;
+
+    const QString consumer = PluginContext::current();
+    if (cache.owner != m_id || cache.interfaceName != interfaceName || cache.consumer != consumer) {
+        cache.counters = counters(consumer, interfaceName);
+        cache.owner = m_id;
+        cache.consumer = consumer;
+        cache.interfaceName = interfaceName;
+    }
+    return cache.counters.get();
+}
+
+std::shared_ptr<ServiceStats::Counters> ServiceStats::counters(const QString& consumer,
+                                                               const QString& interfaceName)
+{
+    const Key key(consumer, interfaceName);
+
+    {
+        QReadLocker locker(&m_lock);
+        auto it = m_counters.constFind(key);
+        if (it != m_counters.constEnd()) {
+            return *it;
+        }
+    }
+
+    QWriteLocker locker(&m_lock);
+    std::shared_ptr<Counters>& counters = m_counters[key];
+    if (!counters) {
+        counters = std::make_shared<Counters>();
+        counters->consumer = consumer;
+        counters->interfaceName = interfaceName;
+    }
+    return counters;
+}
+
+int ServiceStats::shardIndex()
+{
+    static std::atomic<int> next{0};
+    thread_local const int index = next.fetch_add(1, std::memory_order_relaxed) % ShardCount;
+    return index;
+}
+
+QList<ServiceStats::Row> ServiceStats::snapshot() const
+{
+    QList<Row> rows;
+
+    {
+        QReadLocker locker(&m_lock);
+        rows.reserve(m_counters.size());
+        for (const auto& counters : m_counters) {
+            Row row;
+            row.consumer = counters->consumer;
+            row.interfaceName = counters->interfaceName;
+            for (const Shard& shard : counters->shards) {
+                row.lookups += shard.lookups.load(std::memory_order_relaxed);
+                row.calls += shard.calls.load(std::memory_order_relaxed);
+                row.totalNs += shard.totalNs.load(std::memory_order_relaxed);
+            }
+            rows.append(row);
+        }
+    }
+
+    std::sort(rows.begin(), rows.end(), [](const Row& a, const Row& b) {
+        if (a.consumer != b.consumer) {
+            return a.consumer < b.consumer;
+        }
+        return a.interfaceName < b.interfaceName;
+    });
+    return rows;
+}
+
+void ServiceStats::reset()
+{
+    QReadLocker locker(&m_lock);
+    for (const auto& counters : m_counters) {
+        for (Shard& shard : counters->shards) {
+            shard.lookups.store(0, std::memory_order_relaxed);
+            shard.calls.store(0, std::memory_order_relaxed);
+            shard.totalNs.store(0, std::memory_order_relaxed);
+        }
+    }
+}
+
+} // namespace mpf
@@ -0,0 +1,92 @@
+#include "service_stats_model.h"
+#include "service_registry.h"
+
+namespace mpf {
+
+ServiceStatsModel::ServiceStatsModel(ServiceStats* stats, QObject* parent)
+    : QAbstractListModel(parent)
+    , m_stats(stats)
+{
+    refresh();
+}
+
+ServiceStatsModel::~ServiceStatsModel() = default;
+
+int ServiceStatsModel::rowCount(const QModelIndex& parent) const
+{
+    if (parent.isValid()) return 0;
+    return m_rows.size();
+}
+
+QVariant ServiceStatsModel::data(const QModelIndex& index, int role) const
+{
+    if (!index.isValid() || index.row() >= m_rows.size()) {
+        return QVariant();
+    }
+
+    const ServiceStats::Row& row = m_rows.at(index.row());
+
+    switch (role) {
+    case Qt::DisplayRole:
+    case ConsumerRole:
+        return row.consumer.isEmpty() ? QStringLiteral("host") : row.consumer;
+    case InterfaceRole:
+        return ServiceRegistryImpl::displayName(row.interfaceName);
+    case LookupsRole:
+        return row.lookups;
+    case CallsRole:
+        return row.calls;
+    case TotalMsRole:
+        return row.totalNs / 1e6;
+    case AverageUsRole:
+        return row.calls ? row.totalNs / 1e3 / row.calls : 0.0;
+    default:
+        return QVariant();
+    }
+}
+
+QHash<int, QByteArray> ServiceStatsModel::roleNames() const
+{
+    return {
+        {ConsumerRole, "consumer"},
+        {InterfaceRole, "interfaceName"},
+        {LookupsRole, "lookups"},
+        {CallsRole, "calls"},
+        {TotalMsRole, "totalMs"},
+        {AverageUsRole, "averageUs"}
+    };
+}
+
+bool ServiceStatsModel::isEnabled() const
+{
+    return m_stats->isEnabled();
+}
+
+void ServiceStatsModel::setEnabled(bool enabled)
+{
+    if (m_stats->isEnabled() != enabled) {
+        m_stats->setEnabled(enabled);
+        emit enabledChanged();
+    }
+}
+
+void ServiceStatsModel::refresh()
+{
+    const int oldCount = m_rows.size();
+
+    beginResetModel();
+    m_rows = m_stats->snapshot();
+    endResetModel();
+
+    if (m_rows.size() != oldCount) {
+        emit countChanged();
+    }
+}
+
+void ServiceStatsModel::reset()
+{
+    m_stats->reset();
+    refresh();
+}
+
+} // namespace mpf
@@ -0,0 +1,138 @@
+#include "startup_tracer.h"
+
+#include <QFile>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QSaveFile>
+#include <QThread>
+#include <QDebug>
+
+namespace mpf {
+
+std::atomic<bool> StartupTracer::s_enabled{false};
+
+StartupTracer& StartupTracer::instance()
+{
+    static StartupTracer tracer;
+    return tracer;
+}
+
+void StartupTracer::start(const QString& outputPath)
+{
+    QMutexLocker locker(&m_mutex);
+    m_outputPath = outputPath;
+    m_events.clear();
+    m_events.reserve(1024);
+    m_threads.clear();
+    m_threadNames.clear();
+    m_clock.start();
+
+    m_threadNames.insert(threadIndex(), QStringLiteral("main"));
+    s_enabled.store(true, std::memory_order_relaxed);
+}
+
+int StartupTracer::threadIndex()
+{
+    const Qt::HANDLE handle = QThread::currentThreadId();
+    auto it = m_threads.constFind(handle);
+    if (it != m_threads.constEnd()) {
+        return *it;
+    }
+    const int index = m_threads.size() + 1;
+    m_threads.insert(handle, index);
+    return index;
+}
+
+void StartupTracer::addSpan(const char* category, const QString& name,
+                            qint64 startNs, qint64 durationNs)
+{
+    QMutexLocker locker(&m_mutex);
+    if (!isEnabled()) return;
+    m_events.push_back(Event{'X', category, name, startNs, durationNs, threadIndex()});
+}
+
+void StartupTracer::addInstant(const char* category, const QString& name)
+{
+    if (!isEnabled()) return;
+    const qint64 ts = now();
+
+    QMutexLocker locker(&m_mutex);
+    m_events.push_back(Event{'i', category, name, ts, 0, threadIndex()});
+}
+
+void StartupTracer::addCounter(const QString& name, qint64 value)
+{
+    if (!isEnabled()) return;
+    const qint64 ts = now();
+
+    QMutexLocker locker(&m_mutex);
+    m_events.push_back(Event{'C', "counter", name, ts, value, threadIndex()});
+}
+
+void StartupTracer::setThreadName(const QString& name)
+{
+    if (!isEnabled()) return;
+
+    QMutexLocker locker(&m_mutex);
+    m_threadNames.insert(threadIndex(), name);
+}
+
+bool StartupTracer::finish()
+{
+    QMutexLocker locker(&m_mutex);
+    if (!isEnabled()) {
+        return false;
+    }
+    s_enabled.store(false, std::memory_order_relaxed);
+
+    QJsonArray events;
+
+    for (auto it = m_threadNames.constBegin(); it != m_threadNames.constEnd(); ++it) {
+        events.append(QJsonObject{
+            {"ph", "M"}, {"name", "thread_name"}, {"pid", 1}, {"tid", it.key()},
+            {"args", QJsonObject{{"name", it.value()}}}
+        });
+    }
+
+    // Trace event timestamps are microseconds
+    for (const Event& event : m_events) {
+        QJsonObject json{
+            {"ph", QString(QChar::fromLatin1(event.phase))},
+            {"cat", QString::fromLatin1(event.category)},
+            {"name", event.name},
+            {"ts", event.start / 1000.0},
+            {"pid", 1},
+            {"tid", event.tid}
+        };
+        if (event.phase == 'X') {
+            json["dur"] = event.duration / 1000.0;
+        } else if (event.phase == 'i') {
+            json["s"] = "p";  // Process-wide marker
+        } else if (event.phase == 'C') {
+            json["args"] = QJsonObject{{"value", event.duration}};
+        }
+        events.append(json);
+    }
+
+    const qsizetype count = m_events.size();
+    m_events.clear();
+    m_events.shrink_to_fit();
+
+    QSaveFile file(m_outputPath);
+    if (!file.open(QIODevice::WriteOnly)) {
+        qWarning() << "StartupTracer: Cannot write" << m_outputPath;
+        return false;
+    }
+    QJsonObject root{{"traceEvents", events}, {"displayTimeUnit", "ms"}};
+    file.write(QJsonDocument(root).toJson(QJsonDocument::Compact));
+    if (!file.commit()) {
+        qWarning() << "StartupTracer: Cannot write" << m_outputPath;
+        return false;
+    }
+
+    qDebug() << "StartupTracer: Wrote" << count << "events to" << m_outputPath;
+    return true;
+}
+
+} // namespace mpf
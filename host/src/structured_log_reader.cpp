@@ -0,0 +1,147 @@
+#include "structured_log_reader.h"
+#include <mpf/structured_log.h>
+
+#include <QDateTime>
+#include <QFile>
+#include <cstring>
+
+namespace mpf {
+
+template<typename T>
+bool StructuredLogReader::read(T* value)
+{
+    if (m_data.size() - m_pos < qsizetype(sizeof(T))) {
+        m_pos = m_data.size();  // Truncated last record
+        return false;
+    }
+    std::memcpy(value, m_data.constData() + m_pos, sizeof(T));
+    m_pos += sizeof(T);
+    return true;
+}
+
+bool StructuredLogReader::open(const QString& path)
+{
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly)) {
+        return fail(QString("Cannot open %1: %2").arg(path, file.errorString()));
+    }
+    return setData(file.readAll());
+}
+
+bool StructuredLogReader::setData(const QByteArray& data)
+{
+    m_data = data;
+    m_pos = 0;
+    m_sites.clear();
+    m_error.clear();
+
+    if (m_data.size() < structured::HeaderSize
+        || std::memcmp(m_data.constData(), structured::Magic, sizeof(structured::Magic)) != 0) {
+        return fail(QStringLiteral("Not a structured log file"));
+    }
+    m_pos = sizeof(structured::Magic);
+
+    quint32 mark = 0;
+    read(&mark);
+    if (mark != structured::ByteOrderMark) {
+        return fail(QStringLiteral("Log was written on a machine with a different byte order"));
+    }
+    read(&m_base);
+    return true;
+}
+
+bool StructuredLogReader::readNext(Entry* entry)
+{
+    while (m_pos < m_data.size()) {
+        quint8 kind = 0;
+        read(&kind);
+
+        switch (kind) {
+        case structured::SiteRecord: {
+            quint16 id = 0;
+            quint8 level = 0;
+            quint8 argc = 0;
+            Site site;
+            QByteArray tag;
+            if (!read(&id) || !read(&level) || !readString16(&tag) || !readString16(&site.format)
+                || !read(&argc) || m_data.size() - m_pos < argc) {
+                return false;
+            }
+            site.level = ILogger::Level(qMin<int>(level, int(ILogger::Level::Error)));
+            site.tag = QString::fromUtf8(tag);
+            site.signature = m_data.mid(m_pos, argc);
+            m_pos += argc;
+            m_sites.insert(id, site);
+            break;
+        }
+
+        case structured::ClockRecord:
+            if (!read(&m_base)) {
+                return false;
+            }
+            break;
+
+        case structured::EntryRecord: {
+            quint16 id = 0;
+            quint32 delta = 0;
+            if (!read(&id) || !read(&delta)) {
+                return false;
+            }
+            const auto it = m_sites.constFind(id);
+            if (it == m_sites.constEnd()) {
+                return fail(QString("Entry for unknown site %1 at offset %2").arg(id).arg(m_pos));
+            }
+
+            qsizetype consumed = 0;
+            entry->message = structured::render(it->format.constData(), it->signature.constData(),
+                                                m_data.constData() + m_pos, m_data.size() - m_pos,
+                                                &consumed);
+            if (consumed < 0) {
+                m_pos = m_data.size();  // Truncated by a crash
+                return false;
+            }
+            m_pos += consumed;
+            entry->timestampMs = m_base + delta;
+            entry->level = it->level;
+            entry->tag = it->tag;
+            return true;
+        }
+
+        default:
+            return fail(QString("Unknown record kind %1 at offset %2").arg(kind).arg(m_pos - 1));
+        }
+    }
+    return false;
+}
+
+QString StructuredLogReader::formatEntry(const Entry& entry)
+{
+    static const char* const levels[] = {"TRACE", "DEBUG", "INFO ", "WARN ", "ERROR"};
+    return QString("[%1] [%2] [%3] %4")
+        .arg(QDateTime::fromMSecsSinceEpoch(entry.timestampMs).toString("yyyy-MM-dd hh:mm:ss.zzz"),
+             QLatin1String(levels[int(entry.level)]), entry.tag, entry.message);
+}
+
+bool StructuredLogReader::readString16(QByteArray* text)
+{
+    quint16 length = 0;
+    if (!read(&length)) {
+        return false;
+    }
+    if (m_data.size() - m_pos < length) {
+        m_pos = m_data.size();
+        return false;
+    }
+    *text = m_data.mid(m_pos, length);
+    m_pos += length;
+    return true;
+}
+
+bool StructuredLogReader::fail(const QString& error)
+{
+    m_error = error;
+    m_pos = m_data.size();
+    return false;
+}
+
+} // namespace mpf
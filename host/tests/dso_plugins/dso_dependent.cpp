@@ -0,0 +1,22 @@
+#include <mpf/interfaces/iplugin.h>
+
+#include <QObject>
+
+/**
+ * @brief Separate library depending on test.dso, so reloading test.dso
+ *        has a dependent to stop and restart
+ */
+class DsoDependentPlugin : public QObject, public mpf::IPlugin
+{
+    Q_OBJECT
+    Q_PLUGIN_METADATA(IID MPF_IPlugin_iid FILE "dso_dependent.json")
+    Q_INTERFACES(mpf::IPlugin)
+
+public:
+    bool initialize(mpf::ServiceRegistry*) override { return true; }
+    bool start() override { return true; }
+    void stop() override {}
+    QJsonObject metadata() const override { return {}; }
+};
+
+#include "dso_dependent.moc"
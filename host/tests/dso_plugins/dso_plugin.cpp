@@ -0,0 +1,45 @@
+#include <mpf/interfaces/iplugin.h>
+#include <mpf/logger.h>
+
+#include <QObject>
+
+namespace {
+
+int s_evaluated = 0;
+
+QString counted(const QString& message)
+{
+    ++s_evaluated;
+    return message;
+}
+
+} // namespace
+
+/**
+ * @brief Plugin built as its own library, so it gets its own copy of the
+ *        SDK's header-only statics; logs through them in start()
+ */
+class DsoPlugin : public QObject, public mpf::IPlugin
+{
+    Q_OBJECT
+    Q_PLUGIN_METADATA(IID MPF_IPlugin_iid FILE "dso_plugin.json")
+    Q_INTERFACES(mpf::IPlugin)
+
+public:
+    bool initialize(mpf::ServiceRegistry*) override { return true; }
+
+    bool start() override
+    {
+        MPF_LOG_TRACE("DsoPlugin", counted("trace from plugin"));
+        MPF_LOG_DEBUG("Quiet", counted("debug from plugin"));
+        // Read back by the test: messages built for the logger
+        setProperty("evaluated", s_evaluated);
+        return true;
+    }
+
+    void stop() override {}
+
+    QJsonObject metadata() const override { return {}; }
+};
+
+#include "dso_plugin.moc"
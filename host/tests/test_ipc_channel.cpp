@@ -0,0 +1,201 @@
+#include <QTest>
+#include <QCoreApplication>
+#include <QLocalServer>
+#include <QLocalSocket>
+#include <QSignalSpy>
+#include <memory>
+
+#include "ipc_channel.h"
+
+using namespace mpf;
+
+class CalcService : public QObject
+{
+    Q_OBJECT
+
+public:
+    Q_INVOKABLE int add(int a, int b) { return a + b; }
+    Q_INVOKABLE QVariant echo(const QVariant& value) { return value; }
+    Q_INVOKABLE void reset() { ++resets; }
+
+    int resets = 0;
+};
+
+/**
+ * @brief Connected host/child channel pair on one thread
+ */
+struct ChannelPair
+{
+    QLocalServer server;
+    QLocalSocket client;
+    QLocalSocket* serverSide = nullptr;
+    std::unique_ptr<IpcChannel> host;
+    std::unique_ptr<IpcChannel> child;
+
+    bool open()
+    {
+        const QString name = QString("mpf-test-ipc-%1").arg(QCoreApplication::applicationPid());
+        QLocalServer::removeServer(name);
+        if (!server.listen(name)) return false;
+
+        client.connectToServer(name);
+        if (!client.waitForConnected(1000) || !server.waitForNewConnection(1000)) return false;
+        serverSide = server.nextPendingConnection();
+
+        host = std::make_unique<IpcChannel>(serverSide);
+        child = std::make_unique<IpcChannel>(&client);
+        return true;
+    }
+};
+
+class TestIpcChannel : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void testInvokeConvertsArguments();
+    void testInvokeVariantAndVoid();
+    void testInvokeErrors();
+    void testMessageRoundTrip();
+    void testBurstIsOneFrame();
+    void benchmarkRoundTrip();
+    void benchmarkDirectInvoke();
+};
+
+void TestIpcChannel::testInvokeConvertsArguments()
+{
+    CalcService service;
+    QVariant result;
+    QString error;
+
+    // Strings and doubles converted to the declared int parameters
+    QVERIFY(IpcChannel::invoke(&service, "add", {QString("2"), 3.0}, &result, &error));
+    QCOMPARE(result.toInt(), 5);
+}
+
+void TestIpcChannel::testInvokeVariantAndVoid()
+{
+    CalcService service;
+    QVariant result;
+    QString error;
+
+    const QVariantMap map{{"id", 7}};
+    QVERIFY(IpcChannel::invoke(&service, "echo", {map}, &result, &error));
+    QCOMPARE(result.toMap(), map);
+
+    QVERIFY(IpcChannel::invoke(&service, "reset", {}, &result, &error));
+    QVERIFY(!result.isValid());
+    QCOMPARE(service.resets, 1);
+}
+
+void TestIpcChannel::testInvokeErrors()
+{
+    CalcService service;
+    QVariant result;
+    QString error;
+
+    QVERIFY(!IpcChannel::invoke(&service, "missing", {}, &result, &error));
+    QVERIFY(!error.isEmpty());
+
+    QVERIFY(!IpcChannel::invoke(&service, "add", {1}, &result, &error));
+    QVERIFY(!IpcChannel::invoke(&service, "add", {QVariantMap(), 1}, &result, &error));
+    QVERIFY(!IpcChannel::invoke(nullptr, "add", {1, 2}, &result, &error));
+}
+
+void TestIpcChannel::testMessageRoundTrip()
+{
+    ChannelPair pair;
+    QVERIFY(pair.open());
+    QSignalSpy received(pair.child.get(), &IpcChannel::messageReceived);
+
+    IpcMessage message;
+    message.type = IpcMessage::Type::Call;
+    message.id = 42;
+    message.name = "OrdersService";
+    message.method = "getOrder";
+    message.args = {QString("A-1"), QVariantMap{{"full", true}}};
+    pair.host->send(message);
+
+    QTRY_COMPARE(received.count(), 1);
+    const auto got = received.at(0).at(0).value<IpcMessage>();
+    QCOMPARE(got.type, IpcMessage::Type::Call);
+    QCOMPARE(got.id, quint64(42));
+    QCOMPARE(got.name, message.name);
+    QCOMPARE(got.method, message.method);
+    QCOMPARE(got.args, message.args);
+}
+
+void TestIpcChannel::testBurstIsOneFrame()
+{
+    ChannelPair pair;
+    QVERIFY(pair.open());
+
+    QList<quint64> ids;
+    connect(pair.child.get(), &IpcChannel::messageReceived, this,
+            [&ids](const IpcMessage& message) { ids.append(message.id); });
+
+    IpcMessage message;
+    message.type = IpcMessage::Type::Event;
+    for (quint64 i = 1; i <= 100; ++i) {
+        message.id = i;
+        pair.host->send(message);
+    }
+
+    QTRY_COMPARE(ids.size(), 100);
+    QCOMPARE(pair.host->framesSent(), quint64(1));
+    QCOMPARE(pair.host->messagesSent(), quint64(100));
+    for (int i = 0; i < ids.size(); ++i) {
+        QCOMPARE(ids.at(i), quint64(i + 1));
+    }
+}
+
+void TestIpcChannel::benchmarkRoundTrip()
+{
+    ChannelPair pair;
+    QVERIFY(pair.open());
+
+    // Child side: answer calls like mpf-plugin-host does
+    CalcService service;
+    connect(pair.child.get(), &IpcChannel::messageReceived, this,
+            [&pair, &service](const IpcMessage& call) {
+        IpcMessage reply;
+        reply.type = IpcMessage::Type::Reply;
+        reply.id = call.id;
+        reply.ok = IpcChannel::invoke(&service, call.method, call.args, &reply.result, &reply.method);
+        pair.child->send(reply);
+    });
+
+    quint64 replies = 0;
+    connect(pair.host.get(), &IpcChannel::messageReceived, this,
+            [&replies](const IpcMessage&) { ++replies; });
+
+    IpcMessage call;
+    call.type = IpcMessage::Type::Call;
+    call.method = "add";
+    call.args = {1, 2};
+
+    QBENCHMARK {
+        const quint64 expected = replies + 1;
+        call.id = expected;
+        pair.host->send(call);
+        while (replies < expected) {
+            QCoreApplication::processEvents(QEventLoop::WaitForMoreEvents);
+        }
+    }
+}
+
+void TestIpcChannel::benchmarkDirectInvoke()
+{
+    // Baseline for benchmarkRoundTrip: the dispatch alone, no IPC
+    CalcService service;
+    QVariant result;
+    QString error;
+
+    QBENCHMARK {
+        IpcChannel::invoke(&service, "add", {1, 2}, &result, &error);
+    }
+    QCOMPARE(result.toInt(), 3);
+}
+
+QTEST_MAIN(TestIpcChannel)
+#include "test_ipc_channel.moc"
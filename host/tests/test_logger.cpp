@@ -0,0 +1,726 @@
+#include <QTest>
+#include <QCoreApplication>
+#include <QDateTime>
+#include <QFile>
+#include <QFileInfo>
+#include <QMutex>
+#include <QRegularExpression>
+#include <QSemaphore>
+#include <QTemporaryDir>
+#include <QThread>
+
+#include "file_log_sink.h"
+#include "logger.h"
+#include <mpf/log_limit.h>
+#include <mpf/logger_access.h>
+#include "log_ring_buffer.h"
+
+using namespace mpf;
+
+class TestLogger : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void testRingBufferOrderAndCapacity();
+    void testSyncHandler();
+    void testAsyncKeepsOrder();
+    void testAsyncMultipleProducers();
+    void testDropPolicyCounts();
+    void testStopFlushes();
+    void testLogDuringStopIsNotLost();
+    void testFormatPlaceholders();
+    void testIsEnabled();
+    void testMacroSkipsDisabledMessage();
+    void testTagLevels();
+    void testTagLevelSpec();
+    void testMacroUsesTagLevel();
+    void testRateLimitedMacro();
+    void testSampledMacro();
+    void testLimitedMacroSkipsDisabledTag();
+    void testFileSinkAlongsideConsole();
+    void testFileSinkRotatesBySize();
+    void testFileSinkRotatesByTime();
+    void testFileSinkCompresses();
+    void benchmarkFormatReplace();
+    void benchmarkFormatCompiled();
+    void benchmarkFileSink();
+};
+
+namespace {
+
+QStringList s_output;
+bool s_captureOutput = false;
+
+void messageSink(QtMsgType, const QMessageLogContext&, const QString& message)
+{
+    if (s_captureOutput) {
+        s_output.append(message);
+    }
+}
+
+/**
+ * @brief Installs messageSink for the scope of a test
+ */
+struct OutputCapture
+{
+    explicit OutputCapture(bool keep)
+        : previous(qInstallMessageHandler(messageSink))
+    {
+        s_output.clear();
+        s_captureOutput = keep;
+    }
+    ~OutputCapture() { qInstallMessageHandler(previous); }
+
+    QtMessageHandler previous;
+};
+
+constexpr int MessagesPerIteration = 1000;
+
+QByteArray readFile(const QString& path)
+{
+    QFile file(path);
+    return file.open(QIODevice::ReadOnly) ? file.readAll() : QByteArray();
+}
+
+/**
+ * @brief Check that a gzip file holds exactly the expected data
+ *
+ * Rewraps its deflate data as the zlib stream qUncompress() expects; the
+ * Adler-32 that zlib verifies is taken from the expected data.
+ */
+bool gzipHolds(const QByteArray& gzip, const QByteArray& expected)
+{
+    if (gzip.size() < 18 || quint8(gzip[0]) != 0x1f || quint8(gzip[1]) != 0x8b) {
+        return false;
+    }
+
+    quint32 a = 1;
+    quint32 b = 0;
+    for (const char byte : expected) {
+        a = (a + quint8(byte)) % 65521;
+        b = (b + a) % 65521;
+    }
+
+    auto appendBigEndian = [](QByteArray& out, quint32 value) {
+        for (int shift = 24; shift >= 0; shift -= 8) {
+            out.append(char((value >> shift) & 0xFF));
+        }
+    };
+    QByteArray zlib;
+    appendBigEndian(zlib, quint32(expected.size()));
+    zlib.append("\x78\x9c", 2);
+    zlib.append(gzip.mid(10, gzip.size() - 18));
+    appendBigEndian(zlib, (b << 16) | a);
+    return qUncompress(zlib) == expected;
+}
+const QString BenchmarkFormat = "[%date% %time%] [%level%] [%tag%] %message%";
+
+} // namespace
+
+/**
+ * @brief Thread-safe collector installed as the logger handler
+ */
+struct Collector
+{
+    QMutex mutex;
+    QStringList messages;
+    QList<Qt::HANDLE> threads;
+
+    Logger::LogHandler handler()
+    {
+        return [this](ILogger::Level, const QString&, const QString& message) {
+            QMutexLocker locker(&mutex);
+            messages.append(message);
+            threads.append(QThread::currentThreadId());
+        };
+    }
+
+    int count()
+    {
+        QMutexLocker locker(&mutex);
+        return int(messages.size());
+    }
+};
+
+void TestLogger::testRingBufferOrderAndCapacity()
+{
+    LogRingBuffer<int> buffer(3);
+    QCOMPARE(buffer.capacity(), std::size_t(4));
+
+    for (int i = 0; i < 4; ++i) {
+        int value = i;
+        QVERIFY(buffer.tryPush(value));
+    }
+    int overflow = 99;
+    QVERIFY(!buffer.tryPush(overflow));
+    QCOMPARE(overflow, 99);
+
+    int value = -1;
+    for (int i = 0; i < 4; ++i) {
+        QVERIFY(buffer.tryPop(value));
+        QCOMPARE(value, i);
+    }
+    QVERIFY(!buffer.tryPop(value));
+}
+
+void TestLogger::testSyncHandler()
+{
+    Logger logger;
+    Collector collector;
+    logger.setHandler(collector.handler());
+
+    logger.info("test", "hello");
+    logger.debug("test", "world");
+
+    QCOMPARE(collector.messages, QStringList({"hello", "world"}));
+    QCOMPARE(collector.threads.first(), QThread::currentThreadId());
+}
+
+void TestLogger::testAsyncKeepsOrder()
+{
+    Logger logger;
+    Collector collector;
+    logger.setHandler(collector.handler());
+    logger.startAsync(64);
+    QVERIFY(logger.isAsync());
+
+    for (int i = 0; i < 1000; ++i) {
+        logger.info("test", QString::number(i));
+    }
+    logger.flush();
+
+    QCOMPARE(collector.count(), 1000);
+    for (int i = 0; i < 1000; ++i) {
+        QCOMPARE(collector.messages.at(i), QString::number(i));
+    }
+    QVERIFY(collector.threads.first() != QThread::currentThreadId());
+    QCOMPARE(logger.droppedCount(), quint64(0));
+}
+
+void TestLogger::testAsyncMultipleProducers()
+{
+    constexpr int Producers = 4;
+    constexpr int PerProducer = 2000;
+
+    Logger logger;
+    Collector collector;
+    logger.setHandler(collector.handler());
+    logger.startAsync(128, Logger::OverflowPolicy::Block);
+
+    QList<QThread*> threads;
+    for (int p = 0; p < Producers; ++p) {
+        threads.append(QThread::create([&logger, p]() {
+            for (int i = 0; i < PerProducer; ++i) {
+                logger.info("test", QString("%1:%2").arg(p).arg(i));
+            }
+        }));
+        threads.last()->start();
+    }
+    for (QThread* thread : threads) {
+        QVERIFY(thread->wait(10000));
+        delete thread;
+    }
+    logger.flush();
+
+    QCOMPARE(collector.count(), Producers * PerProducer);
+    QCOMPARE(logger.droppedCount(), quint64(0));
+
+    // Each producer's records come out in the order it logged them
+    QList<int> next(Producers, 0);
+    for (const QString& message : std::as_const(collector.messages)) {
+        const int p = message.section(':', 0, 0).toInt();
+        QCOMPARE(message.section(':', 1).toInt(), next[p]++);
+    }
+}
+
+void TestLogger::testDropPolicyCounts()
+{
+    Logger logger;
+    QSemaphore gate;
+    std::atomic<int> written{0};
+    logger.setHandler([&](ILogger::Level, const QString&, const QString&) {
+        gate.acquire();
+        written.fetch_add(1);
+    });
+    logger.startAsync(2, Logger::OverflowPolicy::Drop);
+
+    // The writer is stuck in the handler: at most 1 + capacity get through
+    for (int i = 0; i < 10; ++i) {
+        logger.warning("test", QString::number(i));
+    }
+    QVERIFY(logger.droppedCount() >= 7);
+
+    gate.release(10);
+    logger.stopAsync();
+    QCOMPARE(quint64(written.load()) + logger.droppedCount(), quint64(10));
+}
+
+void TestLogger::testStopFlushes()
+{
+    Collector collector;
+    {
+        Logger logger;
+        logger.setHandler(collector.handler());
+        logger.startAsync();
+        for (int i = 0; i < 500; ++i) {
+            logger.error("test", QString::number(i));
+        }
+        // Destructor stops the writer after draining
+    }
+    QCOMPARE(collector.count(), 500);
+}
+
+void TestLogger::testLogDuringStopIsNotLost()
+{
+    constexpr int Producers = 4;
+    constexpr int PerProducer = 2000;
+
+    Logger logger;
+    Collector collector;
+    logger.setHandler(collector.handler());
+    logger.startAsync(4, Logger::OverflowPolicy::Block);
+
+    // Producers keep blocking on a tiny buffer while the writer is stopped
+    // under them: each record is written by the writer or by its caller
+    std::atomic<int> started{0};
+    QList<QThread*> threads;
+    for (int p = 0; p < Producers; ++p) {
+        threads.append(QThread::create([&logger, &started, p]() {
+            started.fetch_add(1);
+            for (int i = 0; i < PerProducer; ++i) {
+                logger.info("test", QString("%1:%2").arg(p).arg(i));
+            }
+        }));
+        threads.last()->start();
+    }
+    while (started.load() < Producers) {
+        QThread::yieldCurrentThread();
+    }
+    logger.stopAsync();
+    QVERIFY(!logger.isAsync());
+
+    for (QThread* thread : threads) {
+        QVERIFY(thread->wait(10000));
+        delete thread;
+    }
+    QCOMPARE(collector.count(), Producers * PerProducer);
+    QCOMPARE(logger.droppedCount(), quint64(0));
+
+    // Restarting keeps the old writer around for callers that still hold it
+    logger.startAsync(4, Logger::OverflowPolicy::Block);
+    logger.info("test", "after restart");
+    logger.flush();
+    QCOMPARE(collector.count(), Producers * PerProducer + 1);
+}
+
+void TestLogger::testFormatPlaceholders()
+{
+    OutputCapture capture(true);
+    Logger logger;
+    logger.setFormat("<%level%|%tag%|%message%|%date% %time%> 100% %unknown%");
+
+    logger.warning("net", "timeout");
+
+    QCOMPARE(s_output.size(), 1);
+    static const QRegularExpression pattern(
+        R"(^<WARN \|net\|timeout\|\d{4}-\d{2}-\d{2} \d{2}:\d{2}:\d{2}\.\d{3}> 100% %unknown%$)");
+    QVERIFY2(pattern.match(s_output.first()).hasMatch(), qPrintable(s_output.first()));
+    QVERIFY(s_output.first().contains(QDate::currentDate().toString("yyyy-MM-dd")));
+}
+
+void TestLogger::testIsEnabled()
+{
+    Logger logger;
+    logger.setMinLevel(ILogger::Level::Warning);
+
+    QVERIFY(!logger.isEnabled(ILogger::Level::Info));
+    QVERIFY(logger.isEnabled(ILogger::Level::Warning));
+    QVERIFY(logger.isEnabled(ILogger::Level::Error));
+    QCOMPARE(logger.minLevel(), ILogger::Level::Warning);
+}
+
+void TestLogger::testMacroSkipsDisabledMessage()
+{
+    Logger logger;
+    Logger::setInstance(&logger);
+    Collector collector;
+    logger.setHandler(collector.handler());
+    logger.setMinLevel(ILogger::Level::Warning);
+
+    int evaluated = 0;
+    auto message = [&evaluated]() {
+        ++evaluated;
+        return QString("expensive");
+    };
+
+    MPF_LOG_DEBUG("test", message());
+    MPF_LOG_INFO("test", message());
+    QCOMPARE(evaluated, 0);
+
+    MPF_LOG_WARNING("test", message());
+    QCOMPARE(evaluated, 1);
+    QCOMPARE(collector.messages, QStringList({"expensive"}));
+
+    // Usable as a single statement in unbraced if/else
+    if (evaluated > 0)
+        MPF_LOG_ERROR("test", "then");
+    else
+        MPF_LOG_ERROR("test", "else");
+    QCOMPARE(collector.messages.last(), QString("then"));
+
+    Logger::setInstance(nullptr);
+}
+
+void TestLogger::testTagLevels()
+{
+    Logger logger;
+    Collector collector;
+    logger.setHandler(collector.handler());
+    logger.setMinLevel(ILogger::Level::Info);
+    logger.setTagLevel("noisy", ILogger::Level::Trace);
+    logger.setTagLevel("bus", ILogger::Level::Warning);
+
+    const int noisy = LogTags::id("noisy");
+    const int bus = LogTags::id("bus");
+    QCOMPARE(LogTags::id("noisy"), noisy);
+    QCOMPARE(LogTags::name(bus), QString("bus"));
+
+    // The tag-free check passes whatever some tag accepts
+    QVERIFY(logger.isEnabled(ILogger::Level::Trace));
+    QCOMPARE(logger.lowestLevel(), ILogger::Level::Trace);
+    QVERIFY(logger.isEnabled(ILogger::Level::Trace, noisy));
+    QVERIFY(!logger.isEnabled(ILogger::Level::Info, bus));
+    QVERIFY(logger.isEnabled(ILogger::Level::Info, LogTags::id("other")));
+    QVERIFY(!logger.isEnabled(ILogger::Level::Debug, LogTags::id("other")));
+    QVERIFY(!logger.isEnabled(ILogger::Level::Debug, -1));
+
+    // Direct calls are filtered the same way
+    logger.debug("noisy", "1");
+    logger.info("bus", "2");
+    logger.debug("other", "3");
+    logger.warning("bus", "4");
+    QCOMPARE(collector.messages, QStringList({"1", "4"}));
+
+    // Interning goes through the logger, and a tag ID handed to
+    // logTagged() decides the level without looking the tag up again
+    QCOMPARE(logger.tagId("bus"), bus);
+    logger.logTagged(ILogger::Level::Info, bus, "other", "5");
+    logger.logTagged(ILogger::Level::Debug, noisy, "other", "6");
+    QCOMPARE(collector.messages, QStringList({"1", "4", "6"}));
+
+    // Tags without their own level follow the global one
+    logger.setMinLevel(ILogger::Level::Debug);
+    QVERIFY(logger.isEnabled(ILogger::Level::Debug, LogTags::id("other")));
+    QVERIFY(!logger.isEnabled(ILogger::Level::Info, bus));
+
+    logger.clearTagLevel("noisy");
+    QVERIFY(!logger.isEnabled(ILogger::Level::Trace));
+    QVERIFY(!logger.isEnabled(ILogger::Level::Trace, noisy));
+}
+
+void TestLogger::testTagLevelSpec()
+{
+    Logger logger;
+    LoggerAccess::setInstance(&logger);
+
+    QVERIFY(logger.setTagLevels("OrdersPlugin=Trace, EventBus=warn; *=error"));
+    QCOMPARE(logger.minLevel(), ILogger::Level::Error);
+    QCOMPARE(logger.tagLevels().size(), 2);
+    QCOMPARE(logger.tagLevels().value("OrdersPlugin"), ILogger::Level::Trace);
+    QCOMPARE(logger.tagLevels().value("EventBus"), ILogger::Level::Warning);
+    QVERIFY(LoggerAccess::isEnabled(ILogger::Level::Trace));
+
+    // Rejected as a whole
+    QVERIFY(!logger.setTagLevels("OrdersPlugin=Debug, EventBus=loud"));
+    QVERIFY(!logger.setTagLevels("=Debug"));
+    QCOMPARE(logger.tagLevels().value("OrdersPlugin"), ILogger::Level::Trace);
+
+    QVERIFY(logger.setTagLevels(QString()));
+    QVERIFY(logger.tagLevels().isEmpty());
+    QVERIFY(!LoggerAccess::isEnabled(ILogger::Level::Warning));
+
+    LoggerAccess::setInstance(nullptr);
+}
+
+void TestLogger::testMacroUsesTagLevel()
+{
+    Logger logger;
+    Logger::setInstance(&logger);
+    Collector collector;
+    logger.setHandler(collector.handler());
+    logger.setMinLevel(ILogger::Level::Warning);
+    logger.setTagLevel("verbose", ILogger::Level::Trace);
+
+    int evaluated = 0;
+    auto message = [&evaluated](const char* text) {
+        ++evaluated;
+        return QString(text);
+    };
+
+    MPF_LOG_TRACE("verbose", message("traced"));
+    MPF_LOG_DEBUG("quiet", message("skipped"));
+    QCOMPARE(evaluated, 1);
+    QCOMPARE(collector.messages, QStringList({"traced"}));
+
+    // Changed at runtime: call sites keep their tag ID, not the level
+    logger.setTagLevel("verbose", ILogger::Level::Error);
+    for (int i = 0; i < 2; ++i) {
+        MPF_LOG_INFO("verbose", message("dropped"));
+    }
+    QCOMPARE(evaluated, 1);
+
+    Logger::setInstance(nullptr);
+}
+
+void TestLogger::testRateLimitedMacro()
+{
+    Logger logger;
+    Logger::setInstance(&logger);
+    Collector collector;
+    logger.setHandler(collector.handler());
+
+    int evaluated = 0;
+    auto message = [&evaluated](int i) {
+        ++evaluated;
+        return QString("poll %1").arg(i);
+    };
+    auto poll = [&message](int i) { MPF_LOG_WARNING_RATE("Http", 3, message(i)); };
+
+    for (int i = 0; i < 10; ++i) {
+        poll(i);
+    }
+    QCOMPARE(collector.messages, QStringList({"poll 0", "poll 1", "poll 2"}));
+    QCOMPARE(evaluated, 3);
+
+    // The first message of the next second reports what was dropped
+    QTest::qWait(1100);
+    poll(10);
+    QCOMPARE(collector.messages.mid(3),
+             QStringList({LogLimiter::summary(7), "poll 10"}));
+
+    Logger::setInstance(nullptr);
+}
+
+void TestLogger::testSampledMacro()
+{
+    Logger logger;
+    Logger::setInstance(&logger);
+    Collector collector;
+    logger.setHandler(collector.handler());
+
+    for (int i = 0; i < 9; ++i) {
+        MPF_LOG_INFO_SAMPLED("Orders", 4, QString("tick %1").arg(i));
+    }
+
+    // At most one summary per SummaryIntervalMs
+    QCOMPARE(collector.messages,
+             QStringList({"tick 0", LogLimiter::summary(3), "tick 4", "tick 8"}));
+
+    Logger::setInstance(nullptr);
+}
+
+void TestLogger::testLimitedMacroSkipsDisabledTag()
+{
+    Logger logger;
+    Logger::setInstance(&logger);
+    LoggerAccess::setInstance(&logger);
+    Collector collector;
+    logger.setHandler(collector.handler());
+
+    // Another tag at Trace lets the tag-free check pass for Debug
+    logger.setMinLevel(ILogger::Level::Info);
+    logger.setTagLevel("Noisy", ILogger::Level::Trace);
+
+    int built = 0;
+    auto tick = [&built](int i) {
+        MPF_LOG_DEBUG_SAMPLED("Orders", 4, (++built, QString("tick %1").arg(i)));
+    };
+    for (int i = 0; i < 9; ++i) {
+        tick(i);
+    }
+    QCOMPARE(built, 0);
+    QVERIFY(collector.messages.isEmpty());
+
+    // The disabled calls were not counted, nor reported as suppressed
+    logger.setTagLevel("Orders", ILogger::Level::Debug);
+    for (int i = 0; i < 5; ++i) {
+        tick(i);
+    }
+    QCOMPARE(collector.messages,
+             QStringList({"tick 0", LogLimiter::summary(3), "tick 4"}));
+
+    LoggerAccess::setInstance(nullptr);
+    Logger::setInstance(nullptr);
+}
+
+void TestLogger::testFileSinkAlongsideConsole()
+{
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    FileLogSink::Options options;
+    options.filePath = dir.filePath("logs/host.log");
+
+    auto sink = std::make_unique<FileLogSink>(options);
+    QVERIFY(sink->open());
+
+    OutputCapture capture(true);
+    Logger logger;
+    logger.setFileSink(std::move(sink));
+    logger.info("net", "connected");
+    logger.error("net", "lost");
+    logger.flush();
+
+    QCOMPARE(s_output, QStringList({"[INFO ] [net] connected", "[ERROR] [net] lost"}));
+    QCOMPARE(readFile(options.filePath), QByteArray("[INFO ] [net] connected\n[ERROR] [net] lost\n"));
+
+    // File only
+    logger.setConsoleOutput(false);
+    logger.info("net", "quiet");
+    logger.flush();
+    QCOMPARE(s_output.size(), 2);
+    QVERIFY(readFile(options.filePath).endsWith("[INFO ] [net] quiet\n"));
+}
+
+void TestLogger::testFileSinkRotatesBySize()
+{
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    FileLogSink::Options options;
+    options.filePath = dir.filePath("host.log");
+    options.maxFileSize = 100;
+    options.maxFiles = 3;
+
+    FileLogSink sink(options);
+    QVERIFY(sink.open());
+    const QString line(39, 'x');  // 40 bytes with the newline: two per file
+    for (int i = 0; i < 10; ++i) {
+        sink.write(line);
+        sink.flush();
+    }
+
+    QCOMPARE(readFile(options.filePath).size(), 80);
+    const QStringList rotated = sink.rotatedFiles();
+    QCOMPARE(rotated.size(), 3);  // 4 rotated so far, the oldest pruned
+    for (const QString& path : rotated) {
+        QCOMPARE(readFile(path).size(), 80);
+        QVERIFY(QFileInfo(path).fileName().startsWith("host-"));
+    }
+}
+
+void TestLogger::testFileSinkRotatesByTime()
+{
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    FileLogSink::Options options;
+    options.filePath = dir.filePath("host.log");
+    options.rotateIntervalMs = 50;
+
+    FileLogSink sink(options);
+    QVERIFY(sink.open());
+    sink.write(u"before");
+    sink.flush();
+    QTest::qWait(100);
+    sink.write(u"after");
+    sink.flush();
+
+    QCOMPARE(readFile(options.filePath), QByteArray("after\n"));
+    QCOMPARE(sink.rotatedFiles().size(), 1);
+    QCOMPARE(readFile(sink.rotatedFiles().first()), QByteArray("before\n"));
+}
+
+void TestLogger::testFileSinkCompresses()
+{
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    FileLogSink::Options options;
+    options.filePath = dir.filePath("host.log");
+    options.maxFileSize = 1024;
+    options.compress = true;
+
+    QByteArray first;
+    FileLogSink sink(options);
+    QVERIFY(sink.open());
+    for (int i = 0; i < 100; ++i) {
+        const QString line = QString("[INFO ] [orders] order %1 updated").arg(i);
+        sink.write(line);
+        sink.flush();
+        if (sink.rotatedFiles().isEmpty()) {  // Not yet rotated out
+            first += line.toUtf8() + '\n';
+        }
+    }
+    sink.waitForCompression();
+
+    const QStringList rotated = sink.rotatedFiles();
+    QVERIFY(!rotated.isEmpty());
+    QVERIFY(rotated.first().endsWith(".log.gz"));
+    QVERIFY(!QFile::exists(rotated.first().chopped(3)));
+
+    const QByteArray gzip = readFile(rotated.first());
+    QVERIFY(gzip.size() < first.size());
+    QVERIFY(gzipHolds(gzip, first));
+}
+
+void TestLogger::benchmarkFormatReplace()
+{
+    // Baseline: the previous per-message QString::replace() implementation
+    OutputCapture capture(false);
+    const QString tag = "bench";
+    const QString message = "order 42 updated";
+
+    QBENCHMARK {
+        for (int i = 0; i < MessagesPerIteration; ++i) {
+            QString result = BenchmarkFormat;
+            result.replace("%level%", "INFO ");
+            result.replace("%tag%", tag);
+            result.replace("%message%", message);
+            result.replace("%time%", QDateTime::currentDateTime().toString("hh:mm:ss.zzz"));
+            result.replace("%date%", QDateTime::currentDateTime().toString("yyyy-MM-dd"));
+            qInfo().noquote() << result;
+        }
+    }
+}
+
+void TestLogger::benchmarkFormatCompiled()
+{
+    OutputCapture capture(false);
+    Logger logger;
+    logger.setFormat(BenchmarkFormat);
+    const QString tag = "bench";
+    const QString message = "order 42 updated";
+
+    QBENCHMARK {
+        for (int i = 0; i < MessagesPerIteration; ++i) {
+            logger.info(tag, message);
+        }
+    }
+}
+
+void TestLogger::benchmarkFileSink()
+{
+    // Console off: measures formatting plus the sink's buffered writes
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    FileLogSink::Options options;
+    options.filePath = dir.filePath("bench.log");
+    options.maxFileSize = 0;
+    auto sink = std::make_unique<FileLogSink>(options);
+    QVERIFY(sink->open());
+
+    Logger logger;
+    logger.setFormat(BenchmarkFormat);
+    logger.setConsoleOutput(false);
+    logger.setFileSink(std::move(sink));
+    const QString tag = "bench";
+    const QString message = "order 42 updated";
+
+    QBENCHMARK {
+        for (int i = 0; i < MessagesPerIteration; ++i) {
+            logger.info(tag, message);
+        }
+    }
+    logger.flush();
+}
+
+QTEST_MAIN(TestLogger)
+#include "test_logger.moc"
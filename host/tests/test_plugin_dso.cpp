@@ -0,0 +1,106 @@
+#include <QTest>
+#include <QSignalSpy>
+#include <QCoreApplication>
+#include <QDir>
+#include <QFile>
+#include <QTemporaryDir>
+
+#include "logger.h"
+#include "plugin_manager.h"
+#include "plugin_loader.h"
+#include "service_registry.h"
+#include <mpf/interfaces/iplugin.h>
+#include <mpf/logger_access.h>
+
+using namespace mpf;
+
+/**
+ * @brief PluginManager with plugins built as separate libraries (see
+ *        dso_plugins/), for what static test plugins can't show: each
+ *        library has its own copy of the SDK's header-only statics
+ */
+class TestPluginDso : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void cleanup();
+    void testPluginSharesHostLogger();
+    void testFailedReloadKeepsPlugins();
+};
+
+void TestPluginDso::cleanup()
+{
+    LoggerAccess::setInstance(nullptr);
+}
+
+void TestPluginDso::testPluginSharesHostLogger()
+{
+    Logger logger;
+    QStringList messages;
+    logger.setHandler([&messages](ILogger::Level, const QString&, const QString& message) {
+        messages.append(message);
+    });
+    logger.setMinLevel(ILogger::Level::Info);
+    logger.setTagLevel("DsoPlugin", ILogger::Level::Trace);
+    LoggerAccess::setInstance(&logger);
+
+    ServiceRegistryImpl registry;
+    PluginManager manager(&registry);
+    QCOMPARE(manager.discover(MPF_TEST_DSO_DIR), 2);
+    QVERIFY(manager.loadAll());
+    QVERIFY(manager.initializeAll());
+    QVERIFY(manager.startAll());
+
+    // Reached the host's logger (not qDebug()) and followed its per-tag
+    // levels; the disabled statement did not build its message
+    QCOMPARE(messages, QStringList({"trace from plugin"}));
+    auto* root = dynamic_cast<QObject*>(manager.plugin("test.dso")->plugin());
+    QVERIFY(root);
+    QCOMPARE(root->property("evaluated").toInt(), 1);
+}
+
+void TestPluginDso::testFailedReloadKeepsPlugins()
+{
+#ifdef Q_OS_WIN
+    QSKIP("A loaded DLL can't be replaced on Windows");
+#endif
+    // Work on copies, so the library can be replaced
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    const QDir built(MPF_TEST_DSO_DIR);
+    for (const QString& name : built.entryList(QDir::Files)) {
+        QVERIFY(QFile::copy(built.filePath(name), dir.filePath(name)));
+    }
+
+    ServiceRegistryImpl registry;
+    PluginManager manager(&registry);
+    QCOMPARE(manager.discover(dir.path()), 2);
+    QVERIFY(manager.loadAll());
+    QVERIFY(manager.initializeAll());
+    QVERIFY(manager.startAll());
+    PluginLoader* old = manager.plugin("test.dso");
+
+    // A broken build: a new file, since the old one is still mapped
+    const QString path = old->path();
+    QVERIFY(QFile::remove(path));
+    QFile broken(path);
+    QVERIFY(broken.open(QIODevice::WriteOnly));
+    broken.write("not a plugin");
+    broken.close();
+
+    QSignalSpy errors(&manager, &PluginManager::pluginError);
+    QSignalSpy swapped(&manager, &PluginManager::pluginSwapped);
+    QVERIFY(!manager.reload("test.dso"));
+
+    // Rejected before anything was stopped
+    QCOMPARE(errors.count(), 1);
+    QCOMPARE(errors.at(0).at(0).toString(), QString("test.dso"));
+    QCOMPARE(swapped.count(), 0);
+    QCOMPARE(manager.plugin("test.dso"), old);
+    QCOMPARE(old->state(), PluginLoader::State::Started);
+    QCOMPARE(manager.plugin("test.dso.dependent")->state(), PluginLoader::State::Started);
+}
+
+QTEST_MAIN(TestPluginDso)
+#include "test_plugin_dso.moc"
@@ -0,0 +1,470 @@
+#include <QTest>
+#include <QSignalSpy>
+#include <QCoreApplication>
+#include <QPromise>
+#include <QTimer>
+
+#include <memory>
+
+#include "plugin_manager.h"
+#include "plugin_loader.h"
+#include "service_registry.h"
+#include <mpf/interfaces/iplugin.h>
+
+using namespace mpf;
+
+// Lifecycle calls of all test plugins, in order ("start test.core", ...)
+static QStringList& lifecycle()
+{
+    static QStringList calls;
+    return calls;
+}
+
+/**
+ * @brief In-process plugin linked into the test; registers the service
+ *        named in its metadata's "provides", if any
+ */
+class TestPlugin : public QObject, public IPlugin
+{
+    Q_OBJECT
+    Q_INTERFACES(mpf::IPlugin)
+
+public:
+    explicit TestPlugin(const QString& id, const QString& service = QString())
+        : m_id(id), m_service(service) {}
+
+    bool initialize(ServiceRegistry* registry) override
+    {
+        lifecycle().append("initialize " + m_id);
+        if (!m_service.isEmpty()) {
+            registry->addService(m_service.toLatin1().constData(), new QObject(this), 1, m_id);
+        }
+        return true;
+    }
+
+    bool start() override
+    {
+        lifecycle().append("start " + m_id);
+        return true;
+    }
+
+    void stop() override
+    {
+        lifecycle().append("stop " + m_id);
+    }
+
+    QJsonObject metadata() const override { return {}; }
+
+protected:
+    QString m_id;
+    QString m_service;
+};
+
+class CorePlugin : public TestPlugin
+{
+    Q_OBJECT
+    Q_PLUGIN_METADATA(IID MPF_IPlugin_iid FILE "static_plugins/core.json")
+    Q_INTERFACES(mpf::IPlugin)
+
+public:
+    CorePlugin() : TestPlugin("test.core", "CoreService") {}
+};
+
+class FeaturePlugin : public TestPlugin
+{
+    Q_OBJECT
+    Q_PLUGIN_METADATA(IID MPF_IPlugin_iid FILE "static_plugins/feature.json")
+    Q_INTERFACES(mpf::IPlugin)
+
+public:
+    FeaturePlugin() : TestPlugin("test.feature") {}
+};
+
+class ConsumerPlugin : public TestPlugin
+{
+    Q_OBJECT
+    Q_PLUGIN_METADATA(IID MPF_IPlugin_iid FILE "static_plugins/consumer.json")
+    Q_INTERFACES(mpf::IPlugin)
+
+public:
+    ConsumerPlugin() : TestPlugin("test.consumer") {}
+};
+
+class LazyPlugin : public TestPlugin
+{
+    Q_OBJECT
+    Q_PLUGIN_METADATA(IID MPF_IPlugin_iid FILE "static_plugins/lazy.json")
+    Q_INTERFACES(mpf::IPlugin)
+
+public:
+    LazyPlugin() : TestPlugin("test.lazy", "LazyService") {}
+};
+
+class BrokenPlugin : public TestPlugin
+{
+    Q_OBJECT
+    Q_PLUGIN_METADATA(IID MPF_IPlugin_iid FILE "static_plugins/broken.json")
+    Q_INTERFACES(mpf::IPlugin)
+
+public:
+    BrokenPlugin() : TestPlugin("test.broken") {}
+
+    bool initialize(ServiceRegistry* registry) override
+    {
+        TestPlugin::initialize(registry);
+        return false;
+    }
+};
+
+class BrokenDependentPlugin : public TestPlugin
+{
+    Q_OBJECT
+    Q_PLUGIN_METADATA(IID MPF_IPlugin_iid FILE "static_plugins/broken_dependent.json")
+    Q_INTERFACES(mpf::IPlugin)
+
+public:
+    BrokenDependentPlugin() : TestPlugin("test.broken.dependent") {}
+};
+
+class AsyncPlugin : public TestPlugin
+{
+    Q_OBJECT
+    Q_PLUGIN_METADATA(IID MPF_IPlugin_iid FILE "static_plugins/async.json")
+    Q_INTERFACES(mpf::IPlugin)
+
+public:
+    AsyncPlugin() : TestPlugin("test.async") {}
+
+    QFuture<bool> startAsync() override
+    {
+        lifecycle().append("startAsync " + m_id);
+        m_promise = std::make_shared<QPromise<bool>>();
+        m_promise->start();
+
+        // Dropped unfinished on the next event loop pass, which cancels the future
+        QTimer::singleShot(0, this, [this]() { m_promise.reset(); });
+        return m_promise->future();
+    }
+
+private:
+    std::shared_ptr<QPromise<bool>> m_promise;
+};
+
+class AsyncDependentPlugin : public TestPlugin
+{
+    Q_OBJECT
+    Q_PLUGIN_METADATA(IID MPF_IPlugin_iid FILE "static_plugins/async_dependent.json")
+    Q_INTERFACES(mpf::IPlugin)
+
+public:
+    AsyncDependentPlugin() : TestPlugin("test.async.dependent") {}
+};
+
+class CycleAPlugin : public TestPlugin
+{
+    Q_OBJECT
+    Q_PLUGIN_METADATA(IID MPF_IPlugin_iid FILE "static_plugins/cycle_a.json")
+    Q_INTERFACES(mpf::IPlugin)
+
+public:
+    CycleAPlugin() : TestPlugin("test.cycle.a") {}
+};
+
+class CycleBPlugin : public TestPlugin
+{
+    Q_OBJECT
+    Q_PLUGIN_METADATA(IID MPF_IPlugin_iid FILE "static_plugins/cycle_b.json")
+    Q_INTERFACES(mpf::IPlugin)
+
+public:
+    CycleBPlugin() : TestPlugin("test.cycle.b") {}
+};
+
+class CycleTailPlugin : public TestPlugin
+{
+    Q_OBJECT
+    Q_PLUGIN_METADATA(IID MPF_IPlugin_iid FILE "static_plugins/cycle_tail.json")
+    Q_INTERFACES(mpf::IPlugin)
+
+public:
+    CycleTailPlugin() : TestPlugin("test.cycle.tail") {}
+};
+
+class TestPluginManager : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void init();
+    void testDiscoverStatic();
+    void testLoadOrder();
+    void testServiceEdges();
+    void testDependencyCycles();
+    void testWavesSkipFailedDependents();
+    void testCanceledAsyncStart();
+    void testDeferredActivation();
+    void testDeferredServiceActivates();
+    void testUnloadStopsDependentsFirst();
+    void testReloadRestartsDependents();
+
+private:
+    static void startUp(PluginManager& manager);
+    static PluginLoader::State state(const PluginManager& manager, const QString& id);
+    static bool hasError(const QSignalSpy& spy, const QString& id, const QString& error);
+};
+
+void TestPluginManager::init()
+{
+    lifecycle().clear();
+}
+
+void TestPluginManager::startUp(PluginManager& manager)
+{
+    QCOMPARE(manager.discoverStatic(), 11);
+    manager.loadAll();
+    manager.initializeAll();
+    manager.startAll();
+}
+
+PluginLoader::State TestPluginManager::state(const PluginManager& manager, const QString& id)
+{
+    PluginLoader* loader = manager.plugin(id);
+    return loader ? loader->state() : PluginLoader::State::Error;
+}
+
+bool TestPluginManager::hasError(const QSignalSpy& spy, const QString& id, const QString& error)
+{
+    for (const QList<QVariant>& arguments : spy) {
+        if (arguments.at(0).toString() == id && arguments.at(1).toString() == error) {
+            return true;
+        }
+    }
+    return false;
+}
+
+void TestPluginManager::testDiscoverStatic()
+{
+    ServiceRegistryImpl registry;
+    PluginManager manager(&registry);
+
+    QCOMPARE(manager.discoverStatic(), 11);
+    QVERIFY(manager.plugin("test.core"));
+    QVERIFY(manager.plugin("test.core")->isStatic());
+    QCOMPARE(manager.plugin("test.core")->state(), PluginLoader::State::Unloaded);
+}
+
+void TestPluginManager::testLoadOrder()
+{
+    ServiceRegistryImpl registry;
+    PluginManager manager(&registry);
+    manager.discoverStatic();
+
+    // Dependencies first; among ready plugins priority (smaller first),
+    // then ID: test.broken (-10) beats the other roots, test.core (5)
+    // waits behind plugins already ready at 0
+    const QStringList expected{
+        "test.broken",
+        "test.async",
+        "test.async.dependent",
+        "test.broken.dependent",
+        "test.core",
+        "test.consumer",
+        "test.feature",
+        "test.lazy"
+    };
+    QCOMPARE(manager.loadOrder(), expected);
+}
+
+void TestPluginManager::testServiceEdges()
+{
+    ServiceRegistryImpl registry;
+    PluginManager manager(&registry);
+    manager.discoverStatic();
+
+    // test.consumer only requires the service; its provider comes first
+    QCOMPARE(manager.serviceProvider("CoreService"), QString("test.core"));
+    QVERIFY(manager.checkDependencies(manager.plugin("test.consumer")->metadata()).isEmpty());
+    const QStringList order = manager.loadOrder();
+    QVERIFY(order.indexOf("test.core") < order.indexOf("test.consumer"));
+
+    startUp(manager);
+    QCOMPARE(state(manager, "test.consumer"), PluginLoader::State::Started);
+    QVERIFY(registry.hasServiceNamed("CoreService"));
+}
+
+void TestPluginManager::testDependencyCycles()
+{
+    ServiceRegistryImpl registry;
+    PluginManager manager(&registry);
+    manager.discoverStatic();
+
+    const QList<QStringList> expected{{"test.cycle.a", "test.cycle.b"}};
+    QCOMPARE(manager.dependencyCycles(), expected);
+
+    // The tail is only blocked behind the cycle, but left out all the same
+    QStringList cyclic = manager.cyclicPlugins();
+    cyclic.sort();
+    QCOMPARE(cyclic, QStringList({"test.cycle.a", "test.cycle.b", "test.cycle.tail"}));
+    QVERIFY(!manager.loadOrder().contains("test.cycle.tail"));
+
+    startUp(manager);
+    QCOMPARE(state(manager, "test.cycle.a"), PluginLoader::State::Unloaded);
+    QVERIFY(!manager.activate("test.cycle.tail"));
+}
+
+void TestPluginManager::testWavesSkipFailedDependents()
+{
+    ServiceRegistryImpl registry;
+    PluginManager manager(&registry);
+    QSignalSpy errors(&manager, &PluginManager::pluginError);
+    QSignalSpy waves(&manager, &PluginManager::waveFinished);
+
+    QCOMPARE(manager.discoverStatic(), 11);
+    QVERIFY(manager.loadAll());
+    QVERIFY(!manager.initializeAll());
+
+    QVERIFY(hasError(errors, "test.broken", "Initialization failed"));
+    QVERIFY(hasError(errors, "test.broken.dependent",
+                     "Skipped initialize: required plugin test.broken failed"));
+    QVERIFY(!lifecycle().contains("initialize test.broken.dependent"));
+    QCOMPARE(state(manager, "test.broken.dependent"), PluginLoader::State::Loaded);
+    QCOMPARE(state(manager, "test.feature"), PluginLoader::State::Initialized);
+
+    // One wave per dependency level
+    QCOMPARE(waves.count(), 2);
+    QCOMPARE(waves.at(0).at(1).toInt(), 0);
+    QVERIFY(waves.at(0).at(2).toStringList().contains("test.core"));
+    QVERIFY(!waves.at(1).at(2).toStringList().contains("test.broken.dependent"));
+
+    manager.startAll();
+    QVERIFY(!lifecycle().contains("start test.broken.dependent"));
+    QCOMPARE(state(manager, "test.feature"), PluginLoader::State::Started);
+}
+
+void TestPluginManager::testCanceledAsyncStart()
+{
+    ServiceRegistryImpl registry;
+    PluginManager manager(&registry);
+    QSignalSpy errors(&manager, &PluginManager::pluginError);
+
+    startUp(manager);
+    QCOMPARE(state(manager, "test.async"), PluginLoader::State::Starting);
+    QCOMPARE(state(manager, "test.async.dependent"), PluginLoader::State::Initialized);
+
+    // A canceled future is a failed start, and its dependent is told so
+    QTRY_COMPARE(state(manager, "test.async"), PluginLoader::State::Initialized);
+    QVERIFY(hasError(errors, "test.async", "Asynchronous start failed"));
+    QVERIFY(hasError(errors, "test.async.dependent",
+                     "Skipped start: required plugin test.async failed"));
+    QVERIFY(!lifecycle().contains("start test.async.dependent"));
+}
+
+void TestPluginManager::testDeferredActivation()
+{
+    ServiceRegistryImpl registry;
+    PluginManager manager(&registry);
+    QSignalSpy activated(&manager, &PluginManager::pluginActivated);
+
+    startUp(manager);
+    QCOMPARE(manager.deferredPlugins(), QStringList({"test.lazy"}));
+    QCOMPARE(state(manager, "test.lazy"), PluginLoader::State::Unloaded);
+
+    QVERIFY(manager.activate("test.lazy"));
+    QCOMPARE(state(manager, "test.lazy"), PluginLoader::State::Started);
+    QCOMPARE(activated.count(), 1);
+    QCOMPARE(activated.at(0).at(0).toString(), QString("test.lazy"));
+
+    // Already running: nothing to do
+    QVERIFY(manager.activate("test.lazy"));
+    QCOMPARE(activated.count(), 1);
+}
+
+void TestPluginManager::testDeferredServiceActivates()
+{
+    ServiceRegistryImpl registry;
+    PluginManager manager(&registry);
+    registry.setProviderActivator([&manager](const QString& id) {
+        return manager.activate(id);
+    });
+
+    startUp(manager);
+    manager.announceDeferred(manager.deferredPlugins());
+    QVERIFY(!registry.hasServiceNamed("LazyService"));
+
+    // First lookup of the announced service brings its plugin up
+    QVERIFY(registry.getService("LazyService", 0));
+    QCOMPARE(state(manager, "test.lazy"), PluginLoader::State::Started);
+}
+
+void TestPluginManager::testUnloadStopsDependentsFirst()
+{
+    ServiceRegistryImpl registry;
+    PluginManager manager(&registry);
+    QSignalSpy swapped(&manager, &PluginManager::pluginSwapped);
+
+    startUp(manager);
+    QVERIFY(manager.activate("test.lazy"));
+    lifecycle().clear();
+
+    QVERIFY(manager.unload("test.core"));
+
+    // Everything reachable through plugin and service edges, in reverse load order
+    QCOMPARE(lifecycle(), QStringList({"stop test.lazy", "stop test.feature",
+                                       "stop test.consumer", "stop test.core"}));
+    QCOMPARE(swapped.count(), 1);
+    QCOMPARE(swapped.at(0).at(1).toStringList(),
+             QStringList({"test.core", "test.consumer", "test.feature", "test.lazy"}));
+
+    for (const QString& id : {"test.core", "test.consumer", "test.feature", "test.lazy"}) {
+        QCOMPARE(state(manager, id), PluginLoader::State::Unloaded);
+    }
+    QVERIFY(!registry.hasServiceNamed("CoreService"));
+    QVERIFY(!registry.hasServiceNamed("LazyService"));
+    QCOMPARE(state(manager, "test.broken.dependent"), PluginLoader::State::Loaded);
+
+    // Still known: activate() brings them back
+    QVERIFY(manager.activate("test.feature"));
+    QCOMPARE(state(manager, "test.core"), PluginLoader::State::Started);
+    QVERIFY(registry.hasServiceNamed("CoreService"));
+}
+
+void TestPluginManager::testReloadRestartsDependents()
+{
+    ServiceRegistryImpl registry;
+    PluginManager manager(&registry);
+
+    startUp(manager);
+    PluginLoader* old = manager.plugin("test.core");
+    lifecycle().clear();
+
+    QVERIFY(manager.reload("test.core"));
+    QVERIFY(manager.plugin("test.core") != old);
+
+    // Stopped dependents first, restarted dependencies first; test.lazy
+    // was not loaded before and stays that way
+    QCOMPARE(lifecycle(), QStringList({
+        "stop test.feature", "stop test.consumer", "stop test.core",
+        "initialize test.core", "start test.core",
+        "initialize test.consumer", "start test.consumer",
+        "initialize test.feature", "start test.feature"
+    }));
+    QCOMPARE(state(manager, "test.core"), PluginLoader::State::Started);
+    QCOMPARE(state(manager, "test.feature"), PluginLoader::State::Started);
+    QCOMPARE(state(manager, "test.lazy"), PluginLoader::State::Unloaded);
+    QVERIFY(registry.hasServiceNamed("CoreService"));
+}
+
+Q_IMPORT_PLUGIN(CorePlugin)
+Q_IMPORT_PLUGIN(FeaturePlugin)
+Q_IMPORT_PLUGIN(ConsumerPlugin)
+Q_IMPORT_PLUGIN(LazyPlugin)
+Q_IMPORT_PLUGIN(BrokenPlugin)
+Q_IMPORT_PLUGIN(BrokenDependentPlugin)
+Q_IMPORT_PLUGIN(AsyncPlugin)
+Q_IMPORT_PLUGIN(AsyncDependentPlugin)
+Q_IMPORT_PLUGIN(CycleAPlugin)
+Q_IMPORT_PLUGIN(CycleBPlugin)
+Q_IMPORT_PLUGIN(CycleTailPlugin)
+
+QTEST_MAIN(TestPluginManager)
+#include "test_plugin_manager.moc"
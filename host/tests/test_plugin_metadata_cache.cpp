@@ -0,0 +1,168 @@
+#include <QTest>
+#include <QCoreApplication>
+#include <QDateTime>
+#include <QFile>
+#include <QTemporaryDir>
+#include <memory>
+
+#include "plugin_metadata_cache.h"
+
+using namespace mpf;
+
+class TestPluginMetadataCache : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void init();
+
+    void testMissThenHit();
+    void testPersisted();
+    void testInvalidatedOnChange();
+    void testHashVerification();
+    void testClear();
+    void testRemove();
+    void testPrune();
+    void testCorruptFile();
+
+private:
+    QString writePlugin(const QString& name, const QByteArray& contents);
+    QString cachePath() const { return m_dir->filePath("plugin-cache.bin"); }
+
+    std::unique_ptr<QTemporaryDir> m_dir;
+    QJsonObject m_meta;
+};
+
+void TestPluginMetadataCache::init()
+{
+    m_dir = std::make_unique<QTemporaryDir>();
+    QVERIFY(m_dir->isValid());
+    m_meta = QJsonObject{{"id", "com.example.a"}, {"version", "1.2.0"}};
+}
+
+QString TestPluginMetadataCache::writePlugin(const QString& name, const QByteArray& contents)
+{
+    QString path = m_dir->filePath(name);
+    QFile file(path);
+    if (file.open(QIODevice::WriteOnly)) {
+        file.write(contents);
+    }
+    return path;
+}
+
+void TestPluginMetadataCache::testMissThenHit()
+{
+    QFileInfo info(writePlugin("liba.so", "abc"));
+    PluginMetadataCache cache(cachePath());
+
+    QJsonObject meta;
+    QVERIFY(!cache.lookup(info, &meta));
+    cache.insert(info, m_meta);
+    QVERIFY(cache.lookup(info, &meta));
+    QCOMPARE(meta, m_meta);
+    QCOMPARE(cache.hits(), 1);
+    QCOMPARE(cache.misses(), 1);
+}
+
+void TestPluginMetadataCache::testPersisted()
+{
+    QFileInfo info(writePlugin("liba.so", "abc"));
+    {
+        PluginMetadataCache cache(cachePath());
+        cache.insert(info, m_meta);
+        QVERIFY(cache.save());
+    }
+
+    PluginMetadataCache cache(cachePath());
+    QVERIFY(cache.load());
+    QJsonObject meta;
+    QVERIFY(cache.lookup(info, &meta));
+    QCOMPARE(meta, m_meta);
+}
+
+void TestPluginMetadataCache::testInvalidatedOnChange()
+{
+    QString path = writePlugin("liba.so", "abc");
+    PluginMetadataCache cache(cachePath());
+    cache.insert(QFileInfo(path), m_meta);
+
+    writePlugin("liba.so", "abcdef");
+
+    QJsonObject meta;
+    QVERIFY(!cache.lookup(QFileInfo(path), &meta));
+}
+
+void TestPluginMetadataCache::testHashVerification()
+{
+    QString path = writePlugin("liba.so", "abc");
+    QFile file(path);
+    QVERIFY(file.open(QIODevice::ReadWrite));
+    const QDateTime mtime = QFileInfo(path).lastModified();
+
+    PluginMetadataCache cache(cachePath());
+    cache.setVerifyHash(true);
+    cache.insert(QFileInfo(path), m_meta);
+
+    // Same size and mtime, different contents
+    file.write("xyz");
+    file.flush();
+    file.setFileTime(mtime, QFileDevice::FileModificationTime);
+    file.close();
+
+    QJsonObject meta;
+    QVERIFY(!cache.lookup(QFileInfo(path), &meta));
+
+    cache.setVerifyHash(false);
+    QVERIFY(cache.lookup(QFileInfo(path), &meta));
+}
+
+void TestPluginMetadataCache::testClear()
+{
+    QFileInfo info(writePlugin("liba.so", "abc"));
+    PluginMetadataCache cache(cachePath());
+    cache.insert(info, m_meta);
+    cache.clear();
+
+    QJsonObject meta;
+    QVERIFY(!cache.lookup(info, &meta));
+}
+
+void TestPluginMetadataCache::testRemove()
+{
+    QFileInfo a(writePlugin("liba.so", "abc"));
+    QFileInfo b(writePlugin("libb.so", "def"));
+    PluginMetadataCache cache(cachePath());
+    cache.insert(a, m_meta);
+    cache.insert(b, m_meta);
+
+    cache.remove(a.absoluteFilePath());
+
+    QJsonObject meta;
+    QVERIFY(!cache.lookup(a, &meta));
+    QVERIFY(cache.lookup(b, &meta));
+}
+
+void TestPluginMetadataCache::testPrune()
+{
+    QString a = writePlugin("liba.so", "abc");
+    QString b = writePlugin("libb.so", "def");
+    PluginMetadataCache cache(cachePath());
+    cache.insert(QFileInfo(a), m_meta);
+    cache.insert(QFileInfo(b), m_meta);
+
+    cache.prune(m_dir->path(), {a});
+
+    QJsonObject meta;
+    QVERIFY(cache.lookup(QFileInfo(a), &meta));
+    QVERIFY(!cache.lookup(QFileInfo(b), &meta));
+}
+
+void TestPluginMetadataCache::testCorruptFile()
+{
+    writePlugin("plugin-cache.bin", "not a cache");
+    PluginMetadataCache cache(cachePath());
+    QVERIFY(!cache.load());
+}
+
+QTEST_MAIN(TestPluginMetadataCache)
+#include "test_plugin_metadata_cache.moc"
@@ -0,0 +1,87 @@
+#include <QTest>
+#include <QCoreApplication>
+#include <QSignalSpy>
+#include <QThread>
+
+#include "plugin_watchdog.h"
+
+using namespace mpf;
+
+class TestPluginWatchdog : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void testDisarmReturnsElapsed();
+    void testDisarmUnknown();
+    void testBudgetExceededWhileRunning();
+    void testNoBudget();
+    void testShutdown();
+};
+
+void TestPluginWatchdog::testDisarmReturnsElapsed()
+{
+    PluginWatchdog watchdog;
+    watchdog.start();
+
+    watchdog.arm("com.example.a", "initialize", 1000);
+    QThread::msleep(20);
+    const qint64 elapsedNs = watchdog.disarm("com.example.a", "initialize");
+
+    QVERIFY(elapsedNs >= 20 * 1000000LL);
+    QVERIFY(elapsedNs < 1000 * 1000000LL);
+}
+
+void TestPluginWatchdog::testDisarmUnknown()
+{
+    PluginWatchdog watchdog;
+    QCOMPARE(watchdog.disarm("com.example.a", "start"), qint64(-1));
+
+    watchdog.arm("com.example.a", "initialize", 100);
+    QCOMPARE(watchdog.disarm("com.example.a", "start"), qint64(-1));
+    QVERIFY(watchdog.disarm("com.example.a", "initialize") >= 0);
+}
+
+void TestPluginWatchdog::testBudgetExceededWhileRunning()
+{
+    PluginWatchdog watchdog;
+    QSignalSpy spy(&watchdog, &PluginWatchdog::budgetExceeded);
+    watchdog.start();
+
+    // Reported while the phase is still armed, and only once
+    watchdog.arm("com.example.slow", "start", 10);
+    QVERIFY(spy.wait(2000));
+    QCOMPARE(spy.count(), 1);
+    QCOMPARE(spy.at(0).at(0).toString(), QString("com.example.slow"));
+    QCOMPARE(spy.at(0).at(1).toString(), QString("start"));
+    QCOMPARE(spy.at(0).at(2).toInt(), 10);
+
+    QTest::qWait(50);
+    QCOMPARE(spy.count(), 1);
+    QVERIFY(watchdog.disarm("com.example.slow", "start") >= 10 * 1000000LL);
+}
+
+void TestPluginWatchdog::testNoBudget()
+{
+    PluginWatchdog watchdog;
+    QSignalSpy spy(&watchdog, &PluginWatchdog::budgetExceeded);
+    watchdog.start();
+
+    watchdog.arm("com.example.a", "initialize", 0);
+    QTest::qWait(50);
+    QCOMPARE(spy.count(), 0);
+    QVERIFY(watchdog.disarm("com.example.a", "initialize") >= 0);
+}
+
+void TestPluginWatchdog::testShutdown()
+{
+    PluginWatchdog watchdog;
+    watchdog.start();
+    watchdog.arm("com.example.a", "start", 60000);
+
+    watchdog.shutdown();
+    QVERIFY(watchdog.isFinished());
+}
+
+QTEST_MAIN(TestPluginWatchdog)
+#include "test_plugin_watchdog.moc"
@@ -0,0 +1,585 @@
+#include <QTest>
+#include <QSignalSpy>
+#include <QCoreApplication>
+#include <QPointer>
+#include <QThread>
+#include <QThreadPool>
+
+#include <atomic>
+
+#include "service_registry.h"
+#include "plugin_context.h"
+
+using namespace mpf;
+
+namespace {
+
+class ICounter
+{
+public:
+    virtual ~ICounter() = default;
+    virtual int value() const = 0;
+};
+
+class CounterService : public QObject, public ICounter
+{
+public:
+    explicit CounterService(int value = 0, QObject* parent = nullptr)
+        : QObject(parent), m_value(value) {}
+
+    int value() const override { return m_value; }
+
+private:
+    int m_value;
+};
+
+} // namespace
+
+class TestServiceRegistry : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void init();
+    void cleanup();
+
+    // Basic registration
+    void testAddAndGet();
+    void testDuplicateRejected();
+    void testMinVersion();
+    void testRemove();
+
+    // Lazy factories
+    void testFactoryDeferred();
+    void testFactoryConcurrentGet();
+    void testFactoryOwnership();
+    void testRemoveDeletesOutsideLock();
+    void testDestroyDeletesOutsideLock();
+
+    // Asynchronous availability
+    void testWhenAlreadyAvailable();
+    void testWhenResolvesOnAdd();
+    void testWhenMinVersion();
+    void testWhenCanceledOnDestroy();
+
+    // Multiple providers
+    void testRankedProviders();
+    void testRoundRobin();
+    void testLeastOutstanding();
+    void testProviderCounters();
+
+    // Thread-marshalling proxies
+    void testProxyCallFromWorker();
+    void testProxyCallOnOwnerThread();
+    void testProxyCoalescing();
+    void testProxyCoalescingIsPerProxy();
+    void testProxyOutlivesRegistry();
+
+    // Usage statistics
+    void testStatsDisabledByDefault();
+    void testStatsPerConsumer();
+    void testStatsCalls();
+    void testStatsChargeProxyCreator();
+
+private:
+    ServiceRegistryImpl* m_registry = nullptr;
+};
+
+void TestServiceRegistry::init()
+{
+    m_registry = new ServiceRegistryImpl(this);
+}
+
+void TestServiceRegistry::cleanup()
+{
+    delete m_registry;
+    m_registry = nullptr;
+}
+
+// =============================================================================
+// Basic registration
+// =============================================================================
+
+void TestServiceRegistry::testAddAndGet()
+{
+    QSignalSpy spy(m_registry, &ServiceRegistryImpl::serviceAdded);
+    CounterService service(42);
+
+    QVERIFY(m_registry->add<ICounter>(&service, 1, "plugin-a"));
+    QCOMPARE(spy.count(), 1);
+
+    ICounter* counter = m_registry->get<ICounter>();
+    QVERIFY(counter);
+    QCOMPARE(counter->value(), 42);
+    QVERIFY(m_registry->has<ICounter>());
+}
+
+void TestServiceRegistry::testDuplicateRejected()
+{
+    CounterService first(1);
+    CounterService second(2);
+
+    QVERIFY(m_registry->add<ICounter>(&first));
+    QVERIFY(!m_registry->add<ICounter>(&second));
+    QCOMPARE(m_registry->get<ICounter>()->value(), 1);
+}
+
+void TestServiceRegistry::testMinVersion()
+{
+    CounterService service;
+    m_registry->add<ICounter>(&service, 2);
+
+    QVERIFY(m_registry->get<ICounter>(2));
+    QVERIFY(!m_registry->get<ICounter>(3));
+    QVERIFY(!m_registry->has<ICounter>(3));
+    QCOMPARE(m_registry->version<ICounter>(), 2);
+}
+
+void TestServiceRegistry::testRemove()
+{
+    CounterService service;
+    m_registry->add<ICounter>(&service);
+
+    QSignalSpy spy(m_registry, &ServiceRegistryImpl::serviceRemoved);
+    m_registry->remove<ICounter>();
+
+    QCOMPARE(spy.count(), 1);
+    QVERIFY(!m_registry->has<ICounter>());
+    QVERIFY(!m_registry->get<ICounter>());
+}
+
+// =============================================================================
+// Lazy factories
+// =============================================================================
+
+void TestServiceRegistry::testFactoryDeferred()
+{
+    int constructed = 0;
+    QVERIFY(m_registry->addFactory<ICounter>([&constructed]() -> ICounter* {
+        ++constructed;
+        return new CounterService(7);
+    }));
+
+    // Registration and availability checks must not construct
+    QVERIFY(m_registry->has<ICounter>());
+    QCOMPARE(constructed, 0);
+    QVERIFY(m_registry->entry(QString::fromLatin1(typeid(ICounter).name()))->instance == nullptr);
+
+    ICounter* first = m_registry->get<ICounter>();
+    ICounter* second = m_registry->get<ICounter>();
+    QVERIFY(first);
+    QCOMPARE(first, second);
+    QCOMPARE(first->value(), 7);
+    QCOMPARE(constructed, 1);
+}
+
+void TestServiceRegistry::testFactoryConcurrentGet()
+{
+    std::atomic<int> constructed{0};
+    m_registry->addFactory<ICounter>([&constructed]() -> ICounter* {
+        ++constructed;
+        QThread::msleep(20);  // Widen the race window
+        return new CounterService(1);
+    });
+
+    constexpr int kCallers = 8;
+    std::atomic<ICounter*> results[kCallers] = {};
+
+    QThreadPool pool;
+    pool.setMaxThreadCount(kCallers);
+    for (int i = 0; i < kCallers; ++i) {
+        pool.start([this, &results, i]() {
+            results[i] = m_registry->get<ICounter>();
+        });
+    }
+    pool.waitForDone();
+
+    QCOMPARE(constructed.load(), 1);
+    for (int i = 0; i < kCallers; ++i) {
+        QVERIFY(results[i].load());
+        QCOMPARE(results[i].load(), results[0].load());
+    }
+
+    // Instances created off-thread are moved to the registry's thread
+    auto* obj = m_registry->getObject<ICounter>();
+    QCOMPARE(obj->thread(), m_registry->thread());
+}
+
+void TestServiceRegistry::testFactoryOwnership()
+{
+    m_registry->addFactory<ICounter>([]() -> ICounter* {
+        return new CounterService(3);
+    });
+
+    QPointer<QObject> instance = m_registry->getObject<ICounter>();
+    QVERIFY(instance);
+
+    delete m_registry;
+    m_registry = nullptr;
+    QVERIFY(instance.isNull());
+}
+
+void TestServiceRegistry::testRemoveDeletesOutsideLock()
+{
+    bool destroyed = false;
+    bool stillRegistered = true;
+    m_registry->addFactory<ICounter>([&]() -> ICounter* {
+        auto* service = new CounterService(4);
+        // Would deadlock if the instance were deleted under the registry lock
+        QObject::connect(service, &QObject::destroyed, [&]() {
+            destroyed = true;
+            stillRegistered = m_registry->has<ICounter>();
+        });
+        return service;
+    });
+    QVERIFY(m_registry->get<ICounter>());
+
+    m_registry->remove<ICounter>();
+    QVERIFY(destroyed);
+    QVERIFY(!stillRegistered);
+    QVERIFY(!m_registry->entry(QString::fromLatin1(typeid(ICounter).name())));
+}
+
+void TestServiceRegistry::testDestroyDeletesOutsideLock()
+{
+    bool destroyed = false;
+    bool stillRegistered = true;
+    m_registry->addFactory<ICounter>([&]() -> ICounter* {
+        auto* service = new CounterService(6);
+        // Would deadlock if ~ServiceRegistryImpl deleted it under the lock
+        QObject::connect(service, &QObject::destroyed, [&]() {
+            destroyed = true;
+            stillRegistered = m_registry->has<ICounter>();
+        });
+        return service;
+    });
+    QVERIFY(m_registry->get<ICounter>());
+
+    delete m_registry;
+    m_registry = nullptr;
+    QVERIFY(destroyed);
+    QVERIFY(!stillRegistered);
+}
+
+// =============================================================================
+// Asynchronous availability
+// =============================================================================
+
+void TestServiceRegistry::testWhenAlreadyAvailable()
+{
+    CounterService service(5);
+    m_registry->add<ICounter>(&service);
+
+    QFuture<ICounter*> future = m_registry->when<ICounter>();
+    QVERIFY(future.isFinished());
+    QCOMPARE(future.result()->value(), 5);
+}
+
+void TestServiceRegistry::testWhenResolvesOnAdd()
+{
+    QFuture<ICounter*> future = m_registry->when<ICounter>();
+    QVERIFY(!future.isFinished());
+
+    CounterService service(9);
+    m_registry->add<ICounter>(&service);
+
+    QVERIFY(future.isFinished());
+    QCOMPARE(future.result(), static_cast<ICounter*>(&service));
+}
+
+void TestServiceRegistry::testWhenMinVersion()
+{
+    QFuture<ICounter*> future = m_registry->when<ICounter>(2);
+
+    CounterService oldService(1);
+    m_registry->add<ICounter>(&oldService, 1);
+    QVERIFY(!future.isFinished());
+
+    m_registry->remove<ICounter>();
+
+    CounterService newService(2);
+    m_registry->add<ICounter>(&newService, 2);
+    QVERIFY(future.isFinished());
+    QCOMPARE(future.result()->value(), 2);
+}
+
+void TestServiceRegistry::testWhenCanceledOnDestroy()
+{
+    QFuture<ICounter*> future = m_registry->when<ICounter>();
+
+    delete m_registry;
+    m_registry = nullptr;
+
+    QVERIFY(future.isFinished());
+    QVERIFY(future.isCanceled());
+}
+
+// =============================================================================
+// Multiple providers
+// =============================================================================
+
+void TestServiceRegistry::testRankedProviders()
+{
+    CounterService low(1);
+    CounterService high(2);
+    CounterService old(3);
+
+    QVERIFY(m_registry->addProvider<ICounter>(&low, 1, 2, "backend-low"));
+    QVERIFY(m_registry->addProvider<ICounter>(&high, 10, 2, "backend-high"));
+    QVERIFY(m_registry->addProvider<ICounter>(&old, 20, 1, "backend-old"));
+
+    // Same instance cannot be registered twice, exclusive add() is refused
+    QVERIFY(!m_registry->addProvider<ICounter>(&low, 5));
+    QVERIFY(!m_registry->add<ICounter>(&low));
+
+    QCOMPARE(m_registry->get<ICounter>()->value(), 3);
+    // Version filtering skips the higher-ranked but older provider
+    QCOMPARE(m_registry->get<ICounter>(2)->value(), 2);
+
+    QList<ServiceEntry> providers =
+        m_registry->providers(QString::fromLatin1(typeid(ICounter).name()));
+    QCOMPARE(providers.size(), 3);
+    QCOMPARE(providers.at(0).providerId, QString("backend-old"));
+    QCOMPARE(providers.at(2).providerId, QString("backend-low"));
+}
+
+void TestServiceRegistry::testRoundRobin()
+{
+    CounterService a(1);
+    CounterService b(2);
+    m_registry->addProvider<ICounter>(&a, 0);
+    m_registry->addProvider<ICounter>(&b, 0);
+    m_registry->setSelectionPolicy<ICounter>(ServiceRegistry::SelectionPolicy::RoundRobin);
+
+    QCOMPARE(m_registry->get<ICounter>()->value(), 1);
+    QCOMPARE(m_registry->get<ICounter>()->value(), 2);
+    QCOMPARE(m_registry->get<ICounter>()->value(), 1);
+}
+
+void TestServiceRegistry::testLeastOutstanding()
+{
+    CounterService a(1);
+    CounterService b(2);
+    m_registry->addProvider<ICounter>(&a, 10);
+    m_registry->addProvider<ICounter>(&b, 0);
+    m_registry->setSelectionPolicy<ICounter>(ServiceRegistry::SelectionPolicy::LeastOutstanding);
+
+    ServiceHandle<ICounter> first = m_registry->acquire<ICounter>();
+    QCOMPARE(first->value(), 1);  // Tie broken by rank
+
+    ServiceHandle<ICounter> second = m_registry->acquire<ICounter>();
+    QCOMPARE(second->value(), 2);  // 'a' is busy
+
+    first.reset();
+    ServiceHandle<ICounter> third = m_registry->acquire<ICounter>();
+    QCOMPARE(third->value(), 1);
+}
+
+void TestServiceRegistry::testProviderCounters()
+{
+    CounterService service;
+    m_registry->addProvider<ICounter>(&service, 0, 1, "plugin-a");
+
+    m_registry->get<ICounter>();
+    {
+        ServiceHandle<ICounter> handle = m_registry->acquire<ICounter>();
+        QVERIFY(handle);
+        const auto entry = m_registry->entry(QString::fromLatin1(typeid(ICounter).name()));
+        QCOMPARE(entry->counters->outstanding.load(), 1);
+    }
+
+    const auto entry = m_registry->entry(QString::fromLatin1(typeid(ICounter).name()));
+    QCOMPARE(entry->counters->calls.load(), quint64(2));
+    QCOMPARE(entry->counters->outstanding.load(), 0);
+}
+
+// =============================================================================
+// Thread-marshalling proxies
+// =============================================================================
+
+void TestServiceRegistry::testProxyCallFromWorker()
+{
+    CounterService service(11);
+    m_registry->add<ICounter>(&service);
+
+    ServiceProxy<ICounter> proxy = m_registry->proxy<ICounter>();
+    QVERIFY(proxy);
+
+    QFuture<int> future;
+    QThread* executedOn = nullptr;
+    QThread* worker = QThread::create([&]() {
+        future = proxy.call([&executedOn](ICounter* counter) {
+            executedOn = QThread::currentThread();
+            return counter->value();
+        });
+    });
+    worker->start();
+    worker->wait();
+    delete worker;
+
+    // Nothing runs until the owner thread processes the batch
+    QVERIFY(!future.isFinished());
+    QCoreApplication::processEvents();
+
+    QVERIFY(future.isFinished());
+    QCOMPARE(future.result(), 11);
+    QCOMPARE(executedOn, QThread::currentThread());
+}
+
+void TestServiceRegistry::testProxyCallOnOwnerThread()
+{
+    CounterService service(4);
+    m_registry->add<ICounter>(&service);
+
+    ServiceProxy<ICounter> proxy = m_registry->proxy<ICounter>();
+    QFuture<int> future = proxy.call([](ICounter* counter) { return counter->value() * 2; });
+
+    // Same-thread calls run inline
+    QVERIFY(future.isFinished());
+    QCOMPARE(future.result(), 8);
+}
+
+void TestServiceRegistry::testProxyCoalescing()
+{
+    CounterService service;
+    m_registry->add<ICounter>(&service);
+    ServiceProxy<ICounter> proxy = m_registry->proxy<ICounter>();
+
+    int runs = 0;
+    int lastValue = 0;
+    for (int i = 1; i <= 3; ++i) {
+        proxy.post([&runs, &lastValue, i](ICounter*) {
+            ++runs;
+            lastValue = i;
+        }, 42);
+    }
+    proxy.post([&runs](ICounter*) { ++runs; });
+
+    QCOMPARE(runs, 0);
+    QCoreApplication::processEvents();
+
+    // Three keyed posts collapse into the latest, the unkeyed one survives
+    QCOMPARE(runs, 2);
+    QCOMPARE(lastValue, 3);
+}
+
+void TestServiceRegistry::testProxyCoalescingIsPerProxy()
+{
+    CounterService service;
+    m_registry->add<ICounter>(&service);
+    ServiceProxy<ICounter> first = m_registry->proxy<ICounter>();
+    ServiceProxy<ICounter> second = m_registry->proxy<ICounter>();
+
+    QStringList runs;
+    first.post([&runs](ICounter*) { runs.append("first"); }, 7);
+    second.post([&runs](ICounter*) { runs.append("second"); }, 7);
+    QCoreApplication::processEvents();
+
+    // Same key, different callers: neither replaces the other
+    QCOMPARE(runs, QStringList({"first", "second"}));
+}
+
+void TestServiceRegistry::testProxyOutlivesRegistry()
+{
+    CounterService service;
+    m_registry->add<ICounter>(&service);
+    m_registry->stats().setEnabled(true);
+    ServiceProxy<ICounter> proxy = m_registry->proxy<ICounter>();
+
+    delete m_registry;
+    m_registry = nullptr;
+
+    // Dropped, and must not touch the deleted registry's statistics
+    bool ran = false;
+    proxy.post([&ran](ICounter*) { ran = true; });
+    QCoreApplication::processEvents();
+    QVERIFY(!ran);
+}
+
+void TestServiceRegistry::testStatsDisabledByDefault()
+{
+    CounterService service;
+    m_registry->add<ICounter>(&service);
+
+    QVERIFY(m_registry->get<ICounter>());
+    QVERIFY(m_registry->has<ICounter>());
+    QVERIFY(m_registry->stats().snapshot().isEmpty());
+}
+
+void TestServiceRegistry::testStatsPerConsumer()
+{
+    CounterService service;
+    m_registry->add<ICounter>(&service);
+    m_registry->stats().setEnabled(true);
+
+    m_registry->get<ICounter>();
+    {
+        PluginContext::Scope scope("com.example.a");
+        m_registry->get<ICounter>();
+        m_registry->has<ICounter>();
+    }
+
+    const QList<ServiceStats::Row> rows = m_registry->stats().snapshot();
+    QCOMPARE(rows.size(), 2);
+    QCOMPARE(rows.at(0).consumer, QString());
+    QCOMPARE(rows.at(0).lookups, quint64(1));
+    QCOMPARE(rows.at(1).consumer, QString("com.example.a"));
+    QCOMPARE(rows.at(1).lookups, quint64(2));
+    QCOMPARE(rows.at(1).interfaceName, QString::fromLatin1(typeid(ICounter).name()));
+    QVERIFY(m_registry->registryStats().contains("com.example.a"));
+
+    m_registry->stats().reset();
+    QCOMPARE(m_registry->stats().snapshot().at(1).lookups, quint64(0));
+}
+
+void TestServiceRegistry::testStatsCalls()
+{
+    CounterService service;
+    m_registry->add<ICounter>(&service);
+    m_registry->stats().setEnabled(true);
+
+    PluginContext::Scope scope("com.example.b");
+    {
+        auto handle = m_registry->acquire<ICounter>();
+        QVERIFY(handle);
+    }
+
+    ServiceProxy<ICounter> proxy = m_registry->proxy<ICounter>();
+    proxy.call([](ICounter* counter) { return counter->value(); });
+    proxy.post([](ICounter*) {});
+    QCoreApplication::processEvents();
+
+    const QList<ServiceStats::Row> rows = m_registry->stats().snapshot();
+    QCOMPARE(rows.size(), 1);
+    QCOMPARE(rows.at(0).consumer, QString("com.example.b"));
+    QCOMPARE(rows.at(0).lookups, quint64(2));  // acquire() + proxy()
+    QCOMPARE(rows.at(0).calls, quint64(3));    // handle + inline call + posted call
+    QVERIFY(rows.at(0).totalNs >= 0);
+}
+
+void TestServiceRegistry::testStatsChargeProxyCreator()
+{
+    CounterService service;
+    m_registry->add<ICounter>(&service);
+    m_registry->stats().setEnabled(true);
+
+    ServiceProxy<ICounter> proxy;
+    {
+        PluginContext::Scope scope("com.example.c");
+        proxy = m_registry->proxy<ICounter>();
+    }
+
+    // Called later from outside any plugin scope, e.g. an event handler
+    proxy.call([](ICounter* counter) { return counter->value(); });
+    proxy.post([](ICounter*) {});
+    QCoreApplication::processEvents();
+
+    const QList<ServiceStats::Row> rows = m_registry->stats().snapshot();
+    QCOMPARE(rows.size(), 1);
+    QCOMPARE(rows.at(0).consumer, QString("com.example.c"));
+    QCOMPARE(rows.at(0).lookups, quint64(1));
+    QCOMPARE(rows.at(0).calls, quint64(2));
+}
+
+QTEST_MAIN(TestServiceRegistry)
+#include "test_service_registry.moc"
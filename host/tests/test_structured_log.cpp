@@ -0,0 +1,268 @@
+#include <QTest>
+#include <QCoreApplication>
+#include <QDateTime>
+#include <QFile>
+#include <QFileInfo>
+#include <QTemporaryDir>
+
+#include "logger.h"
+#include "structured_log_reader.h"
+#include <mpf/structured_log.h>
+
+using namespace mpf;
+
+class TestStructuredLog : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void init();
+    void cleanup();
+
+    void testRoundTrip();
+    void testTextFallback();
+    void testDisabledLevelSkipsArguments();
+    void testReopenRepeatsSites();
+    void testTruncatedFile();
+    void testSmallerThanText();
+    void benchmarkTextLog();
+    void benchmarkStructuredLog();
+
+private:
+    QString path(const QString& name) const { return m_dir.filePath(name); }
+    QList<StructuredLogReader::Entry> readAll(const QString& file);
+
+    QTemporaryDir m_dir;
+};
+
+namespace {
+
+constexpr int MessagesPerIteration = 1000;
+
+void discardMessages(QtMsgType, const QMessageLogContext&, const QString&)
+{
+}
+
+void logFrame(int frame, int micros)
+{
+    MPF_SLOG_INFO("Render", "frame {} took {} us", frame, micros);
+}
+
+} // namespace
+
+void TestStructuredLog::init()
+{
+    QVERIFY(m_dir.isValid());
+}
+
+void TestStructuredLog::cleanup()
+{
+    LoggerAccess::setInstance(nullptr);
+}
+
+QList<StructuredLogReader::Entry> TestStructuredLog::readAll(const QString& file)
+{
+    QList<StructuredLogReader::Entry> entries;
+    StructuredLogReader reader;
+    if (!reader.open(file)) {
+        qWarning() << reader.errorString();
+        return entries;
+    }
+    StructuredLogReader::Entry entry;
+    while (reader.readNext(&entry)) {
+        entries.append(entry);
+    }
+    if (!reader.errorString().isEmpty()) {
+        qWarning() << reader.errorString();
+    }
+    return entries;
+}
+
+void TestStructuredLog::testRoundTrip()
+{
+    Logger logger;
+    QVERIFY(logger.setStructuredOutput(path("roundtrip.slog")));
+    LoggerAccess::setInstance(&logger);
+
+    const qint64 before = QDateTime::currentMSecsSinceEpoch();
+    MPF_SLOG_INFO("Orders", "order {} total {} status {} paid {}", 42, 19.5, QString("shipped"), true);
+    MPF_SLOG_ERROR("Orders", "{} of {} failed ({}, level {})", qint64(1) << 40, 7u, "timeout",
+                   ILogger::Level::Warning);
+    MPF_SLOG_WARNING("Orders", "no arguments");
+    logger.flush();
+
+    const auto entries = readAll(path("roundtrip.slog"));
+    QCOMPARE(entries.size(), 3);
+    QCOMPARE(entries.at(0).message, QString("order 42 total 19.5 status shipped paid true"));
+    QCOMPARE(entries.at(0).tag, QString("Orders"));
+    QCOMPARE(entries.at(0).level, ILogger::Level::Info);
+    QVERIFY(entries.at(0).timestampMs >= before);
+    QCOMPARE(entries.at(1).message, QString("1099511627776 of 7 failed (timeout, level 3)"));
+    QCOMPARE(entries.at(1).level, ILogger::Level::Error);
+    QCOMPARE(entries.at(2).message, QString("no arguments"));
+}
+
+void TestStructuredLog::testTextFallback()
+{
+    Logger logger;
+    QStringList messages;
+    logger.setHandler([&messages](ILogger::Level, const QString& tag, const QString& message) {
+        messages.append(tag + ": " + message);
+    });
+    LoggerAccess::setInstance(&logger);
+
+    MPF_SLOG_WARNING("net", "retry {} of {}", 2, 5);
+    QCOMPARE(messages, QStringList({"net: retry 2 of 5"}));
+}
+
+void TestStructuredLog::testDisabledLevelSkipsArguments()
+{
+    Logger logger;
+    QVERIFY(logger.setStructuredOutput(path("disabled.slog")));
+    LoggerAccess::setInstance(&logger);
+    logger.setMinLevel(ILogger::Level::Warning);
+
+    int evaluated = 0;
+    auto value = [&evaluated]() { return ++evaluated; };
+    MPF_SLOG_DEBUG("test", "value {}", value());
+    QCOMPARE(evaluated, 0);
+
+    MPF_SLOG_ERROR("test", "value {}", value());
+    QCOMPARE(evaluated, 1);
+    logger.flush();
+    QCOMPARE(readAll(path("disabled.slog")).size(), 1);
+}
+
+void TestStructuredLog::testReopenRepeatsSites()
+{
+    Logger logger;
+    QVERIFY(logger.setStructuredOutput(path("first.slog")));
+    LoggerAccess::setInstance(&logger);
+    logFrame(1, 100);
+
+    // The call site keeps its ID; the new file must still describe it
+    QVERIFY(logger.setStructuredOutput(path("second.slog")));
+    QCOMPARE(logger.structuredOutput(), path("second.slog"));
+    logFrame(2, 200);
+    QVERIFY(logger.setStructuredOutput(QString()));
+    QVERIFY(logger.structuredOutput().isEmpty());
+
+    const auto first = readAll(path("first.slog"));
+    QCOMPARE(first.size(), 1);
+    QCOMPARE(first.at(0).message, QString("frame 1 took 100 us"));
+
+    const auto second = readAll(path("second.slog"));
+    QCOMPARE(second.size(), 1);
+    QCOMPARE(second.at(0).message, QString("frame 2 took 200 us"));
+    QCOMPARE(second.at(0).tag, QString("Render"));
+
+    // Without a file the site logs text again, also after a failed open
+    QStringList messages;
+    logger.setHandler([&messages](ILogger::Level, const QString&, const QString& message) {
+        messages.append(message);
+    });
+    logFrame(3, 300);
+    QVERIFY(logger.setStructuredOutput(path("third.slog")));
+    QVERIFY(!logger.setStructuredOutput(m_dir.path()));  // A directory
+    logFrame(4, 400);
+    QCOMPARE(messages, QStringList({"frame 3 took 300 us", "frame 4 took 400 us"}));
+
+    // Another logger hands out its own site IDs
+    Logger other;
+    QVERIFY(other.setStructuredOutput(path("other.slog")));
+    LoggerAccess::setInstance(&other);
+    logFrame(5, 500);
+    QVERIFY(other.setStructuredOutput(QString()));
+
+    const auto others = readAll(path("other.slog"));
+    QCOMPARE(others.size(), 1);
+    QCOMPARE(others.at(0).message, QString("frame 5 took 500 us"));
+}
+
+void TestStructuredLog::testTruncatedFile()
+{
+    {
+        Logger logger;
+        QVERIFY(logger.setStructuredOutput(path("truncated.slog")));
+        LoggerAccess::setInstance(&logger);
+        for (int i = 0; i < 10; ++i) {
+            MPF_SLOG_INFO("test", "entry {} {}", i, QString("payload"));
+        }
+    }
+
+    // As if the process died in the middle of writing the last entry
+    QFile file(path("truncated.slog"));
+    QVERIFY(file.open(QIODevice::ReadOnly));
+    const QByteArray data = file.readAll();
+
+    StructuredLogReader reader;
+    QVERIFY(reader.setData(data.left(data.size() - 5)));
+    StructuredLogReader::Entry entry;
+    int count = 0;
+    while (reader.readNext(&entry)) {
+        QCOMPARE(entry.message, QString("entry %1 payload").arg(count));
+        ++count;
+    }
+    QCOMPARE(count, 9);
+    QVERIFY(reader.errorString().isEmpty());
+
+    QVERIFY(!reader.setData("not a log"));
+    QVERIFY(!reader.errorString().isEmpty());
+}
+
+void TestStructuredLog::testSmallerThanText()
+{
+    Logger logger;
+    QVERIFY(logger.setStructuredOutput(path("size.slog")));
+    LoggerAccess::setInstance(&logger);
+    for (int i = 0; i < MessagesPerIteration; ++i) {
+        MPF_SLOG_DEBUG("Render", "frame {} took {} us", 100000 + i, 16000 + i);
+    }
+    QVERIFY(logger.setStructuredOutput(QString()));
+
+    // Same entries as the text log would have written them
+    qint64 textBytes = 0;
+    const auto entries = readAll(path("size.slog"));
+    QCOMPARE(entries.size(), MessagesPerIteration);
+    for (const auto& entry : entries) {
+        textBytes += StructuredLogReader::formatEntry(entry).toUtf8().size() + 1;
+    }
+
+    const qint64 binaryBytes = QFileInfo(path("size.slog")).size();
+    qDebug() << "text:" << textBytes << "bytes, structured:" << binaryBytes << "bytes";
+    QVERIFY(binaryBytes * 3 < textBytes);
+}
+
+void TestStructuredLog::benchmarkTextLog()
+{
+    // Baseline: format the message and the line on the calling thread
+    const QtMessageHandler previous = qInstallMessageHandler(discardMessages);
+    Logger logger;
+    logger.setFormat("[%date% %time%] [%level%] [%tag%] %message%");
+    LoggerAccess::setInstance(&logger);
+
+    int frame = 0;
+    QBENCHMARK {
+        for (int i = 0; i < MessagesPerIteration; ++i, ++frame) {
+            logger.info("Render", QString("frame %1 took %2 us").arg(frame).arg(16000 + i));
+        }
+    }
+    qInstallMessageHandler(previous);
+}
+
+void TestStructuredLog::benchmarkStructuredLog()
+{
+    Logger logger;
+    QVERIFY(logger.setStructuredOutput(path("benchmark.slog")));
+    LoggerAccess::setInstance(&logger);
+
+    int frame = 0;
+    QBENCHMARK {
+        for (int i = 0; i < MessagesPerIteration; ++i, ++frame) {
+            MPF_SLOG_INFO("Render", "frame {} took {} us", frame, 16000 + i);
+        }
+    }
+}
+
+QTEST_MAIN(TestStructuredLog)
+#include "test_structured_log.moc"